@@ -26,6 +26,10 @@
 #define ATLAS_EZO_RESPONSE_PENDING      254
 #define ATLAS_EZO_RESPONSE_NO_DATA      255
 
+/* Reading timing */
+#define ATLAS_EZO_READ_DELAY_MS         900     // Typical max conversion time for "R"
+#define ATLAS_EZO_RETRY_DELAY_MS        50      // Re-poll interval while device reports pending
+
 /* Sensor types */
 typedef enum {
     ATLAS_EZO_TYPE_PH,
@@ -35,6 +39,14 @@ typedef enum {
     ATLAS_EZO_TYPE_RTD
 } AtlasEZO_Type_t;
 
+/* Split-phase reading state */
+typedef enum {
+    ATLAS_EZO_STATE_IDLE,           // No conversion in flight
+    ATLAS_EZO_STATE_TRIGGERING,     // "R" queued on the bus
+    ATLAS_EZO_STATE_CONVERTING,     // "R" sent, waiting for result
+    ATLAS_EZO_STATE_COLLECTING      // Result read queued on the bus
+} AtlasEZO_State_t;
+
 /* Atlas EZO handle structure */
 typedef struct {
     I2C_HandleTypeDef *hi2c;
@@ -44,6 +56,12 @@ typedef struct {
     uint8_t response_len;
     uint8_t response_code;
 
+    // Non-blocking read state
+    AtlasEZO_State_t state;
+    uint32_t ready_tick;            // HAL tick when the result may be collected
+    uint8_t rx_buf[32];
+    bool new_data;
+
     // Parsed values (type-dependent)
     union {
         int32_t ph_x1000;           // pH * 1000 (e.g., 7123 = 7.123 pH)
@@ -82,8 +100,14 @@ bool AtlasEZO_GetLED(AtlasEZO_HandleTypeDef *ezo, bool *on);
 /* Factory reset */
 bool AtlasEZO_FactoryReset(AtlasEZO_HandleTypeDef *ezo);
 
-/* Reading */
+/* Reading - non-blocking (bus must be registered with I2CBus_Init) */
 bool AtlasEZO_TriggerReading(AtlasEZO_HandleTypeDef *ezo);
+bool AtlasEZO_CollectReading(AtlasEZO_HandleTypeDef *ezo);
+void AtlasEZO_Poll(AtlasEZO_HandleTypeDef *ezo);
+bool AtlasEZO_IsBusy(AtlasEZO_HandleTypeDef *ezo);
+bool AtlasEZO_HasNewData(AtlasEZO_HandleTypeDef *ezo);
+
+/* Reading - blocking (~900ms) */
 bool AtlasEZO_ReadValue(AtlasEZO_HandleTypeDef *ezo);
 
 /* Temperature compensation (for pH, EC, DO) */
@@ -43,6 +43,11 @@ typedef struct {
     uint8_t mtreg;
     uint16_t raw_value;
     uint32_t lux_x100;      // Lux * 100 for 0.01 lux resolution
+
+    // Asynchronous read state (see i2c_bus.h)
+    uint8_t rx_buf[2];
+    bool busy;
+    bool new_data;
 } BH1750_HandleTypeDef;
 
 /* Function prototypes */
@@ -57,6 +62,10 @@ bool BH1750_SetMTReg(BH1750_HandleTypeDef *bh, uint8_t mtreg);
 bool BH1750_TriggerMeasurement(BH1750_HandleTypeDef *bh);
 bool BH1750_ReadLight(BH1750_HandleTypeDef *bh);
 
+/* Asynchronous read (bus must be registered with I2CBus_Init) */
+bool BH1750_ReadLightAsync(BH1750_HandleTypeDef *bh);
+bool BH1750_HasNewData(BH1750_HandleTypeDef *bh);
+
 /* Get values */
 uint32_t BH1750_GetLux_x100(BH1750_HandleTypeDef *bh);
 uint16_t BH1750_GetLux(BH1750_HandleTypeDef *bh);
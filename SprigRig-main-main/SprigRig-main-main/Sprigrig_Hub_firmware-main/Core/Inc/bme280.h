@@ -110,6 +110,11 @@ typedef struct {
     int32_t temperature;    // °C * 100 (e.g., 2350 = 23.50°C)
     uint32_t pressure;      // Pa (e.g., 101325 = 1013.25 hPa)
     uint32_t humidity;      // %RH * 1024 (e.g., 51200 = 50.0%)
+
+    // Asynchronous read state (see i2c_bus.h)
+    uint8_t rx_buf[8];
+    bool busy;
+    bool new_data;
 } BME280_HandleTypeDef;
 
 /* Function prototypes */
@@ -125,6 +130,10 @@ bool BME280_ReadAll(BME280_HandleTypeDef *bme);
 bool BME280_TriggerMeasurement(BME280_HandleTypeDef *bme);
 bool BME280_IsMeasuring(BME280_HandleTypeDef *bme);
 
+/* Asynchronous read (bus must be registered with I2CBus_Init) */
+bool BME280_ReadAllAsync(BME280_HandleTypeDef *bme);
+bool BME280_HasNewData(BME280_HandleTypeDef *bme);
+
 /* Get compensated values */
 int16_t BME280_GetTemperature_x100(BME280_HandleTypeDef *bme);  // °C * 100
 uint16_t BME280_GetHumidity_x100(BME280_HandleTypeDef *bme);    // %RH * 100
@@ -137,6 +137,15 @@ typedef struct {
     // Gas measurement valid
     bool gas_valid;
     bool heat_stable;
+
+    // Register shadows for async triggering
+    uint8_t ctrl_meas;
+    uint8_t ctrl_gas_1;
+
+    // Asynchronous read state (see i2c_bus.h)
+    uint8_t rx_buf[15];
+    bool busy;
+    bool new_data;
 } BME680_HandleTypeDef;
 
 /* Function prototypes */
@@ -157,6 +166,11 @@ bool BME680_TriggerMeasurement(BME680_HandleTypeDef *bme, bool enable_gas);
 bool BME680_IsMeasuring(BME680_HandleTypeDef *bme);
 bool BME680_ReadAll(BME680_HandleTypeDef *bme);
 
+/* Asynchronous trigger/read (bus must be registered with I2CBus_Init) */
+bool BME680_TriggerMeasurementAsync(BME680_HandleTypeDef *bme, bool enable_gas);
+bool BME680_ReadAllAsync(BME680_HandleTypeDef *bme);
+bool BME680_HasNewData(BME680_HandleTypeDef *bme);
+
 /* Get compensated values */
 int16_t BME680_GetTemperature_x100(BME680_HandleTypeDef *bme);
 uint16_t BME680_GetHumidity_x100(BME680_HandleTypeDef *bme);
@@ -0,0 +1,41 @@
+/**
+ * Timing Diagnostics
+ * SprigRig Sensor Hub
+ *
+ * Cycle-accurate timing from the Cortex-M4 DWT cycle counter, and a
+ * min/avg/max accumulator shared by the scheduler, the I2C engine and
+ * Modbus. Results are exposed in the diagnostics register block.
+ */
+
+#ifndef __DIAG_H
+#define __DIAG_H
+
+#include "stm32g4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Current cycle count - wraps every ~25s at 170MHz, so only use it for
+   differences over shorter spans */
+#define DIAG_NOW()          (DWT->CYCCNT)
+
+/* Running min/avg/max of a duration */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t last_us;
+    uint64_t total_us;
+} Diag_Stat_t;
+
+/* Function prototypes */
+void Diag_Init(void);
+uint32_t Diag_CyclesToUs(uint32_t cycles);
+uint32_t Diag_Since(uint32_t start_cycles);
+
+void Diag_StatReset(Diag_Stat_t *stat);
+void Diag_StatAdd(Diag_Stat_t *stat, uint32_t us);
+uint32_t Diag_StatAvg(const Diag_Stat_t *stat);
+
+uint16_t Diag_Clamp16(uint32_t value);
+
+#endif /* __DIAG_H */
@@ -0,0 +1,46 @@
+/**
+ * Sample History Ring Buffer
+ * SprigRig Sensor Hub
+ *
+ * Keeps timestamped snapshots of the register block in RAM so the host
+ * can drain everything recorded during a bus outage in one burst with
+ * the Read History function code (0x41).
+ */
+
+#ifndef __HISTORY_H
+#define __HISTORY_H
+
+#include "stm32g4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Configuration */
+#define HISTORY_CAPACITY            256     // Records kept (~43 min at 10s)
+#define HISTORY_REG_COUNT           21      // Registers 0-20 per record
+#define HISTORY_INTERVAL_MS         10000   // Recording period
+
+/* Read History function code (user-defined range 65-72) */
+#define HISTORY_FC_READ             0x41
+
+/* Response layout */
+#define HISTORY_RECORD_SIZE         (4 + HISTORY_REG_COUNT * 2)    // Tick + registers
+#define HISTORY_HEADER_SIZE         15      // FC + ByteCount + FirstSeq + Count + NewestSeq + NowTick
+#define HISTORY_MAX_PER_RESPONSE    5       // Fits a 256-byte ADU
+
+/* One snapshot */
+typedef struct {
+    uint32_t tick;                          // HAL tick (ms since boot) at capture
+    uint16_t regs[HISTORY_REG_COUNT];
+} History_Record_t;
+
+/* Function prototypes */
+void History_Init(void);
+void History_Record(const uint16_t *regs);
+uint32_t History_GetNewestSeq(void);
+uint16_t History_GetCount(void);
+
+/* Modbus function handler for HISTORY_FC_READ */
+uint16_t History_HandleRead(const uint8_t *pdu, uint16_t pdu_len,
+                            uint8_t *resp, uint16_t resp_max);
+
+#endif /* __HISTORY_H */
@@ -0,0 +1,98 @@
+/**
+ * Asynchronous I2C Transaction Engine
+ * SprigRig Sensor Hub
+ *
+ * Queues I2C jobs per bus and runs them with the interrupt-driven HAL
+ * API, so drivers submit a transfer and return immediately. Completion
+ * callbacks run from I2CBus_Process() in main loop context, never from
+ * the ISR, so they may submit follow-up jobs and touch driver state.
+ */
+
+#ifndef __I2C_BUS_H
+#define __I2C_BUS_H
+
+#include "stm32g4xx_hal.h"
+#include "diag.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Configuration */
+#define I2C_BUS_MAX                 2       // I2C1 and I2C2
+#define I2C_BUS_QUEUE_SIZE          8       // Pending jobs per bus
+#define I2C_BUS_WRITE_MAX           16      // Max inline write payload (bytes)
+#define I2C_BUS_JOB_TIMEOUT_MS      25      // Stuck transfer -> peripheral reset
+
+/* Job types */
+typedef enum {
+    I2C_JOB_WRITE,          // Master transmit (command bytes)
+    I2C_JOB_READ,           // Master receive
+    I2C_JOB_MEM_WRITE,      // Register write (8-bit register address)
+    I2C_JOB_MEM_READ        // Register read (8-bit register address)
+} I2CBus_JobType_t;
+
+/* Completion callback - runs in main loop context */
+typedef void (*I2CBus_Callback)(void *context, bool success);
+
+/* Job descriptor */
+typedef struct {
+    I2CBus_JobType_t type;
+    uint8_t address;                        // 7-bit device address
+    uint8_t reg;                            // Register (MEM_* jobs only)
+    uint8_t *rx_data;                       // Read destination (caller-owned, must outlive the job)
+    uint8_t tx_data[I2C_BUS_WRITE_MAX];     // Write payload (copied on submit)
+    uint16_t length;
+    uint16_t delay_ms;                      // Minimum gap after the previous job completes
+    I2CBus_Callback callback;
+    void *context;
+} I2CBus_Job_t;
+
+/* Bus state */
+typedef enum {
+    I2C_BUS_IDLE,
+    I2C_BUS_BUSY,
+    I2C_BUS_DONE,
+    I2C_BUS_ERROR
+} I2CBus_State_t;
+
+/* Bus handle */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+
+    I2CBus_Job_t queue[I2C_BUS_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+
+    volatile I2CBus_State_t state;
+    uint32_t start_tick;
+    uint32_t last_complete_tick;
+    uint32_t start_cycles;                  // DIAG_NOW() at transfer start
+    volatile uint32_t done_cycles;          // DIAG_NOW() at completion interrupt
+
+    // Statistics
+    uint32_t job_count;
+    uint32_t error_count;
+    uint32_t timeout_count;
+    Diag_Stat_t transfer_time;              // Successful transfers, start to interrupt
+} I2CBus_HandleTypeDef;
+
+/* Function prototypes */
+I2CBus_HandleTypeDef* I2CBus_Init(I2C_HandleTypeDef *hi2c);
+I2CBus_HandleTypeDef* I2CBus_Get(I2C_HandleTypeDef *hi2c);
+void I2CBus_Process(void);
+
+bool I2CBus_Submit(I2CBus_HandleTypeDef *bus, const I2CBus_Job_t *job);
+bool I2CBus_Write(I2CBus_HandleTypeDef *bus, uint8_t address,
+                  const uint8_t *data, uint16_t len, uint16_t delay_ms,
+                  I2CBus_Callback callback, void *context);
+bool I2CBus_Read(I2CBus_HandleTypeDef *bus, uint8_t address,
+                 uint8_t *data, uint16_t len, uint16_t delay_ms,
+                 I2CBus_Callback callback, void *context);
+bool I2CBus_MemWrite(I2CBus_HandleTypeDef *bus, uint8_t address, uint8_t reg,
+                     uint8_t value, I2CBus_Callback callback, void *context);
+bool I2CBus_MemRead(I2CBus_HandleTypeDef *bus, uint8_t address, uint8_t reg,
+                    uint8_t *data, uint16_t len,
+                    I2CBus_Callback callback, void *context);
+
+uint8_t I2CBus_GetPending(I2CBus_HandleTypeDef *bus);
+
+#endif /* __I2C_BUS_H */
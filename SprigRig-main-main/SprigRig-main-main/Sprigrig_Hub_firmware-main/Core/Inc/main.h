@@ -14,7 +14,7 @@ extern "C" {
 
 /* Exported defines */
 
-// RS485 DE/RE Control - PA1 per netlist
+// RS485 DE/RE Control - PA1 per netlist (USART2_DE, AF7)
 #define RS485_DE_PORT       GPIOA
 #define RS485_DE_PIN        GPIO_PIN_1
 
@@ -93,8 +93,32 @@ extern "C" {
 #define REG_ATLAS_PH        18  // pH * 100
 #define REG_ATLAS_EC_HI     19  // EC uS/cm (High Word)
 #define REG_ATLAS_EC_LO     20  // EC uS/cm (Low Word)
-
-#define HOLDING_REG_COUNT   32
+#define REG_SAMPLE_SEQ      21  // Publish sequence (increments per consistent update, never 0 once running)
+#define REG_HIST_SEQ_HI     22  // Newest history record sequence (High Word)
+#define REG_HIST_SEQ_LO     23  // Newest history record sequence (Low Word)
+
+// Report-by-exception
+#define REG_CHANGE_MAP      24  // Bit n = channel n moved past its deadband (cleared when read)
+#define REG_DEADBAND_BASE   25  // 25-39: per-channel deadband, raw register units - writable
+#define CHANGE_CHANNEL_COUNT 15
+
+// Diagnostics (refreshed once per second, times saturate at 65535)
+#define REG_DIAG_LOOP_AVG_US    48  // SensorHub_Update() pass, mean us
+#define REG_DIAG_LOOP_MAX_US    49  // SensorHub_Update() pass, worst us
+#define REG_DIAG_JITTER_MAX_MS  50  // Worst task start delay past its due time
+#define REG_DIAG_MB_TURN_US     51  // Modbus turnaround, last reply us
+#define REG_DIAG_MB_TURN_MAX_US 52  // Modbus turnaround, worst us
+#define REG_DIAG_CRC_ERRORS     53  // Modbus frames failing CRC
+#define REG_DIAG_MB_OVERRUNS    54  // Modbus frames dropped
+#define REG_DIAG_I2C1_ERRORS    55  // I2C1 failed + timed-out transfers
+#define REG_DIAG_I2C2_ERRORS    56
+#define REG_DIAG_I2C1_MAX_US    57  // I2C1 transfer, worst us
+#define REG_DIAG_I2C2_MAX_US    58
+#define REG_DIAG_RESET          59  // Write 1 to clear all statistics - writable
+#define REG_DIAG_TASK_BASE      60  // 4 per task: min us, avg us, max us, overruns
+#define REG_DIAG_TASK_REGS      4
+
+#define HOLDING_REG_COUNT   96
 
 /* Exported functions */
 void Error_Handler(void);
@@ -7,6 +7,7 @@
 #define __MODBUS_H
 
 #include "stm32g4xx_hal.h"
+#include "diag.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -19,6 +20,25 @@
 #define MODBUS_FC_WRITE_SINGLE_REG      0x06
 #define MODBUS_FC_WRITE_MULTIPLE_COILS  0x0F
 #define MODBUS_FC_WRITE_MULTIPLE_REGS   0x10
+#define MODBUS_FC_READ_WRITE_MULTIPLE   0x17
+#define MODBUS_FC_ENCAPSULATED          0x2B
+
+/* Encapsulated interface (0x2B) MEI types */
+#define MODBUS_MEI_DEVICE_ID            0x0E
+
+/* Read Device ID codes and basic object IDs */
+#define MODBUS_DEVID_BASIC              0x01
+#define MODBUS_DEVID_SPECIFIC           0x04
+#define MODBUS_DEVID_OBJ_VENDOR         0x00
+#define MODBUS_DEVID_OBJ_PRODUCT        0x01
+#define MODBUS_DEVID_OBJ_REVISION       0x02
+#define MODBUS_DEVID_OBJ_COUNT          3
+#define MODBUS_DEVID_CONFORMITY         0x81    /* Basic objects, stream and individual access */
+
+/* Per-request quantity limits (spec maximums for a 256-byte ADU) */
+#define MODBUS_MAX_READ_REGS            125
+#define MODBUS_MAX_WRITE_REGS           123
+#define MODBUS_MAX_RW_WRITE_REGS        121
 
 /* Modbus Exception Codes */
 #define MODBUS_EX_ILLEGAL_FUNCTION      0x01
@@ -29,20 +49,37 @@
 /* Buffer sizes */
 #define MODBUS_RX_BUFFER_SIZE           256
 #define MODBUS_TX_BUFFER_SIZE           256
+#define MODBUS_RX_DMA_SIZE              256     // Circular DMA ring
 
-/* Timing (3.5 character times at 9600 baud = ~4ms) */
-#define MODBUS_FRAME_TIMEOUT_MS         5
+/* Frame timing (t3.5 inter-frame gap, detected by the USART receiver timeout)
+ * Up to 19200 baud: 3.5 characters of 11 bits. Above: fixed 1750us per spec. */
+#define MODBUS_T35_BITS                 39
+#define MODBUS_T35_FIXED_BAUD           19200
+#define MODBUS_T35_FIXED_US             1750
 
 /* Write callback function type */
 typedef void (*Modbus_WriteCallback)(uint16_t reg_addr, uint16_t value);
 
+/* Writable check function type - true if the master may write reg_addr */
+typedef bool (*Modbus_WritableCallback)(uint16_t reg_addr);
+
+/* Read callback function type - called after a register range has been
+ * copied into a reply (e.g. clear-on-read registers) */
+typedef void (*Modbus_ReadCallback)(uint16_t start_addr, uint16_t quantity);
+
+/* Application function code handler
+ * pdu/pdu_len: request PDU (function code onwards, no address or CRC)
+ * resp/resp_max: response PDU buffer (function code onwards)
+ * Returns response PDU length, or 0 to answer with an illegal value exception */
+typedef uint16_t (*Modbus_FunctionHandler)(const uint8_t *pdu, uint16_t pdu_len,
+                                           uint8_t *resp, uint16_t resp_max);
+
 /* Modbus context structure */
 typedef struct {
-    UART_HandleTypeDef *huart;
-    GPIO_TypeDef *de_port;
-    uint16_t de_pin;
+    UART_HandleTypeDef *huart;          // RS485 DE driven by the USART (HAL_RS485Ex_Init)
 
     uint8_t slave_address;
+    bool broadcast;                     // Frame in progress was sent to address 0
 
     uint16_t *holding_registers;
     uint16_t holding_reg_count;
@@ -50,25 +87,52 @@ typedef struct {
     uint8_t rx_buffer[MODBUS_RX_BUFFER_SIZE];
     uint8_t tx_buffer[MODBUS_TX_BUFFER_SIZE];
 
+    // Circular DMA receive (written by hardware, framed in Modbus_IRQHandler)
+    uint8_t rx_dma_buffer[MODBUS_RX_DMA_SIZE];
+    uint16_t rx_dma_tail;               // Ring position of the next unframed byte
+    uint32_t rx_timeout_bits;           // t3.5 in bit times at the configured baud
+
     volatile uint16_t rx_index;
-    volatile uint32_t last_rx_time;
     volatile bool frame_ready;
+    uint32_t overrun_count;             // Frames dropped while the last was unprocessed
+
+    uint32_t crc_error_count;           // Frames for us that failed the CRC check
+    CRC_HandleTypeDef *hcrc;            // CRC unit once self-tested, NULL = table
+
+    // Turnaround: end-of-frame interrupt to reply start (DWT cycle counter)
+    uint32_t frame_cycles;              // DIAG_NOW() when the frame was framed
+    Diag_Stat_t turnaround;
 
     Modbus_WriteCallback write_callback;
+    Modbus_WritableCallback writable_callback;
+    Modbus_ReadCallback read_callback;
+
+    // Application-defined function code (e.g. history readout)
+    uint8_t custom_function;
+    Modbus_FunctionHandler custom_handler;
+
+    // Read Device Identification (0x2B/0x0E) objects
+    const char *device_id[MODBUS_DEVID_OBJ_COUNT];
 } Modbus_HandleTypeDef;
 
 /* Function prototypes */
 void Modbus_Init(Modbus_HandleTypeDef *mb, UART_HandleTypeDef *huart,
-                 GPIO_TypeDef *de_port, uint16_t de_pin,
                  uint8_t slave_address,
                  uint16_t *holding_regs, uint16_t reg_count);
 
-void Modbus_Poll(Modbus_HandleTypeDef *mb);
-void Modbus_RxCallback(Modbus_HandleTypeDef *mb, uint8_t data);
-void Modbus_TimerCallback(Modbus_HandleTypeDef *mb);
+void Modbus_Process(Modbus_HandleTypeDef *mb);
+void Modbus_IRQHandler(Modbus_HandleTypeDef *mb);
+bool Modbus_IsTransmitting(Modbus_HandleTypeDef *mb);
 void Modbus_SetWriteCallback(Modbus_HandleTypeDef *mb, Modbus_WriteCallback callback);
+void Modbus_SetWritableCallback(Modbus_HandleTypeDef *mb, Modbus_WritableCallback callback);
+void Modbus_SetReadCallback(Modbus_HandleTypeDef *mb, Modbus_ReadCallback callback);
+void Modbus_SetFunctionHandler(Modbus_HandleTypeDef *mb, uint8_t function,
+                               Modbus_FunctionHandler handler);
+void Modbus_SetDeviceId(Modbus_HandleTypeDef *mb, const char *vendor,
+                        const char *product, const char *revision);
 
 /* CRC functions */
 uint16_t Modbus_CRC16(uint8_t *data, uint16_t length);
+bool Modbus_UseCRCUnit(Modbus_HandleTypeDef *mb, CRC_HandleTypeDef *hcrc);
 
 #endif /* __MODBUS_H */
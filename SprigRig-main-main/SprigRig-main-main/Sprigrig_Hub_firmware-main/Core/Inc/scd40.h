@@ -10,6 +10,7 @@
 #define __SCD40_H
 
 #include "stm32g4xx_hal.h"
+#include "i2c_bus.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -53,6 +54,13 @@ typedef struct {
     uint16_t co2_ppm;           // CO2 in ppm
     int16_t temperature_x100;   // Temperature in °C * 100
     uint16_t humidity_x100;     // Relative humidity in %RH * 100
+
+    // Asynchronous read state (see i2c_bus.h)
+    uint8_t rx_buf[9];
+    uint8_t rx_words;               // Response length for the pending command
+    I2CBus_Callback rx_callback;    // Completion for the pending response read
+    bool busy;
+    bool new_data;
 } SCD40_HandleTypeDef;
 
 /* Function prototypes */
@@ -65,6 +73,10 @@ bool SCD40_MeasureSingleShot(SCD40_HandleTypeDef *scd);
 bool SCD40_IsDataReady(SCD40_HandleTypeDef *scd);
 bool SCD40_ReadMeasurement(SCD40_HandleTypeDef *scd);
 
+/* Asynchronous read (bus must be registered with I2CBus_Init) */
+bool SCD40_ReadMeasurementAsync(SCD40_HandleTypeDef *scd);
+bool SCD40_HasNewData(SCD40_HandleTypeDef *scd);
+
 bool SCD40_SetTemperatureOffset(SCD40_HandleTypeDef *scd, uint16_t offset_x100);
 bool SCD40_GetTemperatureOffset(SCD40_HandleTypeDef *scd, uint16_t *offset_x100);
 bool SCD40_SetSensorAltitude(SCD40_HandleTypeDef *scd, uint16_t altitude_m);
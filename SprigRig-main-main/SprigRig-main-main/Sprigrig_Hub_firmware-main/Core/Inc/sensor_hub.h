@@ -7,6 +7,8 @@
 #define __SENSOR_HUB_H
 
 #include "stm32g4xx_hal.h"
+#include "modbus.h"
+#include "diag.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -20,18 +22,50 @@ typedef enum {
     CHANNEL_DIGITAL
 } ChannelType_t;
 
+/* Scheduled sensor tasks */
+typedef enum {
+    SENSOR_TASK_ANALOG = 0,     // 4-20mA / 0-10V inputs
+    SENSOR_TASK_DIGITAL,        // Digital inputs
+    SENSOR_TASK_BME280_1,       // BME280 on I2C1
+    SENSOR_TASK_BME280_2,       // BME280 on I2C2
+    SENSOR_TASK_BH1750,         // Light sensor
+    SENSOR_TASK_SCD40,          // CO2 sensor
+    SENSOR_TASK_ATLAS,          // Atlas EZO pH/EC trigger/collect
+    SENSOR_TASK_HISTORY,        // Snapshot registers into the history ring
+    SENSOR_TASK_DIAG,           // Refresh the diagnostics register block
+    SENSOR_TASK_COUNT
+} SensorTask_Id_t;
+
+/* Task table entry */
+typedef struct {
+    void (*run)(void);
+    uint32_t period_ms;         // Interval between runs
+    uint32_t deadline_ms;       // Execution budget per run
+    uint32_t next_due;          // HAL tick of next run
+    bool enabled;               // False if the sensor was not detected
+
+    // Statistics
+    Diag_Stat_t exec;           // Execution time per run (count = runs)
+    uint32_t late_max_ms;       // Worst start delay past next_due (jitter)
+    uint32_t overruns;          // Runs that exceeded deadline_ms
+} SensorTask_t;
+
 /* Sensor Hub configuration */
 typedef struct {
     ADC_HandleTypeDef *hadc;
+    TIM_HandleTypeDef *htim_adc;    // Trigger timer for the ADC scan
     DAC_HandleTypeDef *hdac;
     I2C_HandleTypeDef *hi2c1;
     I2C_HandleTypeDef *hi2c2;
     SPI_HandleTypeDef *hspi2;
+    Modbus_HandleTypeDef *modbus;   // Link statistics for the diagnostics block
 } SensorHub_Config_t;
 
 /* Function prototypes */
 void SensorHub_Init(SensorHub_Config_t *config);
 void SensorHub_Update(void);
+const SensorTask_t* SensorHub_GetTask(SensorTask_Id_t id);
+void SensorHub_ResetDiagnostics(void);
 
 uint8_t SensorHub_ReadAddress(void);
 uint16_t SensorHub_ReadADC_4_20mA(uint8_t channel);
@@ -40,10 +74,13 @@ uint8_t SensorHub_ReadDigitalInputs(void);
 
 uint16_t* SensorHub_GetRegisters(void);
 uint16_t SensorHub_GetRegisterCount(void);
+const char* SensorHub_GetRevision(void);
 
 /* Analog output functions (0-10V) */
 void SensorHub_SetAnalogOutput(uint8_t channel, uint16_t value);
+bool SensorHub_IsRegisterWritable(uint16_t reg_addr);
 void SensorHub_OnRegisterWrite(uint16_t reg_addr, uint16_t value);
+void SensorHub_OnRegisterRead(uint16_t start_addr, uint16_t quantity);
 
 /* Conversion helpers */
 uint16_t SensorHub_ConvertCurrent_mA_x100(uint16_t adc_value);  // Returns mA * 100
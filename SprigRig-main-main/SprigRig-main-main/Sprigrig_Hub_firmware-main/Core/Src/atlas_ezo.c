@@ -4,6 +4,7 @@
  */
 
 #include "atlas_ezo.h"
+#include "i2c_bus.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -11,6 +12,9 @@
 /* Private function prototypes */
 static bool AtlasEZO_ParseResponse(AtlasEZO_HandleTypeDef *ezo);
 static int32_t AtlasEZO_ParseFloat_x1000(const char *str);
+static bool AtlasEZO_StoreResponse(AtlasEZO_HandleTypeDef *ezo, const uint8_t *buf);
+static void AtlasEZO_TriggerDone(void *context, bool success);
+static void AtlasEZO_CollectDone(void *context, bool success);
 
 /**
  * Parse float string to integer * 1000
@@ -127,6 +131,9 @@ bool AtlasEZO_Init(AtlasEZO_HandleTypeDef *ezo, I2C_HandleTypeDef *hi2c,
     ezo->type = type;
     ezo->response_len = 0;
     ezo->response_code = 0;
+    ezo->state = ATLAS_EZO_STATE_IDLE;
+    ezo->ready_tick = 0;
+    ezo->new_data = false;
     memset(ezo->response, 0, sizeof(ezo->response));
 
     // Wake the device (in case it's sleeping)
@@ -157,6 +164,13 @@ bool AtlasEZO_ReadResponse(AtlasEZO_HandleTypeDef *ezo) {
         return false;
     }
 
+    return AtlasEZO_StoreResponse(ezo, buf);
+}
+
+/**
+ * Store response code and string from a raw 32-byte read
+ */
+static bool AtlasEZO_StoreResponse(AtlasEZO_HandleTypeDef *ezo, const uint8_t *buf) {
     ezo->response_code = buf[0];
 
     if (ezo->response_code == ATLAS_EZO_RESPONSE_SUCCESS) {
@@ -286,14 +300,118 @@ bool AtlasEZO_FactoryReset(AtlasEZO_HandleTypeDef *ezo) {
 }
 
 /**
- * Trigger a reading
+ * Trigger a reading (non-blocking)
+ * Queues "R" on the bus and returns immediately. Collect the result with
+ * AtlasEZO_CollectReading() once ATLAS_EZO_READ_DELAY_MS has elapsed.
  */
 bool AtlasEZO_TriggerReading(AtlasEZO_HandleTypeDef *ezo) {
-    return AtlasEZO_SendCommand(ezo, "R");
+    if (ezo->state != ATLAS_EZO_STATE_IDLE) {
+        return false;
+    }
+
+    if (!I2CBus_Write(I2CBus_Get(ezo->hi2c), ezo->address, (const uint8_t *)"R", 1,
+                      0, AtlasEZO_TriggerDone, ezo)) {
+        return false;
+    }
+
+    ezo->state = ATLAS_EZO_STATE_TRIGGERING;
+    return true;
+}
+
+/**
+ * Trigger write completion - start the conversion timer
+ */
+static void AtlasEZO_TriggerDone(void *context, bool success) {
+    AtlasEZO_HandleTypeDef *ezo = (AtlasEZO_HandleTypeDef *)context;
+
+    if (success) {
+        ezo->state = ATLAS_EZO_STATE_CONVERTING;
+        ezo->ready_tick = HAL_GetTick() + ATLAS_EZO_READ_DELAY_MS;
+    } else {
+        ezo->state = ATLAS_EZO_STATE_IDLE;
+    }
+}
+
+/**
+ * Collect a triggered reading (non-blocking)
+ * Queues the result read once the conversion is due. Returns true if a
+ * read was queued; check for the parsed value with AtlasEZO_HasNewData().
+ */
+bool AtlasEZO_CollectReading(AtlasEZO_HandleTypeDef *ezo) {
+    if (ezo->state != ATLAS_EZO_STATE_CONVERTING) {
+        return false;
+    }
+
+    // Signed difference handles tick wraparound
+    if ((int32_t)(HAL_GetTick() - ezo->ready_tick) < 0) {
+        return false;
+    }
+
+    if (!I2CBus_Read(I2CBus_Get(ezo->hi2c), ezo->address, ezo->rx_buf, sizeof(ezo->rx_buf),
+                     0, AtlasEZO_CollectDone, ezo)) {
+        return false;
+    }
+
+    ezo->state = ATLAS_EZO_STATE_COLLECTING;
+    return true;
+}
+
+/**
+ * Result read completion
+ * Re-polls on the pending response code; on error the state returns to
+ * idle so the next poll re-triggers.
+ */
+static void AtlasEZO_CollectDone(void *context, bool success) {
+    AtlasEZO_HandleTypeDef *ezo = (AtlasEZO_HandleTypeDef *)context;
+
+    if (success && !AtlasEZO_StoreResponse(ezo, ezo->rx_buf) &&
+        ezo->response_code == ATLAS_EZO_RESPONSE_PENDING) {
+        // Still converting, check back shortly
+        ezo->state = ATLAS_EZO_STATE_CONVERTING;
+        ezo->ready_tick = HAL_GetTick() + ATLAS_EZO_RETRY_DELAY_MS;
+        return;
+    }
+
+    ezo->state = ATLAS_EZO_STATE_IDLE;
+
+    if (success && AtlasEZO_ParseResponse(ezo)) {
+        ezo->new_data = true;
+    }
+}
+
+/**
+ * Drive the trigger/collect cycle - call regularly from the main loop
+ * Triggers a new reading when idle and collects it when due.
+ * Never blocks; check for results with AtlasEZO_HasNewData().
+ */
+void AtlasEZO_Poll(AtlasEZO_HandleTypeDef *ezo) {
+    if (ezo->state == ATLAS_EZO_STATE_IDLE) {
+        AtlasEZO_TriggerReading(ezo);
+    } else {
+        AtlasEZO_CollectReading(ezo);
+    }
+}
+
+/**
+ * Check if a reading is in flight
+ * Blocking commands must not be sent while busy or they abort the reading.
+ */
+bool AtlasEZO_IsBusy(AtlasEZO_HandleTypeDef *ezo) {
+    return ezo->state != ATLAS_EZO_STATE_IDLE;
+}
+
+/**
+ * Check for (and consume) a completed non-blocking reading
+ */
+bool AtlasEZO_HasNewData(AtlasEZO_HandleTypeDef *ezo) {
+    bool ready = ezo->new_data;
+    ezo->new_data = false;
+    return ready;
 }
 
 /**
- * Read and parse value
+ * Read and parse value (blocking)
+ * For setup/calibration code before the bus is handed to I2CBus.
  */
 bool AtlasEZO_ReadValue(AtlasEZO_HandleTypeDef *ezo) {
     // Trigger reading
@@ -302,7 +420,7 @@ bool AtlasEZO_ReadValue(AtlasEZO_HandleTypeDef *ezo) {
     }
 
     // Wait for reading to complete (900ms is typical max)
-    HAL_Delay(900);
+    HAL_Delay(ATLAS_EZO_READ_DELAY_MS);
 
     // Read response
     if (!AtlasEZO_ReadResponse(ezo)) {
@@ -4,10 +4,13 @@
  */
 
 #include "bh1750.h"
+#include "i2c_bus.h"
 
 /* Private function prototypes */
 static bool BH1750_WriteCmd(BH1750_HandleTypeDef *bh, uint8_t cmd);
 static bool BH1750_ReadData(BH1750_HandleTypeDef *bh, uint8_t *data, uint16_t len);
+static void BH1750_ConvertRaw(BH1750_HandleTypeDef *bh, const uint8_t *data);
+static void BH1750_ReadLightDone(void *context, bool success);
 
 /**
  * Write command to sensor
@@ -33,6 +36,8 @@ bool BH1750_Init(BH1750_HandleTypeDef *bh, I2C_HandleTypeDef *hi2c, uint8_t addr
     bh->mtreg = BH1750_MTREG_DEFAULT;
     bh->raw_value = 0;
     bh->lux_x100 = 0;
+    bh->busy = false;
+    bh->new_data = false;
 
     // Power on
     if (!BH1750_PowerOn(bh)) {
@@ -146,6 +151,54 @@ bool BH1750_ReadLight(BH1750_HandleTypeDef *bh) {
         return false;
     }
 
+    BH1750_ConvertRaw(bh, data);
+    return true;
+}
+
+/**
+ * Start reading light measurement without blocking
+ * Check for the result with BH1750_HasNewData().
+ */
+bool BH1750_ReadLightAsync(BH1750_HandleTypeDef *bh) {
+    if (bh->busy) {
+        return false;
+    }
+
+    if (!I2CBus_Read(I2CBus_Get(bh->hi2c), bh->address, bh->rx_buf, sizeof(bh->rx_buf),
+                     0, BH1750_ReadLightDone, bh)) {
+        return false;
+    }
+
+    bh->busy = true;
+    return true;
+}
+
+/**
+ * Async read completion
+ */
+static void BH1750_ReadLightDone(void *context, bool success) {
+    BH1750_HandleTypeDef *bh = (BH1750_HandleTypeDef *)context;
+    bh->busy = false;
+
+    if (success) {
+        BH1750_ConvertRaw(bh, bh->rx_buf);
+        bh->new_data = true;
+    }
+}
+
+/**
+ * Check for (and consume) a completed async reading
+ */
+bool BH1750_HasNewData(BH1750_HandleTypeDef *bh) {
+    bool ready = bh->new_data;
+    bh->new_data = false;
+    return ready;
+}
+
+/**
+ * Convert raw measurement bytes to lux
+ */
+static void BH1750_ConvertRaw(BH1750_HandleTypeDef *bh, const uint8_t *data) {
     // Raw value is 16-bit big-endian
     bh->raw_value = ((uint16_t)data[0] << 8) | data[1];
 
@@ -168,8 +221,6 @@ bool BH1750_ReadLight(BH1750_HandleTypeDef *bh) {
     }
 
     bh->lux_x100 = lux_x100;
-
-    return true;
 }
 
 /**
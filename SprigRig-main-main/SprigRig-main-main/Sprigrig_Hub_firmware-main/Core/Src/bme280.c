@@ -4,12 +4,15 @@
  */
 
 #include "bme280.h"
+#include "i2c_bus.h"
 
 /* Private function prototypes */
 static bool BME280_ReadCalibration(BME280_HandleTypeDef *bme);
 static int32_t BME280_CompensateTemp(BME280_HandleTypeDef *bme, int32_t adc_T);
 static uint32_t BME280_CompensatePress(BME280_HandleTypeDef *bme, int32_t adc_P);
 static uint32_t BME280_CompensateHum(BME280_HandleTypeDef *bme, int32_t adc_H);
+static void BME280_ParseData(BME280_HandleTypeDef *bme, const uint8_t *data);
+static void BME280_ReadAllDone(void *context, bool success);
 
 /**
  * Read single register
@@ -42,6 +45,8 @@ bool BME280_Init(BME280_HandleTypeDef *bme, I2C_HandleTypeDef *hi2c, uint8_t add
     bme->hi2c = hi2c;
     bme->address = address;
     bme->t_fine = 0;
+    bme->busy = false;
+    bme->new_data = false;
 
     // Check chip ID
     uint8_t id;
@@ -200,6 +205,54 @@ bool BME280_ReadAll(BME280_HandleTypeDef *bme) {
         return false;
     }
 
+    BME280_ParseData(bme, data);
+    return true;
+}
+
+/**
+ * Start reading all data registers without blocking
+ * Result is compensated on completion; check with BME280_HasNewData().
+ */
+bool BME280_ReadAllAsync(BME280_HandleTypeDef *bme) {
+    if (bme->busy) {
+        return false;
+    }
+
+    if (!I2CBus_MemRead(I2CBus_Get(bme->hi2c), bme->address, BME280_REG_PRESS_MSB,
+                        bme->rx_buf, sizeof(bme->rx_buf), BME280_ReadAllDone, bme)) {
+        return false;
+    }
+
+    bme->busy = true;
+    return true;
+}
+
+/**
+ * Async read completion
+ */
+static void BME280_ReadAllDone(void *context, bool success) {
+    BME280_HandleTypeDef *bme = (BME280_HandleTypeDef *)context;
+    bme->busy = false;
+
+    if (success) {
+        BME280_ParseData(bme, bme->rx_buf);
+        bme->new_data = true;
+    }
+}
+
+/**
+ * Check for (and consume) a completed async reading
+ */
+bool BME280_HasNewData(BME280_HandleTypeDef *bme) {
+    bool ready = bme->new_data;
+    bme->new_data = false;
+    return ready;
+}
+
+/**
+ * Parse and compensate raw data registers (0xF7 - 0xFE)
+ */
+static void BME280_ParseData(BME280_HandleTypeDef *bme, const uint8_t *data) {
     // Parse raw values (20-bit pressure/temp, 16-bit humidity)
     bme->raw_press = ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) | (data[2] >> 4);
     bme->raw_temp = ((int32_t)data[3] << 12) | ((int32_t)data[4] << 4) | (data[5] >> 4);
@@ -209,8 +262,6 @@ bool BME280_ReadAll(BME280_HandleTypeDef *bme) {
     bme->temperature = BME280_CompensateTemp(bme, bme->raw_temp);
     bme->pressure = BME280_CompensatePress(bme, bme->raw_press);
     bme->humidity = BME280_CompensateHum(bme, bme->raw_hum);
-
-    return true;
 }
 
 /**
@@ -4,6 +4,7 @@
  */
 
 #include "bme680.h"
+#include "i2c_bus.h"
 
 /* Lookup table for gas range */
 static const uint32_t gas_range_lookup1[16] = {
@@ -31,6 +32,8 @@ static uint32_t BME680_CompensateHum(BME680_HandleTypeDef *bme, int32_t adc_H);
 static uint32_t BME680_CompensateGas(BME680_HandleTypeDef *bme, uint16_t gas_adc, uint8_t gas_range);
 static uint8_t BME680_CalcHeaterRes(BME680_HandleTypeDef *bme, uint16_t target_temp);
 static uint8_t BME680_CalcHeaterDur(uint16_t duration_ms);
+static bool BME680_ParseData(BME680_HandleTypeDef *bme, const uint8_t *data);
+static void BME680_ReadAllDone(void *context, bool success);
 
 /**
  * Read single register
@@ -65,6 +68,10 @@ bool BME680_Init(BME680_HandleTypeDef *bme, I2C_HandleTypeDef *hi2c, uint8_t add
     bme->t_fine = 0;
     bme->gas_valid = false;
     bme->heat_stable = false;
+    bme->ctrl_meas = 0;
+    bme->ctrl_gas_1 = 0;
+    bme->busy = false;
+    bme->new_data = false;
 
     // Check chip ID
     uint8_t id;
@@ -200,6 +207,7 @@ bool BME680_Configure(BME680_HandleTypeDef *bme,
     if (!BME680_WriteReg(bme, BME680_REG_CTRL_MEAS, ctrl_meas)) {
         return false;
     }
+    bme->ctrl_meas = ctrl_meas;
 
     return true;
 }
@@ -276,6 +284,7 @@ bool BME680_ConfigureGasHeater(BME680_HandleTypeDef *bme,
     if (!BME680_WriteReg(bme, BME680_REG_CTRL_GAS_1, ctrl_gas_1)) {
         return false;
     }
+    bme->ctrl_gas_1 = ctrl_gas_1;
 
     return true;
 }
@@ -333,6 +342,70 @@ bool BME680_ReadAll(BME680_HandleTypeDef *bme) {
         return false;
     }
 
+    return BME680_ParseData(bme, data);
+}
+
+/**
+ * Trigger forced-mode measurement without blocking
+ * Uses the oversampling/heater settings cached by Configure/ConfigureGasHeater.
+ * Allow for the measurement (and heater) time before BME680_ReadAllAsync().
+ */
+bool BME680_TriggerMeasurementAsync(BME680_HandleTypeDef *bme, bool enable_gas) {
+    I2CBus_HandleTypeDef *bus = I2CBus_Get(bme->hi2c);
+
+    uint8_t ctrl_gas_1 = enable_gas ? (bme->ctrl_gas_1 | 0x10) : (bme->ctrl_gas_1 & ~0x10);
+    if (!I2CBus_MemWrite(bus, bme->address, BME680_REG_CTRL_GAS_1, ctrl_gas_1, NULL, NULL)) {
+        return false;
+    }
+
+    uint8_t ctrl_meas = (bme->ctrl_meas & 0xFC) | BME680_MODE_FORCED;
+    return I2CBus_MemWrite(bus, bme->address, BME680_REG_CTRL_MEAS, ctrl_meas, NULL, NULL);
+}
+
+/**
+ * Start reading all measurement registers without blocking
+ * Check for the result with BME680_HasNewData().
+ */
+bool BME680_ReadAllAsync(BME680_HandleTypeDef *bme) {
+    if (bme->busy) {
+        return false;
+    }
+
+    if (!I2CBus_MemRead(I2CBus_Get(bme->hi2c), bme->address, BME680_REG_MEAS_STATUS,
+                        bme->rx_buf, sizeof(bme->rx_buf), BME680_ReadAllDone, bme)) {
+        return false;
+    }
+
+    bme->busy = true;
+    return true;
+}
+
+/**
+ * Async read completion
+ */
+static void BME680_ReadAllDone(void *context, bool success) {
+    BME680_HandleTypeDef *bme = (BME680_HandleTypeDef *)context;
+    bme->busy = false;
+
+    if (success && BME680_ParseData(bme, bme->rx_buf)) {
+        bme->new_data = true;
+    }
+}
+
+/**
+ * Check for (and consume) a completed async reading
+ */
+bool BME680_HasNewData(BME680_HandleTypeDef *bme) {
+    bool ready = bme->new_data;
+    bme->new_data = false;
+    return ready;
+}
+
+/**
+ * Parse and compensate measurement registers (0x1D - 0x2B)
+ * Returns false if the sensor reports no new data
+ */
+static bool BME680_ParseData(BME680_HandleTypeDef *bme, const uint8_t *data) {
     // Check if new data is available
     if ((data[0] & 0x80) == 0) {
         return false;  // No new data
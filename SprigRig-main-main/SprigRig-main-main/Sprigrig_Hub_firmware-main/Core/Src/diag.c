@@ -0,0 +1,81 @@
+/**
+ * Timing Diagnostics
+ * SprigRig Sensor Hub
+ */
+
+#include "diag.h"
+
+/* Private variables */
+static uint32_t cycles_per_us = 1;
+
+/**
+ * Start the DWT cycle counter
+ * Call after SystemClock_Config() so the µs conversion uses the final clock.
+ */
+void Diag_Init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    cycles_per_us = SystemCoreClock / 1000000;
+    if (cycles_per_us == 0) {
+        cycles_per_us = 1;
+    }
+}
+
+/**
+ * Convert a cycle count to microseconds
+ */
+uint32_t Diag_CyclesToUs(uint32_t cycles) {
+    return cycles / cycles_per_us;
+}
+
+/**
+ * Microseconds elapsed since a DIAG_NOW() timestamp
+ */
+uint32_t Diag_Since(uint32_t start_cycles) {
+    return Diag_CyclesToUs(DIAG_NOW() - start_cycles);
+}
+
+/**
+ * Clear an accumulator
+ */
+void Diag_StatReset(Diag_Stat_t *stat) {
+    stat->count = 0;
+    stat->min_us = UINT32_MAX;
+    stat->max_us = 0;
+    stat->last_us = 0;
+    stat->total_us = 0;
+}
+
+/**
+ * Add one measurement
+ */
+void Diag_StatAdd(Diag_Stat_t *stat, uint32_t us) {
+    stat->count++;
+    stat->last_us = us;
+    stat->total_us += us;
+    if (us < stat->min_us) {
+        stat->min_us = us;
+    }
+    if (us > stat->max_us) {
+        stat->max_us = us;
+    }
+}
+
+/**
+ * Mean of all measurements (0 if none)
+ */
+uint32_t Diag_StatAvg(const Diag_Stat_t *stat) {
+    if (stat->count == 0) {
+        return 0;
+    }
+    return (uint32_t)(stat->total_us / stat->count);
+}
+
+/**
+ * Saturate a value to a 16-bit register
+ */
+uint16_t Diag_Clamp16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
@@ -0,0 +1,139 @@
+/**
+ * Sample History Ring Buffer
+ * SprigRig Sensor Hub
+ */
+
+#include "history.h"
+#include <string.h>
+
+/* Private variables */
+static History_Record_t records[HISTORY_CAPACITY];
+static uint32_t next_seq;       // Sequence number of the next record (first is 1)
+static uint16_t count;
+
+/* Private function prototypes */
+static void History_PutU32(uint8_t *buf, uint32_t value);
+
+/**
+ * Clear the history
+ */
+void History_Init(void) {
+    memset(records, 0, sizeof(records));
+    next_seq = 1;
+    count = 0;
+}
+
+/**
+ * Append a snapshot of registers 0..HISTORY_REG_COUNT-1
+ * Overwrites the oldest record once full. Masks interrupts so a readout
+ * running from PendSV never sees a half-written record.
+ */
+void History_Record(const uint16_t *regs) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    History_Record_t *rec = &records[next_seq % HISTORY_CAPACITY];
+
+    rec->tick = HAL_GetTick();
+    memcpy(rec->regs, regs, sizeof(rec->regs));
+
+    next_seq++;
+    if (count < HISTORY_CAPACITY) {
+        count++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Sequence number of the newest record (0 if empty)
+ */
+uint32_t History_GetNewestSeq(void) {
+    return count ? next_seq - 1 : 0;
+}
+
+/**
+ * Number of records held
+ */
+uint16_t History_GetCount(void) {
+    return count;
+}
+
+/**
+ * Handle Read History (0x41)
+ * Request PDU:  FC(1) + StartSeq(4) + MaxCount(1)
+ * Response PDU: FC(1) + ByteCount(1) + FirstSeq(4) + Count(1) + NewestSeq(4)
+ *               + NowTick(4) + Count * [Tick(4) + Regs(2 * HISTORY_REG_COUNT)]
+ * A StartSeq older than the oldest retained record is served from the
+ * oldest one; FirstSeq tells the host where the returned run begins.
+ * Returns the response PDU length, or 0 for an illegal data value.
+ */
+uint16_t History_HandleRead(const uint8_t *pdu, uint16_t pdu_len,
+                            uint8_t *resp, uint16_t resp_max) {
+    if (pdu_len < 6) {
+        return 0;
+    }
+
+    uint32_t start = ((uint32_t)pdu[1] << 24) | ((uint32_t)pdu[2] << 16) |
+                     ((uint32_t)pdu[3] << 8) | pdu[4];
+    uint8_t max_count = pdu[5];
+
+    if (max_count == 0) {
+        return 0;
+    }
+
+    uint16_t room = (resp_max - HISTORY_HEADER_SIZE) / HISTORY_RECORD_SIZE;
+    if (max_count > room) {
+        max_count = room;
+    }
+    if (max_count > HISTORY_MAX_PER_RESPONSE) {
+        max_count = HISTORY_MAX_PER_RESPONSE;
+    }
+
+    uint32_t oldest = next_seq - count;
+    if (start < oldest) {
+        start = oldest;
+    }
+
+    uint8_t n = 0;
+    if (start < next_seq) {
+        uint32_t available = next_seq - start;
+        n = (available < max_count) ? (uint8_t)available : max_count;
+    }
+
+    uint16_t idx = 0;
+    resp[idx++] = HISTORY_FC_READ;
+    resp[idx++] = 0;    // Byte count, filled below
+    History_PutU32(&resp[idx], start);
+    idx += 4;
+    resp[idx++] = n;
+    History_PutU32(&resp[idx], History_GetNewestSeq());
+    idx += 4;
+    History_PutU32(&resp[idx], HAL_GetTick());
+    idx += 4;
+
+    for (uint8_t i = 0; i < n; i++) {
+        const History_Record_t *rec = &records[(start + i) % HISTORY_CAPACITY];
+
+        History_PutU32(&resp[idx], rec->tick);
+        idx += 4;
+
+        for (uint8_t r = 0; r < HISTORY_REG_COUNT; r++) {
+            resp[idx++] = (rec->regs[r] >> 8) & 0xFF;
+            resp[idx++] = rec->regs[r] & 0xFF;
+        }
+    }
+
+    resp[1] = idx - 2;
+    return idx;
+}
+
+/**
+ * Store 32-bit value big-endian
+ */
+static void History_PutU32(uint8_t *buf, uint32_t value) {
+    buf[0] = (value >> 24) & 0xFF;
+    buf[1] = (value >> 16) & 0xFF;
+    buf[2] = (value >> 8) & 0xFF;
+    buf[3] = value & 0xFF;
+}
@@ -0,0 +1,302 @@
+/**
+ * Asynchronous I2C Transaction Engine
+ * SprigRig Sensor Hub
+ */
+
+#include "i2c_bus.h"
+#include <string.h>
+
+/* Private variables */
+static I2CBus_HandleTypeDef buses[I2C_BUS_MAX];
+static uint8_t bus_count = 0;
+
+/* Private function prototypes */
+static void I2CBus_ProcessBus(I2CBus_HandleTypeDef *bus);
+static void I2CBus_StartNext(I2CBus_HandleTypeDef *bus);
+static void I2CBus_Complete(I2CBus_HandleTypeDef *bus, bool success);
+static void I2CBus_OnTransferDone(I2C_HandleTypeDef *hi2c, bool success);
+
+/**
+ * Register a bus for asynchronous use
+ * Call after HAL_I2C_Init() and after any blocking driver init on that bus.
+ * Returns NULL if all bus slots are in use.
+ */
+I2CBus_HandleTypeDef* I2CBus_Init(I2C_HandleTypeDef *hi2c) {
+    I2CBus_HandleTypeDef *bus = I2CBus_Get(hi2c);
+    if (bus != NULL) {
+        return bus;
+    }
+
+    if (bus_count >= I2C_BUS_MAX) {
+        return NULL;
+    }
+
+    bus = &buses[bus_count++];
+    memset(bus, 0, sizeof(*bus));
+    bus->hi2c = hi2c;
+    bus->state = I2C_BUS_IDLE;
+    bus->last_complete_tick = HAL_GetTick();
+    Diag_StatReset(&bus->transfer_time);
+
+    return bus;
+}
+
+/**
+ * Look up the bus registered for a HAL handle
+ */
+I2CBus_HandleTypeDef* I2CBus_Get(I2C_HandleTypeDef *hi2c) {
+    for (uint8_t i = 0; i < bus_count; i++) {
+        if (buses[i].hi2c == hi2c) {
+            return &buses[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Queue a job
+ * Returns false if the bus is not registered or the queue is full.
+ */
+bool I2CBus_Submit(I2CBus_HandleTypeDef *bus, const I2CBus_Job_t *job) {
+    if (bus == NULL || bus->count >= I2C_BUS_QUEUE_SIZE) {
+        return false;
+    }
+
+    uint8_t tail = (bus->head + bus->count) % I2C_BUS_QUEUE_SIZE;
+    bus->queue[tail] = *job;
+    bus->count++;
+
+    // Start right away if the bus is free
+    if (bus->state == I2C_BUS_IDLE) {
+        I2CBus_StartNext(bus);
+    }
+
+    return true;
+}
+
+/**
+ * Queue a master transmit (payload is copied)
+ */
+bool I2CBus_Write(I2CBus_HandleTypeDef *bus, uint8_t address,
+                  const uint8_t *data, uint16_t len, uint16_t delay_ms,
+                  I2CBus_Callback callback, void *context) {
+    if (len > I2C_BUS_WRITE_MAX) {
+        return false;
+    }
+
+    I2CBus_Job_t job = {0};
+    job.type = I2C_JOB_WRITE;
+    job.address = address;
+    memcpy(job.tx_data, data, len);
+    job.length = len;
+    job.delay_ms = delay_ms;
+    job.callback = callback;
+    job.context = context;
+
+    return I2CBus_Submit(bus, &job);
+}
+
+/**
+ * Queue a master receive into a caller-owned buffer
+ */
+bool I2CBus_Read(I2CBus_HandleTypeDef *bus, uint8_t address,
+                 uint8_t *data, uint16_t len, uint16_t delay_ms,
+                 I2CBus_Callback callback, void *context) {
+    I2CBus_Job_t job = {0};
+    job.type = I2C_JOB_READ;
+    job.address = address;
+    job.rx_data = data;
+    job.length = len;
+    job.delay_ms = delay_ms;
+    job.callback = callback;
+    job.context = context;
+
+    return I2CBus_Submit(bus, &job);
+}
+
+/**
+ * Queue a single register write
+ */
+bool I2CBus_MemWrite(I2CBus_HandleTypeDef *bus, uint8_t address, uint8_t reg,
+                     uint8_t value, I2CBus_Callback callback, void *context) {
+    I2CBus_Job_t job = {0};
+    job.type = I2C_JOB_MEM_WRITE;
+    job.address = address;
+    job.reg = reg;
+    job.tx_data[0] = value;
+    job.length = 1;
+    job.callback = callback;
+    job.context = context;
+
+    return I2CBus_Submit(bus, &job);
+}
+
+/**
+ * Queue a register read into a caller-owned buffer
+ */
+bool I2CBus_MemRead(I2CBus_HandleTypeDef *bus, uint8_t address, uint8_t reg,
+                    uint8_t *data, uint16_t len,
+                    I2CBus_Callback callback, void *context) {
+    I2CBus_Job_t job = {0};
+    job.type = I2C_JOB_MEM_READ;
+    job.address = address;
+    job.reg = reg;
+    job.rx_data = data;
+    job.length = len;
+    job.callback = callback;
+    job.context = context;
+
+    return I2CBus_Submit(bus, &job);
+}
+
+/**
+ * Number of queued jobs (including the one in flight)
+ */
+uint8_t I2CBus_GetPending(I2CBus_HandleTypeDef *bus) {
+    return bus ? bus->count : 0;
+}
+
+/**
+ * Service all buses - call from main loop
+ * Delivers completions, recovers stuck transfers and starts queued jobs.
+ */
+void I2CBus_Process(void) {
+    for (uint8_t i = 0; i < bus_count; i++) {
+        I2CBus_ProcessBus(&buses[i]);
+    }
+}
+
+/**
+ * Service one bus
+ */
+static void I2CBus_ProcessBus(I2CBus_HandleTypeDef *bus) {
+    switch (bus->state) {
+        case I2C_BUS_DONE:
+            Diag_StatAdd(&bus->transfer_time,
+                         Diag_CyclesToUs(bus->done_cycles - bus->start_cycles));
+            I2CBus_Complete(bus, true);
+            break;
+
+        case I2C_BUS_ERROR:
+            bus->error_count++;
+            I2CBus_Complete(bus, false);
+            break;
+
+        case I2C_BUS_BUSY:
+            // A sensor holding SDA low or a lost interrupt would otherwise
+            // wedge the bus forever; reset the peripheral and fail the job
+            if (HAL_GetTick() - bus->start_tick >= I2C_BUS_JOB_TIMEOUT_MS) {
+                bus->timeout_count++;
+                HAL_I2C_DeInit(bus->hi2c);
+                HAL_I2C_Init(bus->hi2c);
+                I2CBus_Complete(bus, false);
+            }
+            return;
+
+        default:
+            break;
+    }
+
+    if (bus->state == I2C_BUS_IDLE) {
+        I2CBus_StartNext(bus);
+    }
+}
+
+/**
+ * Start the job at the head of the queue if its delay has elapsed
+ */
+static void I2CBus_StartNext(I2CBus_HandleTypeDef *bus) {
+    if (bus->count == 0) {
+        return;
+    }
+
+    I2CBus_Job_t *job = &bus->queue[bus->head];
+    uint32_t now = HAL_GetTick();
+
+    if (now - bus->last_complete_tick < job->delay_ms) {
+        return;
+    }
+
+    uint16_t dev_addr = job->address << 1;
+    HAL_StatusTypeDef status;
+
+    bus->state = I2C_BUS_BUSY;
+    bus->start_tick = now;
+    bus->start_cycles = DIAG_NOW();
+
+    switch (job->type) {
+        case I2C_JOB_WRITE:
+            status = HAL_I2C_Master_Transmit_IT(bus->hi2c, dev_addr, job->tx_data, job->length);
+            break;
+        case I2C_JOB_READ:
+            status = HAL_I2C_Master_Receive_IT(bus->hi2c, dev_addr, job->rx_data, job->length);
+            break;
+        case I2C_JOB_MEM_WRITE:
+            status = HAL_I2C_Mem_Write_IT(bus->hi2c, dev_addr, job->reg,
+                                          I2C_MEMADD_SIZE_8BIT, job->tx_data, job->length);
+            break;
+        case I2C_JOB_MEM_READ:
+            status = HAL_I2C_Mem_Read_IT(bus->hi2c, dev_addr, job->reg,
+                                         I2C_MEMADD_SIZE_8BIT, job->rx_data, job->length);
+            break;
+        default:
+            status = HAL_ERROR;
+            break;
+    }
+
+    if (status != HAL_OK) {
+        // Delivered on the next I2CBus_Process() pass
+        bus->state = I2C_BUS_ERROR;
+    }
+}
+
+/**
+ * Pop the finished job and run its callback
+ */
+static void I2CBus_Complete(I2CBus_HandleTypeDef *bus, bool success) {
+    I2CBus_Job_t job = bus->queue[bus->head];
+
+    bus->head = (bus->head + 1) % I2C_BUS_QUEUE_SIZE;
+    bus->count--;
+    bus->job_count++;
+    bus->last_complete_tick = HAL_GetTick();
+    bus->state = I2C_BUS_IDLE;
+
+    // Callback may queue follow-up jobs
+    if (job.callback != NULL) {
+        job.callback(job.context, success);
+    }
+}
+
+/**
+ * Flag transfer completion from ISR context
+ */
+static void I2CBus_OnTransferDone(I2C_HandleTypeDef *hi2c, bool success) {
+    I2CBus_HandleTypeDef *bus = I2CBus_Get(hi2c);
+    if (bus != NULL && bus->state == I2C_BUS_BUSY) {
+        bus->done_cycles = DIAG_NOW();
+        bus->state = success ? I2C_BUS_DONE : I2C_BUS_ERROR;
+    }
+}
+
+/* HAL completion callbacks (override weak HAL definitions) */
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2CBus_OnTransferDone(hi2c, true);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2CBus_OnTransferDone(hi2c, true);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2CBus_OnTransferDone(hi2c, true);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    I2CBus_OnTransferDone(hi2c, true);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    I2CBus_OnTransferDone(hi2c, false);
+}
@@ -8,26 +8,36 @@
 #include "main.h"
 #include "modbus.h"
 #include "sensor_hub.h"
+#include "history.h"
+#include "diag.h"
 
 /* Private variables */
 ADC_HandleTypeDef hadc1;
+CRC_HandleTypeDef hcrc;
 DAC_HandleTypeDef hdac1;
 I2C_HandleTypeDef hi2c1;
 I2C_HandleTypeDef hi2c2;
 SPI_HandleTypeDef hspi2;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_adc1;
+TIM_HandleTypeDef htim6;
 
 Modbus_HandleTypeDef modbus;
 
 /* Private function prototypes */
 static void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_ADC1_Init(void);
+static void MX_TIM6_Init(void);
 static void MX_DAC1_Init(void);
 static void MX_I2C1_Init(void);
 static void MX_I2C2_Init(void);
 static void MX_SPI2_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_CRC_Init(void);
 
 /**
  * Main entry point
@@ -37,51 +47,67 @@ int main(void) {
     HAL_Init();
     SystemClock_Config();
 
+    /* Cycle counter for timing diagnostics */
+    Diag_Init();
+
     /* Initialize peripherals */
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_ADC1_Init();
+    MX_TIM6_Init();
     MX_DAC1_Init();
     MX_I2C1_Init();
     MX_I2C2_Init();
     MX_SPI2_Init();
     MX_USART2_UART_Init();
+    MX_CRC_Init();
 
     /* Initialize Sensor Hub */
     SensorHub_Config_t hub_config = {
         .hadc = &hadc1,
+        .htim_adc = &htim6,
         .hdac = &hdac1,
         .hi2c1 = &hi2c1,
         .hi2c2 = &hi2c2,
-        .hspi2 = &hspi2
+        .hspi2 = &hspi2,
+        .modbus = &modbus
     };
     SensorHub_Init(&hub_config);
 
     /* Read Modbus address from DIP switches */
     uint8_t modbus_address = SensorHub_ReadAddress();
 
+    /* Frame processing runs in PendSV: lowest priority, so it preempts
+       the sensor loop but never the UART, DMA or I2C interrupts */
+    HAL_NVIC_SetPriority(PendSV_IRQn, 15, 0);
+
     /* Initialize Modbus slave */
     Modbus_Init(&modbus, &huart2,
-                RS485_DE_PORT, RS485_DE_PIN,
                 modbus_address,
                 SensorHub_GetRegisters(),
                 SensorHub_GetRegisterCount());
 
-    /* Register write callback for analog outputs */
+    /* Frame CRCs on the CRC unit (falls back to the table if its
+       self-test fails) */
+    Modbus_UseCRCUnit(&modbus, &hcrc);
+
+    /* Register callbacks: analog output writes, writable register map,
+       change map clear-on-read */
     Modbus_SetWriteCallback(&modbus, SensorHub_OnRegisterWrite);
+    Modbus_SetWritableCallback(&modbus, SensorHub_IsRegisterWritable);
+    Modbus_SetReadCallback(&modbus, SensorHub_OnRegisterRead);
+
+    /* Bulk history readout (0x41) */
+    Modbus_SetFunctionHandler(&modbus, HISTORY_FC_READ, History_HandleRead);
 
-    /* Main loop */
-    uint32_t last_update = 0;
+    /* Identification for Read Device ID (0x2B/0x0E) */
+    Modbus_SetDeviceId(&modbus, "SprigRig", "SprigRig Sensor Hub", SensorHub_GetRevision());
 
+    /* Main loop - Modbus requests are answered from PendSV, which
+       preempts this loop as soon as a frame ends */
     while (1) {
-        /* Poll Modbus for incoming requests */
-        Modbus_Poll(&modbus);
-
-        /* Update sensor readings every 100ms */
-        uint32_t now = HAL_GetTick();
-        if (now - last_update >= 100) {
-            last_update = now;
-            SensorHub_Update();
-        }
+        /* Run the next due sensor task (one bounded slice per pass) */
+        SensorHub_Update();
     }
 }
 
@@ -136,14 +162,6 @@ static void MX_GPIO_Init(void) {
     __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
 
-    /* Configure RS485 DE/RE pin */
-    GPIO_InitStruct.Pin = RS485_DE_PIN;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
-    HAL_GPIO_Init(RS485_DE_PORT, &GPIO_InitStruct);
-    HAL_GPIO_WritePin(RS485_DE_PORT, RS485_DE_PIN, GPIO_PIN_RESET); // Start in RX mode
-
     /* Configure DIP Switch pins (inputs with pull-up) */
     GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
     GPIO_InitStruct.Pull = GPIO_PULLUP;
@@ -174,6 +192,63 @@ static void MX_GPIO_Init(void) {
     HAL_GPIO_Init(DI4_PORT, &GPIO_InitStruct);
 }
 
+/**
+ * DMA Initialization
+ * DMA1 Channel1: USART2 RX, circular (Modbus receive ring)
+ * DMA1 Channel2: USART2 TX, normal (Modbus replies)
+ * DMA1 Channel3: ADC1, circular (analog input scan)
+ */
+static void MX_DMA_Init(void) {
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_usart2_rx.Instance = DMA1_Channel1;
+    hdma_usart2_rx.Init.Request = DMA_REQUEST_USART2_RX;
+    hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_usart2_rx.Init.Priority = DMA_PRIORITY_HIGH;
+
+    if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK) {
+        Error_Handler();
+    }
+
+    hdma_usart2_tx.Instance = DMA1_Channel2;
+    hdma_usart2_tx.Init.Request = DMA_REQUEST_USART2_TX;
+    hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+
+    if (HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK) {
+        Error_Handler();
+    }
+
+    hdma_adc1.Instance = DMA1_Channel3;
+    hdma_adc1.Init.Request = DMA_REQUEST_ADC1;
+    hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) {
+        Error_Handler();
+    }
+
+    /* TX transfer complete hands over to the USART TC interrupt */
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+}
+
 /**
  * ADC1 Initialization
  */
@@ -197,27 +272,56 @@ static void MX_ADC1_Init(void) {
     GPIO_InitStruct.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2;
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
-    /* Configure ADC */
+    /* Configure ADC: timer-triggered scan of all four inputs into circular DMA.
+       Each trigger runs 256x hardware oversampling per channel, shifted back
+       to 12 bits, so DMA delivers filtered values with no CPU involvement. */
     hadc1.Instance = ADC1;
     hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
     hadc1.Init.Resolution = ADC_RESOLUTION_12B;
     hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
     hadc1.Init.GainCompensation = 0;
-    hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
-    hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+    hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
     hadc1.Init.LowPowerAutoWait = DISABLE;
     hadc1.Init.ContinuousConvMode = DISABLE;
-    hadc1.Init.NbrOfConversion = 1;
+    hadc1.Init.NbrOfConversion = 4;
     hadc1.Init.DiscontinuousConvMode = DISABLE;
-    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
-    hadc1.Init.DMAContinuousRequests = DISABLE;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
     hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
-    hadc1.Init.OversamplingMode = DISABLE;
+    hadc1.Init.OversamplingMode = ENABLE;
+    hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_256;
+    hadc1.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_8;
+    hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    hadc1.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
 
     if (HAL_ADC_Init(&hadc1) != HAL_OK) {
         Error_Handler();
     }
+
+    __HAL_LINKDMA(&hadc1, DMA_Handle, hdma_adc1);
+
+    /* Scan sequence - rank order matches SensorHub's ADC buffer layout */
+    ADC_ChannelConfTypeDef sConfig = {0};
+    sConfig.SamplingTime = ADC_SAMPLETIME_47CYCLES_5;
+    sConfig.SingleDiff = ADC_SINGLE_ENDED;
+    sConfig.OffsetNumber = ADC_OFFSET_NONE;
+
+    const uint32_t channels[4] = {
+        ADC_4_20MA_1_CH, ADC_4_20MA_2_CH, ADC_0_10V_1_CH, ADC_0_10V_2_CH
+    };
+    const uint32_t ranks[4] = {
+        ADC_REGULAR_RANK_1, ADC_REGULAR_RANK_2, ADC_REGULAR_RANK_3, ADC_REGULAR_RANK_4
+    };
+
+    for (int i = 0; i < 4; i++) {
+        sConfig.Channel = channels[i];
+        sConfig.Rank = ranks[i];
+        if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+            Error_Handler();
+        }
+    }
 }
 
 /**
@@ -248,6 +352,13 @@ static void MX_I2C1_Init(void) {
     if (HAL_I2C_Init(&hi2c1) != HAL_OK) {
         Error_Handler();
     }
+
+    /* Enable I2C1 interrupts for the async transaction engine
+       (below USART2 so Modbus RX is never delayed) */
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
 }
 
 /**
@@ -278,6 +389,40 @@ static void MX_I2C2_Init(void) {
     if (HAL_I2C_Init(&hi2c2) != HAL_OK) {
         Error_Handler();
     }
+
+    /* Enable I2C2 interrupts for the async transaction engine
+       (below USART2 so Modbus RX is never delayed) */
+    HAL_NVIC_SetPriority(I2C2_EV_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C2_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C2_ER_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C2_ER_IRQn);
+}
+
+/**
+ * TIM6 Initialization
+ * 100Hz TRGO to trigger the ADC scan (170MHz / 170 / 10000)
+ */
+static void MX_TIM6_Init(void) {
+    TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+    __HAL_RCC_TIM6_CLK_ENABLE();
+
+    htim6.Instance = TIM6;
+    htim6.Init.Prescaler = 170 - 1;
+    htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim6.Init.Period = 10000 - 1;
+    htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_TIM_Base_Init(&htim6) != HAL_OK) {
+        Error_Handler();
+    }
+
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK) {
+        Error_Handler();
+    }
 }
 
 /**
@@ -374,7 +519,7 @@ static void MX_SPI2_Init(void) {
 
 /**
  * USART2 Initialization (RS485 for Modbus)
- * PA2 = TX, PA3 = RX
+ * PA2 = TX, PA3 = RX, PA1 = DE (driven by the USART)
  */
 static void MX_USART2_UART_Init(void) {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -389,6 +534,11 @@ static void MX_USART2_UART_Init(void) {
     GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+    /* RS485 DE/RE as USART2_DE, pulled down so the transceiver idles in RX */
+    GPIO_InitStruct.Pin = RS485_DE_PIN;
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;
+    HAL_GPIO_Init(RS485_DE_PORT, &GPIO_InitStruct);
+
     /* Configure USART2 */
     huart2.Instance = USART2;
     huart2.Init.BaudRate = 9600;
@@ -401,15 +551,45 @@ static void MX_USART2_UART_Init(void) {
     huart2.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
     huart2.Init.ClockPrescaler = UART_PRESCALER_DIV1;
 
-    if (HAL_UART_Init(&huart2) != HAL_OK) {
+    /* Hardware DE: asserted 1 bit time before the start bit and
+       released 1 bit time after the last stop bit (units of 1/16 bit) */
+    if (HAL_RS485Ex_Init(&huart2, UART_DE_POLARITY_HIGH, 16, 16) != HAL_OK) {
         Error_Handler();
     }
 
-    /* Enable UART RX interrupt */
+    /* RX runs on circular DMA (started by Modbus_Init), TX on one-shot DMA */
+    __HAL_LINKDMA(&huart2, hdmarx, hdma_usart2_rx);
+    __HAL_LINKDMA(&huart2, hdmatx, hdma_usart2_tx);
+
+    /* Enable UART interrupt (receiver timeout marks frame end, TC ends a reply) */
     HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USART2_IRQn);
 }
 
+/**
+ * CRC Initialization
+ * CRC-16/MODBUS: polynomial 0x8005, init 0xFFFF, input bit-reversed per
+ * byte, output bit-reversed. Byte input lets HAL feed 4 frame bytes per
+ * 32-bit write.
+ */
+static void MX_CRC_Init(void) {
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    hcrc.Instance = CRC;
+    hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_DISABLE;
+    hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_DISABLE;
+    hcrc.Init.GeneratingPolynomial = 0x8005;
+    hcrc.Init.CRCLength = CRC_POLYLENGTH_16B;
+    hcrc.Init.InitValue = 0xFFFF;
+    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+
+    if (HAL_CRC_Init(&hcrc) != HAL_OK) {
+        Error_Handler();
+    }
+}
+
 /**
  * Error Handler
  */
@@ -425,3 +605,4 @@ void assert_failed(uint8_t *file, uint32_t line) {
     // User can add their own implementation
 }
 #endif
+
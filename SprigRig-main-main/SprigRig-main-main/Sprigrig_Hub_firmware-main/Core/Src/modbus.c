@@ -7,12 +7,23 @@
 #include <string.h>
 
 /* Private function prototypes */
-static void Modbus_SetDE(Modbus_HandleTypeDef *mb, bool transmit);
+static void Modbus_StartReceive(Modbus_HandleTypeDef *mb);
+static void Modbus_FrameReceived(Modbus_HandleTypeDef *mb);
 static void Modbus_SendResponse(Modbus_HandleTypeDef *mb, uint16_t length);
 static void Modbus_SendException(Modbus_HandleTypeDef *mb, uint8_t function, uint8_t exception);
 static void Modbus_ProcessFrame(Modbus_HandleTypeDef *mb);
-static void Modbus_HandleReadHoldingRegisters(Modbus_HandleTypeDef *mb);
+static void Modbus_HandleReadRegisters(Modbus_HandleTypeDef *mb, uint8_t function);
 static void Modbus_HandleWriteSingleRegister(Modbus_HandleTypeDef *mb);
+static void Modbus_HandleWriteMultipleRegisters(Modbus_HandleTypeDef *mb);
+static void Modbus_HandleReadWriteMultiple(Modbus_HandleTypeDef *mb);
+static void Modbus_HandleReadDeviceId(Modbus_HandleTypeDef *mb);
+static void Modbus_HandleCustomFunction(Modbus_HandleTypeDef *mb, uint8_t function);
+static bool Modbus_WriteRegisters(Modbus_HandleTypeDef *mb, uint16_t start_addr,
+                                  uint16_t quantity, const uint8_t *data);
+static uint16_t Modbus_PutRegisters(Modbus_HandleTypeDef *mb, uint16_t tx_index,
+                                    uint16_t start_addr, uint16_t quantity);
+static uint16_t Modbus_AppendCRC(Modbus_HandleTypeDef *mb, uint16_t tx_index);
+static uint16_t Modbus_FrameCRC(Modbus_HandleTypeDef *mb, uint8_t *data, uint16_t length);
 
 /* CRC16 lookup table (Modbus polynomial 0xA001) */
 static const uint16_t crc_table[256] = {
@@ -51,7 +62,7 @@ static const uint16_t crc_table[256] = {
 };
 
 /**
- * Calculate CRC16 for Modbus
+ * Calculate CRC16 for Modbus (portable table version)
  */
 uint16_t Modbus_CRC16(uint8_t *data, uint16_t length) {
     uint16_t crc = 0xFFFF;
@@ -64,72 +75,176 @@ uint16_t Modbus_CRC16(uint8_t *data, uint16_t length) {
     return crc;
 }
 
+/**
+ * Switch frame CRCs to the CRC unit
+ * The unit must be configured for CRC-16/MODBUS (poly 0x8005, init 0xFFFF,
+ * byte-reflected input, reflected output). It is only used if it matches
+ * the table on a self-test, so a misconfigured unit costs speed, not
+ * correctness. Call after Modbus_Init(). Returns true if in use.
+ */
+bool Modbus_UseCRCUnit(Modbus_HandleTypeDef *mb, CRC_HandleTypeDef *hcrc) {
+    // Standard check string, plus an odd-length frame to cover the tail bytes
+    static uint8_t check[] = "123456789";
+    static uint8_t frame[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x19, 0x84, 0x5A, 0x7F };
+
+    mb->hcrc = NULL;
+    if (hcrc == NULL) {
+        return false;
+    }
+
+    if ((uint16_t)HAL_CRC_Calculate(hcrc, (uint32_t *)check, 9) != 0x4B37) {
+        return false;
+    }
+    for (uint16_t len = 1; len <= sizeof(frame); len++) {
+        if ((uint16_t)HAL_CRC_Calculate(hcrc, (uint32_t *)frame, len) != Modbus_CRC16(frame, len)) {
+            return false;
+        }
+    }
+
+    mb->hcrc = hcrc;
+    return true;
+}
+
+/**
+ * CRC of a frame - CRC unit when available, table otherwise
+ * Only called from PendSV, so the unit is never shared mid-calculation.
+ */
+static uint16_t Modbus_FrameCRC(Modbus_HandleTypeDef *mb, uint8_t *data, uint16_t length) {
+    if (mb->hcrc != NULL) {
+        return (uint16_t)HAL_CRC_Calculate(mb->hcrc, (uint32_t *)data, length);
+    }
+    return Modbus_CRC16(data, length);
+}
+
 /**
  * Initialize Modbus slave
  */
 void Modbus_Init(Modbus_HandleTypeDef *mb, UART_HandleTypeDef *huart,
-                 GPIO_TypeDef *de_port, uint16_t de_pin,
                  uint8_t slave_address,
                  uint16_t *holding_regs, uint16_t reg_count) {
 
     mb->huart = huart;
-    mb->de_port = de_port;
-    mb->de_pin = de_pin;
     mb->slave_address = slave_address;
+    mb->broadcast = false;
     mb->holding_registers = holding_regs;
     mb->holding_reg_count = reg_count;
 
     mb->rx_index = 0;
-    mb->last_rx_time = 0;
     mb->frame_ready = false;
+    mb->overrun_count = 0;
+    mb->crc_error_count = 0;
+    mb->hcrc = NULL;
+    Diag_StatReset(&mb->turnaround);
     mb->write_callback = NULL;
+    mb->writable_callback = NULL;
+    mb->read_callback = NULL;
+    mb->custom_function = 0;
+    mb->custom_handler = NULL;
+    memset(mb->device_id, 0, sizeof(mb->device_id));
 
-    // Start in receive mode
-    Modbus_SetDE(mb, false);
-
-    // Enable UART receive interrupt
-    __HAL_UART_ENABLE_IT(mb->huart, UART_IT_RXNE);
+    Modbus_StartReceive(mb);
 }
 
 /**
- * Set DE/RE pin state (true = transmit, false = receive)
+ * Start circular DMA reception with receiver-timeout framing
+ * The DMA runs with its interrupts disabled; the only RX interrupt is the
+ * USART receiver timeout, raised once per frame after t3.5 of silence.
  */
-static void Modbus_SetDE(Modbus_HandleTypeDef *mb, bool transmit) {
-    if (transmit) {
-        HAL_GPIO_WritePin(mb->de_port, mb->de_pin, GPIO_PIN_SET);
+static void Modbus_StartReceive(Modbus_HandleTypeDef *mb) {
+    uint32_t baud = mb->huart->Init.BaudRate;
+
+    if (baud <= MODBUS_T35_FIXED_BAUD) {
+        mb->rx_timeout_bits = MODBUS_T35_BITS;
     } else {
-        HAL_GPIO_WritePin(mb->de_port, mb->de_pin, GPIO_PIN_RESET);
+        mb->rx_timeout_bits = (baud * MODBUS_T35_FIXED_US) / 1000000;
     }
+
+    mb->rx_dma_tail = 0;
+
+    HAL_UART_ReceiverTimeout_Config(mb->huart, mb->rx_timeout_bits);
+    HAL_UART_EnableReceiverTimeout(mb->huart);
+
+    HAL_DMA_Start(mb->huart->hdmarx, (uint32_t)&mb->huart->Instance->RDR,
+                  (uint32_t)mb->rx_dma_buffer, MODBUS_RX_DMA_SIZE);
+    SET_BIT(mb->huart->Instance->CR3, USART_CR3_DMAR);
+
+    __HAL_UART_ENABLE_IT(mb->huart, UART_IT_RTO);
 }
 
 /**
- * UART RX callback - call from UART IRQ handler
+ * UART interrupt handler - call from USART IRQ before HAL_UART_IRQHandler()
+ * Consumes the receiver timeout and line error flags so the HAL handler
+ * never aborts the circular DMA.
  */
-void Modbus_RxCallback(Modbus_HandleTypeDef *mb, uint8_t data) {
-    if (mb->rx_index < MODBUS_RX_BUFFER_SIZE) {
-        mb->rx_buffer[mb->rx_index++] = data;
-        mb->last_rx_time = HAL_GetTick();
+void Modbus_IRQHandler(Modbus_HandleTypeDef *mb) {
+    UART_HandleTypeDef *huart = mb->huart;
+
+    // Line errors: the bad byte still lands in the ring and fails the CRC
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_ORE)) {
+        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_OREF);
+    }
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_FE)) {
+        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_FEF);
+    }
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_NE)) {
+        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_NEF);
+    }
+
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_RTOF)) {
+        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_RTOF);
+        Modbus_FrameReceived(mb);
     }
 }
 
 /**
- * Timer callback - call from SysTick or timer IRQ (every 1ms)
+ * Copy the bytes received since the last gap out of the DMA ring
  */
-void Modbus_TimerCallback(Modbus_HandleTypeDef *mb) {
-    // Check for frame timeout (3.5 character times)
-    if (mb->rx_index > 0 && !mb->frame_ready) {
-        uint32_t elapsed = HAL_GetTick() - mb->last_rx_time;
-        if (elapsed >= MODBUS_FRAME_TIMEOUT_MS) {
-            mb->frame_ready = true;
-        }
+static void Modbus_FrameReceived(Modbus_HandleTypeDef *mb) {
+    uint16_t head = MODBUS_RX_DMA_SIZE - __HAL_DMA_GET_COUNTER(mb->huart->hdmarx);
+    if (head == MODBUS_RX_DMA_SIZE) {
+        head = 0;
+    }
+
+    uint16_t tail = mb->rx_dma_tail;
+    uint16_t length = (head - tail + MODBUS_RX_DMA_SIZE) % MODBUS_RX_DMA_SIZE;
+    mb->rx_dma_tail = head;
+
+    if (length == 0) {
+        return;
+    }
+
+    // Previous frame not yet processed, or the master talked over our
+    // reply - drop this one, the master retries
+    if (mb->frame_ready || Modbus_IsTransmitting(mb)) {
+        mb->overrun_count++;
+        return;
+    }
+
+    uint16_t first = MODBUS_RX_DMA_SIZE - tail;
+    if (length <= first) {
+        memcpy(mb->rx_buffer, &mb->rx_dma_buffer[tail], length);
+    } else {
+        memcpy(mb->rx_buffer, &mb->rx_dma_buffer[tail], first);
+        memcpy(&mb->rx_buffer[first], mb->rx_dma_buffer, length - first);
     }
+
+    mb->rx_index = length;
+    mb->frame_ready = true;
+    mb->frame_cycles = DIAG_NOW();
+
+    // Hand the frame to PendSV: it runs as soon as the interrupt returns,
+    // preempting whatever the main loop is doing
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
 }
 
 /**
- * Main polling function - call from main loop
+ * Process a received frame - call from PendSV_Handler
+ * PendSV sits at the lowest priority, so it preempts the sensor loop but
+ * never delays UART, DMA or I2C interrupts.
  */
-void Modbus_Poll(Modbus_HandleTypeDef *mb) {
-    if (mb->frame_ready) {
+void Modbus_Process(Modbus_HandleTypeDef *mb) {
+    // tx_buffer belongs to the DMA until the reply has gone out
+    if (mb->frame_ready && !Modbus_IsTransmitting(mb)) {
         Modbus_ProcessFrame(mb);
         mb->rx_index = 0;
         mb->frame_ready = false;
@@ -150,44 +265,69 @@ static void Modbus_ProcessFrame(Modbus_HandleTypeDef *mb) {
     if (address != mb->slave_address && address != 0) {
         return;
     }
+    mb->broadcast = (address == 0);
 
     // Verify CRC
     uint16_t received_crc = mb->rx_buffer[mb->rx_index - 2] |
                            (mb->rx_buffer[mb->rx_index - 1] << 8);
-    uint16_t calculated_crc = Modbus_CRC16(mb->rx_buffer, mb->rx_index - 2);
+    uint16_t calculated_crc = Modbus_FrameCRC(mb, mb->rx_buffer, mb->rx_index - 2);
 
     if (received_crc != calculated_crc) {
+        mb->crc_error_count++;
         return; // CRC error, ignore frame
     }
 
     // Process function code
     uint8_t function = mb->rx_buffer[1];
 
+    // Broadcasts carry writes only and are never answered
+    if (mb->broadcast && function != MODBUS_FC_WRITE_SINGLE_REG &&
+        function != MODBUS_FC_WRITE_MULTIPLE_REGS && function != MODBUS_FC_READ_WRITE_MULTIPLE) {
+        return;
+    }
+
     switch (function) {
         case MODBUS_FC_READ_HOLDING_REGS:
-            Modbus_HandleReadHoldingRegisters(mb);
+        case MODBUS_FC_READ_INPUT_REGS:
+            Modbus_HandleReadRegisters(mb, function);
             break;
 
         case MODBUS_FC_WRITE_SINGLE_REG:
             Modbus_HandleWriteSingleRegister(mb);
             break;
 
+        case MODBUS_FC_WRITE_MULTIPLE_REGS:
+            Modbus_HandleWriteMultipleRegisters(mb);
+            break;
+
+        case MODBUS_FC_READ_WRITE_MULTIPLE:
+            Modbus_HandleReadWriteMultiple(mb);
+            break;
+
+        case MODBUS_FC_ENCAPSULATED:
+            Modbus_HandleReadDeviceId(mb);
+            break;
+
         default:
-            // Unsupported function
-            if (address != 0) { // Don't respond to broadcast
-                Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_FUNCTION);
+            if (mb->custom_handler != NULL && function == mb->custom_function) {
+                Modbus_HandleCustomFunction(mb, function);
+                break;
             }
+
+            // Unsupported function
+            Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_FUNCTION);
             break;
     }
 }
 
 /**
- * Handle Read Holding Registers (Function 0x03)
+ * Handle Read Holding Registers (0x03) and Read Input Registers (0x04)
+ * Input registers are a read-only view of the same register bank.
  */
-static void Modbus_HandleReadHoldingRegisters(Modbus_HandleTypeDef *mb) {
+static void Modbus_HandleReadRegisters(Modbus_HandleTypeDef *mb, uint8_t function) {
     // Request: Address(1) + Function(1) + StartAddr(2) + Quantity(2) + CRC(2) = 8 bytes
     if (mb->rx_index < 8) {
-        Modbus_SendException(mb, MODBUS_FC_READ_HOLDING_REGS, MODBUS_EX_ILLEGAL_VALUE);
+        Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_VALUE);
         return;
     }
 
@@ -195,46 +335,69 @@ static void Modbus_HandleReadHoldingRegisters(Modbus_HandleTypeDef *mb) {
     uint16_t quantity = (mb->rx_buffer[4] << 8) | mb->rx_buffer[5];
 
     // Validate request
-    if (quantity == 0 || quantity > 125) {
-        Modbus_SendException(mb, MODBUS_FC_READ_HOLDING_REGS, MODBUS_EX_ILLEGAL_VALUE);
+    if (quantity == 0 || quantity > MODBUS_MAX_READ_REGS) {
+        Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_VALUE);
         return;
     }
 
     if (start_addr + quantity > mb->holding_reg_count) {
-        Modbus_SendException(mb, MODBUS_FC_READ_HOLDING_REGS, MODBUS_EX_ILLEGAL_ADDRESS);
+        Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_ADDRESS);
         return;
     }
 
     // Build response
     uint16_t tx_index = 0;
     mb->tx_buffer[tx_index++] = mb->slave_address;
-    mb->tx_buffer[tx_index++] = MODBUS_FC_READ_HOLDING_REGS;
+    mb->tx_buffer[tx_index++] = function;
     mb->tx_buffer[tx_index++] = quantity * 2; // Byte count
 
-    // Add register values
+    tx_index = Modbus_PutRegisters(mb, tx_index, start_addr, quantity);
+    tx_index = Modbus_AppendCRC(mb, tx_index);
+
+    Modbus_SendResponse(mb, tx_index);
+}
+
+/**
+ * Append register values (big-endian) to the response
+ */
+static uint16_t Modbus_PutRegisters(Modbus_HandleTypeDef *mb, uint16_t tx_index,
+                                    uint16_t start_addr, uint16_t quantity) {
     for (uint16_t i = 0; i < quantity; i++) {
         uint16_t value = mb->holding_registers[start_addr + i];
         mb->tx_buffer[tx_index++] = (value >> 8) & 0xFF; // High byte
         mb->tx_buffer[tx_index++] = value & 0xFF;        // Low byte
     }
 
-    // Add CRC
-    uint16_t crc = Modbus_CRC16(mb->tx_buffer, tx_index);
+    // Values are in the reply now; let the application consume them
+    if (mb->read_callback != NULL) {
+        mb->read_callback(start_addr, quantity);
+    }
+    return tx_index;
+}
+
+/**
+ * Append CRC to the response
+ */
+static uint16_t Modbus_AppendCRC(Modbus_HandleTypeDef *mb, uint16_t tx_index) {
+    uint16_t crc = Modbus_FrameCRC(mb, mb->tx_buffer, tx_index);
     mb->tx_buffer[tx_index++] = crc & 0xFF;
     mb->tx_buffer[tx_index++] = (crc >> 8) & 0xFF;
-
-    Modbus_SendResponse(mb, tx_index);
+    return tx_index;
 }
 
 /**
  * Send exception response
  */
 static void Modbus_SendException(Modbus_HandleTypeDef *mb, uint8_t function, uint8_t exception) {
+    if (mb->broadcast) {
+        return;
+    }
+
     mb->tx_buffer[0] = mb->slave_address;
     mb->tx_buffer[1] = function | 0x80; // Set error bit
     mb->tx_buffer[2] = exception;
 
-    uint16_t crc = Modbus_CRC16(mb->tx_buffer, 3);
+    uint16_t crc = Modbus_FrameCRC(mb, mb->tx_buffer, 3);
     mb->tx_buffer[3] = crc & 0xFF;
     mb->tx_buffer[4] = (crc >> 8) & 0xFF;
 
@@ -242,26 +405,21 @@ static void Modbus_SendException(Modbus_HandleTypeDef *mb, uint8_t function, uin
 }
 
 /**
- * Send response over RS485
+ * Send response over RS485 (non-blocking)
+ * DMA feeds the USART and the USART asserts DE for the duration of the
+ * frame, releasing it after the last stop bit, so nothing waits here.
  */
 static void Modbus_SendResponse(Modbus_HandleTypeDef *mb, uint16_t length) {
-    // Switch to transmit mode
-    Modbus_SetDE(mb, true);
-
-    // Small delay for transceiver to settle
-    for (volatile int i = 0; i < 100; i++);
+    HAL_UART_Transmit_DMA(mb->huart, mb->tx_buffer, length);
 
-    // Transmit
-    HAL_UART_Transmit(mb->huart, mb->tx_buffer, length, 100);
-
-    // Wait for transmission complete
-    while (__HAL_UART_GET_FLAG(mb->huart, UART_FLAG_TC) == RESET);
-
-    // Small delay before switching back to receive
-    for (volatile int i = 0; i < 100; i++);
+    Diag_StatAdd(&mb->turnaround, Diag_Since(mb->frame_cycles));
+}
 
-    // Switch back to receive mode
-    Modbus_SetDE(mb, false);
+/**
+ * Check if a reply is still being transmitted
+ */
+bool Modbus_IsTransmitting(Modbus_HandleTypeDef *mb) {
+    return mb->huart->gState != HAL_UART_STATE_READY;
 }
 
 /**
@@ -284,11 +442,13 @@ static void Modbus_HandleWriteSingleRegister(Modbus_HandleTypeDef *mb) {
     }
 
     // Write the value
-    mb->holding_registers[reg_addr] = value;
+    if (!Modbus_WriteRegisters(mb, reg_addr, 1, &mb->rx_buffer[4])) {
+        Modbus_SendException(mb, MODBUS_FC_WRITE_SINGLE_REG, MODBUS_EX_ILLEGAL_ADDRESS);
+        return;
+    }
 
-    // Call write callback if registered (for DAC updates, etc.)
-    if (mb->write_callback != NULL) {
-        mb->write_callback(reg_addr, value);
+    if (mb->broadcast) {
+        return;
     }
 
     // Response is echo of request (Address + Function + RegAddr + Value + CRC)
@@ -300,10 +460,196 @@ static void Modbus_HandleWriteSingleRegister(Modbus_HandleTypeDef *mb) {
     mb->tx_buffer[tx_index++] = (value >> 8) & 0xFF;
     mb->tx_buffer[tx_index++] = value & 0xFF;
 
-    // Add CRC
-    uint16_t crc = Modbus_CRC16(mb->tx_buffer, tx_index);
-    mb->tx_buffer[tx_index++] = crc & 0xFF;
-    mb->tx_buffer[tx_index++] = (crc >> 8) & 0xFF;
+    tx_index = Modbus_AppendCRC(mb, tx_index);
+
+    Modbus_SendResponse(mb, tx_index);
+}
+
+/**
+ * Store big-endian register values and notify the write callback
+ * Nothing is written unless every register in the range is writable.
+ */
+static bool Modbus_WriteRegisters(Modbus_HandleTypeDef *mb, uint16_t start_addr,
+                                  uint16_t quantity, const uint8_t *data) {
+    if (mb->writable_callback != NULL) {
+        for (uint16_t i = 0; i < quantity; i++) {
+            if (!mb->writable_callback(start_addr + i)) {
+                return false;
+            }
+        }
+    }
+
+    for (uint16_t i = 0; i < quantity; i++) {
+        uint16_t reg_addr = start_addr + i;
+        uint16_t value = (data[i * 2] << 8) | data[i * 2 + 1];
+
+        mb->holding_registers[reg_addr] = value;
+
+        // Call write callback if registered (for DAC updates, etc.)
+        if (mb->write_callback != NULL) {
+            mb->write_callback(reg_addr, value);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Handle Write Multiple Registers (Function 0x10)
+ */
+static void Modbus_HandleWriteMultipleRegisters(Modbus_HandleTypeDef *mb) {
+    // Request: Address(1) + Function(1) + StartAddr(2) + Quantity(2) + ByteCount(1) + Data(N) + CRC(2)
+    if (mb->rx_index < 11) {
+        Modbus_SendException(mb, MODBUS_FC_WRITE_MULTIPLE_REGS, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    uint16_t start_addr = (mb->rx_buffer[2] << 8) | mb->rx_buffer[3];
+    uint16_t quantity = (mb->rx_buffer[4] << 8) | mb->rx_buffer[5];
+    uint8_t byte_count = mb->rx_buffer[6];
+
+    // Validate request
+    if (quantity == 0 || quantity > MODBUS_MAX_WRITE_REGS ||
+        byte_count != quantity * 2 || mb->rx_index != 9 + byte_count) {
+        Modbus_SendException(mb, MODBUS_FC_WRITE_MULTIPLE_REGS, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    if (start_addr + quantity > mb->holding_reg_count) {
+        Modbus_SendException(mb, MODBUS_FC_WRITE_MULTIPLE_REGS, MODBUS_EX_ILLEGAL_ADDRESS);
+        return;
+    }
+
+    if (!Modbus_WriteRegisters(mb, start_addr, quantity, &mb->rx_buffer[7])) {
+        Modbus_SendException(mb, MODBUS_FC_WRITE_MULTIPLE_REGS, MODBUS_EX_ILLEGAL_ADDRESS);
+        return;
+    }
+
+    if (mb->broadcast) {
+        return;
+    }
+
+    // Response: Address + Function + StartAddr + Quantity + CRC
+    uint16_t tx_index = 0;
+    mb->tx_buffer[tx_index++] = mb->slave_address;
+    mb->tx_buffer[tx_index++] = MODBUS_FC_WRITE_MULTIPLE_REGS;
+    mb->tx_buffer[tx_index++] = (start_addr >> 8) & 0xFF;
+    mb->tx_buffer[tx_index++] = start_addr & 0xFF;
+    mb->tx_buffer[tx_index++] = (quantity >> 8) & 0xFF;
+    mb->tx_buffer[tx_index++] = quantity & 0xFF;
+
+    tx_index = Modbus_AppendCRC(mb, tx_index);
+
+    Modbus_SendResponse(mb, tx_index);
+}
+
+/**
+ * Handle Read/Write Multiple Registers (Function 0x17)
+ * The write is applied before the read, so a master can set outputs and
+ * read back the measurement block in one exchange.
+ */
+static void Modbus_HandleReadWriteMultiple(Modbus_HandleTypeDef *mb) {
+    // Request: Address(1) + Function(1) + ReadStart(2) + ReadQty(2) + WriteStart(2)
+    //          + WriteQty(2) + ByteCount(1) + Data(N) + CRC(2)
+    if (mb->rx_index < 15) {
+        Modbus_SendException(mb, MODBUS_FC_READ_WRITE_MULTIPLE, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    uint16_t read_start = (mb->rx_buffer[2] << 8) | mb->rx_buffer[3];
+    uint16_t read_qty = (mb->rx_buffer[4] << 8) | mb->rx_buffer[5];
+    uint16_t write_start = (mb->rx_buffer[6] << 8) | mb->rx_buffer[7];
+    uint16_t write_qty = (mb->rx_buffer[8] << 8) | mb->rx_buffer[9];
+    uint8_t byte_count = mb->rx_buffer[10];
+
+    // Validate request
+    if (read_qty == 0 || read_qty > MODBUS_MAX_READ_REGS ||
+        write_qty == 0 || write_qty > MODBUS_MAX_RW_WRITE_REGS ||
+        byte_count != write_qty * 2 || mb->rx_index != 13 + byte_count) {
+        Modbus_SendException(mb, MODBUS_FC_READ_WRITE_MULTIPLE, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    if (read_start + read_qty > mb->holding_reg_count ||
+        write_start + write_qty > mb->holding_reg_count) {
+        Modbus_SendException(mb, MODBUS_FC_READ_WRITE_MULTIPLE, MODBUS_EX_ILLEGAL_ADDRESS);
+        return;
+    }
+
+    if (!Modbus_WriteRegisters(mb, write_start, write_qty, &mb->rx_buffer[11])) {
+        Modbus_SendException(mb, MODBUS_FC_READ_WRITE_MULTIPLE, MODBUS_EX_ILLEGAL_ADDRESS);
+        return;
+    }
+
+    // A broadcast applies the write but has no one to read back to
+    if (mb->broadcast) {
+        return;
+    }
+
+    // Response: Address + Function + ByteCount + Data + CRC
+    uint16_t tx_index = 0;
+    mb->tx_buffer[tx_index++] = mb->slave_address;
+    mb->tx_buffer[tx_index++] = MODBUS_FC_READ_WRITE_MULTIPLE;
+    mb->tx_buffer[tx_index++] = read_qty * 2;
+
+    tx_index = Modbus_PutRegisters(mb, tx_index, read_start, read_qty);
+    tx_index = Modbus_AppendCRC(mb, tx_index);
+
+    Modbus_SendResponse(mb, tx_index);
+}
+
+/**
+ * Handle Read Device Identification (Function 0x2B, MEI 0x0E)
+ * Supports basic stream access (01) and individual access (04).
+ * All basic objects fit in one response, so "more follows" is always 0.
+ */
+static void Modbus_HandleReadDeviceId(Modbus_HandleTypeDef *mb) {
+    // Request: Address(1) + Function(1) + MEI(1) + ReadDevIdCode(1) + ObjectId(1) + CRC(2) = 7 bytes
+    if (mb->rx_index < 7 || mb->rx_buffer[2] != MODBUS_MEI_DEVICE_ID) {
+        Modbus_SendException(mb, MODBUS_FC_ENCAPSULATED, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    uint8_t code = mb->rx_buffer[3];
+    uint8_t object_id = mb->rx_buffer[4];
+
+    if (code != MODBUS_DEVID_BASIC && code != MODBUS_DEVID_SPECIFIC) {
+        Modbus_SendException(mb, MODBUS_FC_ENCAPSULATED, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    // Basic stream restarts at 0 for an unknown start object
+    if (object_id >= MODBUS_DEVID_OBJ_COUNT) {
+        if (code == MODBUS_DEVID_SPECIFIC) {
+            Modbus_SendException(mb, MODBUS_FC_ENCAPSULATED, MODBUS_EX_ILLEGAL_ADDRESS);
+            return;
+        }
+        object_id = 0;
+    }
+
+    uint8_t last_id = (code == MODBUS_DEVID_SPECIFIC) ? object_id : MODBUS_DEVID_OBJ_COUNT - 1;
+
+    uint16_t tx_index = 0;
+    mb->tx_buffer[tx_index++] = mb->slave_address;
+    mb->tx_buffer[tx_index++] = MODBUS_FC_ENCAPSULATED;
+    mb->tx_buffer[tx_index++] = MODBUS_MEI_DEVICE_ID;
+    mb->tx_buffer[tx_index++] = code;
+    mb->tx_buffer[tx_index++] = MODBUS_DEVID_CONFORMITY;    // Conformity level
+    mb->tx_buffer[tx_index++] = 0x00;                       // More follows
+    mb->tx_buffer[tx_index++] = 0x00;                       // Next object ID
+    mb->tx_buffer[tx_index++] = last_id - object_id + 1;    // Number of objects
+
+    for (uint8_t id = object_id; id <= last_id; id++) {
+        const char *value = mb->device_id[id] ? mb->device_id[id] : "";
+        uint8_t len = (uint8_t)strlen(value);
+
+        mb->tx_buffer[tx_index++] = id;
+        mb->tx_buffer[tx_index++] = len;
+        memcpy(&mb->tx_buffer[tx_index], value, len);
+        tx_index += len;
+    }
+
+    tx_index = Modbus_AppendCRC(mb, tx_index);
 
     Modbus_SendResponse(mb, tx_index);
 }
@@ -314,3 +660,58 @@ static void Modbus_HandleWriteSingleRegister(Modbus_HandleTypeDef *mb) {
 void Modbus_SetWriteCallback(Modbus_HandleTypeDef *mb, Modbus_WriteCallback callback) {
     mb->write_callback = callback;
 }
+
+/**
+ * Set writable check function
+ * Without one every holding register accepts writes.
+ */
+void Modbus_SetWritableCallback(Modbus_HandleTypeDef *mb, Modbus_WritableCallback callback) {
+    mb->writable_callback = callback;
+}
+
+/**
+ * Set read callback function
+ */
+void Modbus_SetReadCallback(Modbus_HandleTypeDef *mb, Modbus_ReadCallback callback) {
+    mb->read_callback = callback;
+}
+
+/**
+ * Handle an application-defined function code
+ * The handler builds the response PDU directly in tx_buffer.
+ */
+static void Modbus_HandleCustomFunction(Modbus_HandleTypeDef *mb, uint8_t function) {
+    // PDU excludes Address(1) and CRC(2); response leaves room for both
+    uint16_t pdu_len = mb->rx_index - 3;
+    uint16_t length = mb->custom_handler(&mb->rx_buffer[1], pdu_len,
+                                         &mb->tx_buffer[1], MODBUS_TX_BUFFER_SIZE - 3);
+
+    if (length == 0) {
+        Modbus_SendException(mb, function, MODBUS_EX_ILLEGAL_VALUE);
+        return;
+    }
+
+    mb->tx_buffer[0] = mb->slave_address;
+    uint16_t tx_index = Modbus_AppendCRC(mb, length + 1);
+
+    Modbus_SendResponse(mb, tx_index);
+}
+
+/**
+ * Register a handler for one application-defined function code
+ */
+void Modbus_SetFunctionHandler(Modbus_HandleTypeDef *mb, uint8_t function,
+                               Modbus_FunctionHandler handler) {
+    mb->custom_function = function;
+    mb->custom_handler = handler;
+}
+
+/**
+ * Set Read Device Identification strings (must outlive the handle)
+ */
+void Modbus_SetDeviceId(Modbus_HandleTypeDef *mb, const char *vendor,
+                        const char *product, const char *revision) {
+    mb->device_id[MODBUS_DEVID_OBJ_VENDOR] = vendor;
+    mb->device_id[MODBUS_DEVID_OBJ_PRODUCT] = product;
+    mb->device_id[MODBUS_DEVID_OBJ_REVISION] = revision;
+}
@@ -4,12 +4,20 @@
  */
 
 #include "scd40.h"
+#include "i2c_bus.h"
 
 /* Private function prototypes */
 static bool SCD40_SendCommand(SCD40_HandleTypeDef *scd, uint16_t cmd);
 static bool SCD40_SendCommandWithArg(SCD40_HandleTypeDef *scd, uint16_t cmd, uint16_t arg);
 static bool SCD40_ReadResponse(SCD40_HandleTypeDef *scd, uint16_t *data, uint8_t num_words);
 static uint8_t SCD40_CalcCRC(uint8_t *data, uint8_t len);
+static bool SCD40_ParseWords(uint8_t *buf, uint16_t *data, uint8_t num_words);
+static void SCD40_ConvertMeasurement(SCD40_HandleTypeDef *scd, const uint16_t *data);
+static bool SCD40_SubmitCommandRead(SCD40_HandleTypeDef *scd, uint16_t cmd, uint8_t num_words,
+                                    I2CBus_Callback callback);
+static void SCD40_CommandWritten(void *context, bool success);
+static void SCD40_DataReadyDone(void *context, bool success);
+static void SCD40_MeasurementDone(void *context, bool success);
 
 /**
  * Calculate CRC-8 (polynomial 0x31, init 0xFF)
@@ -66,6 +74,13 @@ static bool SCD40_ReadResponse(SCD40_HandleTypeDef *scd, uint16_t *data, uint8_t
         return false;
     }
 
+    return SCD40_ParseWords(buf, data, num_words);
+}
+
+/**
+ * Split response into 16-bit words, verifying each word's CRC
+ */
+static bool SCD40_ParseWords(uint8_t *buf, uint16_t *data, uint8_t num_words) {
     // Parse and verify CRC for each word
     for (uint8_t i = 0; i < num_words; i++) {
         uint8_t *word_data = &buf[i * 3];
@@ -91,6 +106,8 @@ bool SCD40_Init(SCD40_HandleTypeDef *scd, I2C_HandleTypeDef *hi2c) {
     scd->co2_ppm = 0;
     scd->temperature_x100 = 0;
     scd->humidity_x100 = 0;
+    scd->busy = false;
+    scd->new_data = false;
 
     // Stop any ongoing measurement
     SCD40_StopPeriodicMeasurement(scd);
@@ -179,6 +196,105 @@ bool SCD40_ReadMeasurement(SCD40_HandleTypeDef *scd) {
         return false;
     }
 
+    SCD40_ConvertMeasurement(scd, data);
+    return true;
+}
+
+/**
+ * Start a data-ready check and, if ready, a measurement read without blocking
+ * Check for the result with SCD40_HasNewData().
+ */
+bool SCD40_ReadMeasurementAsync(SCD40_HandleTypeDef *scd) {
+    if (scd->busy) {
+        return false;
+    }
+
+    if (!SCD40_SubmitCommandRead(scd, SCD40_CMD_GET_DATA_READY_STATUS, 1, SCD40_DataReadyDone)) {
+        return false;
+    }
+
+    scd->busy = true;
+    return true;
+}
+
+/**
+ * Check for (and consume) a completed async reading
+ */
+bool SCD40_HasNewData(SCD40_HandleTypeDef *scd) {
+    bool ready = scd->new_data;
+    scd->new_data = false;
+    return ready;
+}
+
+/**
+ * Queue a command write; its completion queues the response read
+ */
+static bool SCD40_SubmitCommandRead(SCD40_HandleTypeDef *scd, uint16_t cmd, uint8_t num_words,
+                                    I2CBus_Callback callback) {
+    I2CBus_HandleTypeDef *bus = I2CBus_Get(scd->hi2c);
+    uint8_t buf[2];
+
+    buf[0] = (cmd >> 8) & 0xFF;
+    buf[1] = cmd & 0xFF;
+
+    scd->rx_words = num_words;
+    scd->rx_callback = callback;
+
+    return I2CBus_Write(bus, scd->address, buf, 2, 0, SCD40_CommandWritten, scd);
+}
+
+/**
+ * Command write completion - read the response, or report the failure
+ */
+static void SCD40_CommandWritten(void *context, bool success) {
+    SCD40_HandleTypeDef *scd = (SCD40_HandleTypeDef *)context;
+
+    // The SCD40 needs at least 1ms between command and read; with a 1ms tick
+    // a 1ms gap can elapse almost at once, so ask for 2
+    if (success && I2CBus_Read(I2CBus_Get(scd->hi2c), scd->address, scd->rx_buf,
+                               scd->rx_words * 3, 2, scd->rx_callback, scd)) {
+        return;
+    }
+
+    scd->rx_callback(scd, false);
+}
+
+/**
+ * Data-ready status completion - chain the measurement read if ready
+ */
+static void SCD40_DataReadyDone(void *context, bool success) {
+    SCD40_HandleTypeDef *scd = (SCD40_HandleTypeDef *)context;
+    uint16_t status;
+
+    // Lower 11 bits indicate data ready if non-zero
+    if (success && SCD40_ParseWords(scd->rx_buf, &status, 1) && (status & 0x07FF) != 0) {
+        if (SCD40_SubmitCommandRead(scd, SCD40_CMD_READ_MEASUREMENT, 3, SCD40_MeasurementDone)) {
+            return;
+        }
+    }
+
+    scd->busy = false;
+}
+
+/**
+ * Measurement read completion
+ */
+static void SCD40_MeasurementDone(void *context, bool success) {
+    SCD40_HandleTypeDef *scd = (SCD40_HandleTypeDef *)context;
+    uint16_t data[3];
+
+    scd->busy = false;
+
+    if (success && SCD40_ParseWords(scd->rx_buf, data, 3)) {
+        SCD40_ConvertMeasurement(scd, data);
+        scd->new_data = true;
+    }
+}
+
+/**
+ * Convert raw measurement words to engineering units
+ */
+static void SCD40_ConvertMeasurement(SCD40_HandleTypeDef *scd, const uint16_t *data) {
     scd->raw_co2 = data[0];
     scd->raw_temp = data[1];
     scd->raw_hum = data[2];
@@ -194,8 +310,6 @@ bool SCD40_ReadMeasurement(SCD40_HandleTypeDef *scd) {
     // Humidity: 100 * raw / 65535 (in %RH)
     // For x100: 10000 * raw / 65535
     scd->humidity_x100 = (uint16_t)(((uint32_t)scd->raw_hum * 10000) / 65535);
-
-    return true;
 }
 
 /**
@@ -9,10 +9,57 @@
 #include "bh1750.h"
 #include "scd40.h"
 #include "atlas_ezo.h"
+#include "i2c_bus.h"
+#include "history.h"
 
 /* Private variables */
 static SensorHub_Config_t *hub_config;
-static uint16_t holding_registers[HOLDING_REG_COUNT];
+static uint16_t holding_registers[HOLDING_REG_COUNT];   // Live bank (served by Modbus)
+static uint16_t staging_registers[HOLDING_REG_COUNT];   // Work bank (written by sensor tasks)
+static bool staging_dirty = false;
+
+/* Report-by-exception channels - bit n of REG_CHANGE_MAP is channel n.
+   A channel is flagged when it moves more than its deadband away from
+   the value it was last flagged at; deadbands power up to these defaults
+   and can be rewritten at REG_DEADBAND_BASE + n. */
+typedef struct {
+    uint8_t reg;                // Value register (HI word if wide)
+    bool wide;                  // 32-bit HI/LO pair
+    uint16_t deadband;          // Default, raw register units
+} ChangeChannel_t;
+
+static const ChangeChannel_t change_channels[CHANGE_CHANNEL_COUNT] = {
+    { REG_CHANNEL_1,     false, 8   },  // 4-20mA 1, ADC counts
+    { REG_CHANNEL_2,     false, 8   },  // 4-20mA 2
+    { REG_CHANNEL_3,     false, 8   },  // 0-10V 1
+    { REG_CHANNEL_4,     false, 8   },  // 0-10V 2
+    { REG_CHANNEL_5,     false, 10  },  // BME280 #1 temp, 0.1C
+    { REG_CHANNEL_6,     false, 50  },  // BME280 #1 humidity, 0.5%
+    { REG_CHANNEL_7,     false, 10  },  // BME280 #2 temp
+    { REG_CHANNEL_8,     false, 50  },  // BME280 #2 humidity
+    { REG_DI_STATUS,     false, 0   },  // Digital inputs, any change
+    { REG_BH1750_LUX_HI, true,  100 },  // Lux, 1 lx
+    { REG_SCD40_CO2,     false, 10  },  // CO2, 10 ppm
+    { REG_SCD40_TEMP,    false, 10  },  // SCD40 temp
+    { REG_SCD40_HUM,     false, 50  },  // SCD40 humidity
+    { REG_ATLAS_PH,      false, 2   },  // pH, 0.02
+    { REG_ATLAS_EC_HI,   true,  10  },  // EC, 10 uS/cm
+};
+static uint32_t change_reference[CHANGE_CHANNEL_COUNT];
+#define CHANGE_MAP_ALL      ((1u << CHANGE_CHANNEL_COUNT) - 1)
+
+/* Scheduler timing (see SensorHub_TaskDiag) */
+static Diag_Stat_t loop_time;                   // SensorHub_Update() passes
+static volatile bool diag_reset_pending = false;
+
+/* Analog inputs - filled continuously by ADC1 scan + circular DMA,
+   in scan rank order (see MX_ADC1_Init) */
+#define ADC_SCAN_4_20MA_1   0
+#define ADC_SCAN_4_20MA_2   1
+#define ADC_SCAN_0_10V_1    2
+#define ADC_SCAN_0_10V_2    3
+#define ADC_SCAN_COUNT      4
+static volatile uint16_t adc_scan[ADC_SCAN_COUNT];
 
 /* I2C Sensors */
 static BME280_HandleTypeDef bme280_1;
@@ -32,6 +79,34 @@ static bool atlas_ph_present = false;
 static AtlasEZO_HandleTypeDef atlas_ec;
 static bool atlas_ec_present = false;
 
+/* Sensor task table */
+static void SensorHub_TaskAnalog(void);
+static void SensorHub_TaskDigital(void);
+static void SensorHub_TaskBME280_1(void);
+static void SensorHub_TaskBME280_2(void);
+static void SensorHub_TaskBH1750(void);
+static void SensorHub_TaskSCD40(void);
+static void SensorHub_TaskAtlas(void);
+static void SensorHub_TaskHistory(void);
+static void SensorHub_TaskDiag(void);
+static void SensorHub_PublishReadings(void);
+static void SensorHub_StageRegister(uint16_t reg, uint16_t value);
+static void SensorHub_PublishRegisters(void);
+static uint16_t SensorHub_DetectChanges(void);
+
+// Periods follow each sensor's natural update rate
+static SensorTask_t sensor_tasks[SENSOR_TASK_COUNT] = {
+    [SENSOR_TASK_ANALOG]   = { .run = SensorHub_TaskAnalog,   .period_ms = 100,  .deadline_ms = 1 },  // Copies DMA scan results
+    [SENSOR_TASK_DIGITAL]  = { .run = SensorHub_TaskDigital,  .period_ms = 50,   .deadline_ms = 1 },
+    [SENSOR_TASK_BME280_1] = { .run = SensorHub_TaskBME280_1, .period_ms = 1000, .deadline_ms = 5 },  // Normal mode, 1s standby
+    [SENSOR_TASK_BME280_2] = { .run = SensorHub_TaskBME280_2, .period_ms = 1000, .deadline_ms = 5 },
+    [SENSOR_TASK_BH1750]   = { .run = SensorHub_TaskBH1750,   .period_ms = 120,  .deadline_ms = 5 },  // H-res conversion time
+    [SENSOR_TASK_SCD40]    = { .run = SensorHub_TaskSCD40,    .period_ms = 5000, .deadline_ms = 10 }, // Periodic measurement interval
+    [SENSOR_TASK_ATLAS]    = { .run = SensorHub_TaskAtlas,    .period_ms = 100,  .deadline_ms = 10 }, // Collect poll, ~1Hz readings
+    [SENSOR_TASK_HISTORY]  = { .run = SensorHub_TaskHistory,  .period_ms = HISTORY_INTERVAL_MS, .deadline_ms = 1 },
+    [SENSOR_TASK_DIAG]     = { .run = SensorHub_TaskDiag,     .period_ms = 1000, .deadline_ms = 1 },
+};
+
 /* ADC calibration values */
 // For 4-20mA with 150Ω shunt: V = I * R
 // At 4mA:  V = 0.004 * 150 = 0.6V
@@ -55,8 +130,11 @@ static bool atlas_ec_present = false;
 
 /* Firmware version */
 #define FW_VERSION_MAJOR    1
-#define FW_VERSION_MINOR    1
+#define FW_VERSION_MINOR    3
 #define FW_VERSION          ((FW_VERSION_MAJOR << 8) | FW_VERSION_MINOR)
+#define FW_STR_(x)          #x
+#define FW_STR(x)           FW_STR_(x)
+#define FW_REVISION_STRING  "V" FW_STR(FW_VERSION_MAJOR) "." FW_STR(FW_VERSION_MINOR)
 
 /**
  * Initialize Sensor Hub
@@ -67,15 +145,30 @@ void SensorHub_Init(SensorHub_Config_t *config) {
     // Clear registers
     for (int i = 0; i < HOLDING_REG_COUNT; i++) {
         holding_registers[i] = 0;
+        staging_registers[i] = 0;
     }
 
     // Set static registers
     holding_registers[REG_HUB_ID] = 0x5248;  // "RH" for SpRig Hub
     holding_registers[REG_FW_VERSION] = FW_VERSION;
 
-    // Calibrate ADC if available
+    // Deadband defaults; every channel starts flagged so the master's
+    // first read of the change map fetches everything
+    for (int i = 0; i < CHANGE_CHANNEL_COUNT; i++) {
+        holding_registers[REG_DEADBAND_BASE + i] = change_channels[i].deadband;
+        change_reference[i] = 0;
+    }
+    holding_registers[REG_CHANGE_MAP] = CHANGE_MAP_ALL;
+
+    // Calibrate ADC, then start the timer-triggered DMA scan. The DMA
+    // and ADC interrupts HAL enables here are left masked in the NVIC,
+    // so sampling costs no CPU time.
     if (hub_config->hadc) {
         HAL_ADCEx_Calibration_Start(hub_config->hadc, ADC_SINGLE_ENDED);
+        HAL_ADC_Start_DMA(hub_config->hadc, (uint32_t *)adc_scan, ADC_SCAN_COUNT);
+        if (hub_config->htim_adc) {
+            HAL_TIM_Base_Start(hub_config->htim_adc);
+        }
     }
 
     // Initialize BME280 on I2C1 (try both addresses)
@@ -118,6 +211,39 @@ void SensorHub_Init(SensorHub_Config_t *config) {
             bme280_2_present = true;
         }
     }
+
+    // Sensor detection above uses blocking transfers; from here on the
+    // buses belong to the async engine
+    if (hub_config->hi2c1) {
+        I2CBus_Init(hub_config->hi2c1);
+    }
+    if (hub_config->hi2c2) {
+        I2CBus_Init(hub_config->hi2c2);
+    }
+
+    // Enable tasks for detected sensors and stagger first runs so
+    // tasks with equal periods don't all fall due on the same tick
+    sensor_tasks[SENSOR_TASK_ANALOG].enabled = (hub_config->hadc != NULL);
+    sensor_tasks[SENSOR_TASK_DIGITAL].enabled = true;
+    sensor_tasks[SENSOR_TASK_BME280_1].enabled = bme280_1_present;
+    sensor_tasks[SENSOR_TASK_BME280_2].enabled = bme280_2_present;
+    sensor_tasks[SENSOR_TASK_BH1750].enabled = bh1750_present;
+    sensor_tasks[SENSOR_TASK_SCD40].enabled = scd40_present;
+    sensor_tasks[SENSOR_TASK_ATLAS].enabled = atlas_ph_present || atlas_ec_present;
+    sensor_tasks[SENSOR_TASK_HISTORY].enabled = true;
+    sensor_tasks[SENSOR_TASK_DIAG].enabled = true;
+
+    History_Init();
+
+    uint32_t now = HAL_GetTick();
+    for (int i = 0; i < SENSOR_TASK_COUNT; i++) {
+        sensor_tasks[i].next_due = now + (i * 10);
+        Diag_StatReset(&sensor_tasks[i].exec);
+    }
+    Diag_StatReset(&loop_time);
+
+    // First snapshot once sensors have had a full interval to settle
+    sensor_tasks[SENSOR_TASK_HISTORY].next_due = now + HISTORY_INTERVAL_MS;
 }
 
 /**
@@ -170,78 +296,36 @@ uint8_t SensorHub_ReadDigitalInputs(void) {
     return inputs;
 }
 
-/**
- * Read ADC value for a specific channel
- */
-static uint16_t SensorHub_ReadADC(uint32_t channel) {
-    if (!hub_config->hadc) {
-        return 0;
-    }
-
-    ADC_ChannelConfTypeDef sConfig = {0};
-    sConfig.Channel = channel;
-    sConfig.Rank = ADC_REGULAR_RANK_1;
-    sConfig.SamplingTime = ADC_SAMPLETIME_47CYCLES_5;
-    sConfig.SingleDiff = ADC_SINGLE_ENDED;
-    sConfig.OffsetNumber = ADC_OFFSET_NONE;
-
-    if (HAL_ADC_ConfigChannel(hub_config->hadc, &sConfig) != HAL_OK) {
-        return 0;
-    }
-
-    HAL_ADC_Start(hub_config->hadc);
-    if (HAL_ADC_PollForConversion(hub_config->hadc, 10) == HAL_OK) {
-        uint16_t value = HAL_ADC_GetValue(hub_config->hadc);
-        HAL_ADC_Stop(hub_config->hadc);
-        return value;
-    }
-
-    HAL_ADC_Stop(hub_config->hadc);
-    return 0;
-}
-
 /**
  * Read 4-20mA input
  * channel: 0 or 1
- * Returns raw ADC value (0-4095)
+ * Returns the latest oversampled ADC value (0-4095)
  */
 uint16_t SensorHub_ReadADC_4_20mA(uint8_t channel) {
-    uint32_t adc_channel;
-
     switch (channel) {
         case 0:
-            adc_channel = ADC_CHANNEL_1;  // PA0
-            break;
+            return adc_scan[ADC_SCAN_4_20MA_1];  // PA0
         case 1:
-            adc_channel = ADC_CHANNEL_15; // PB0
-            break;
+            return adc_scan[ADC_SCAN_4_20MA_2];  // PB0
         default:
             return 0;
     }
-
-    return SensorHub_ReadADC(adc_channel);
 }
 
 /**
  * Read 0-10V input
  * channel: 0 or 1
- * Returns raw ADC value (0-4095)
+ * Returns the latest oversampled ADC value (0-4095)
  */
 uint16_t SensorHub_ReadADC_0_10V(uint8_t channel) {
-    uint32_t adc_channel;
-
     switch (channel) {
         case 0:
-            adc_channel = ADC_CHANNEL_12; // PB1 - ADC1_IN12
-            break;
+            return adc_scan[ADC_SCAN_0_10V_1];   // PB1 - ADC1_IN12
         case 1:
-            adc_channel = ADC_CHANNEL_11; // PB2 - ADC1_IN11 (Note: PB2 is ADC2_IN12, but also ADC1_IN11)
-            break;
+            return adc_scan[ADC_SCAN_0_10V_2];   // PB2 - ADC1_IN11
         default:
             return 0;
     }
-
-    return SensorHub_ReadADC(adc_channel);
 }
 
 /**
@@ -282,83 +366,366 @@ uint16_t SensorHub_ConvertVoltage_mV(uint16_t adc_value) {
 }
 
 /**
- * Update all sensor readings and populate Modbus registers
- * Call this periodically from main loop
+ * Analog inputs task
+ * Publishes the DMA-scanned values (256x oversampled, refreshed at 100Hz);
+ * the SprigRig app applies calibration
  */
-void SensorHub_Update(void) {
-    // Channel 1-2: 4-20mA inputs (store as raw ADC or converted value)
-    // For compatibility with SprigRig app, store raw 16-bit value
-    // The app applies calibration on its side
-    holding_registers[REG_CHANNEL_1] = SensorHub_ReadADC_4_20mA(0);
-    holding_registers[REG_CHANNEL_2] = SensorHub_ReadADC_4_20mA(1);
+static void SensorHub_TaskAnalog(void) {
+    // Channel 1-2: 4-20mA inputs
+    SensorHub_StageRegister(REG_CHANNEL_1, SensorHub_ReadADC_4_20mA(0));
+    SensorHub_StageRegister(REG_CHANNEL_2, SensorHub_ReadADC_4_20mA(1));
 
     // Channel 3-4: 0-10V inputs
-    holding_registers[REG_CHANNEL_3] = SensorHub_ReadADC_0_10V(0);
-    holding_registers[REG_CHANNEL_4] = SensorHub_ReadADC_0_10V(1);
-
-    // Channel 5-6: BME280 sensors on I2C
-    // Channel 5: Temperature (°C * 100) from BME280 #1
-    // Channel 6: Humidity (%RH * 100) from BME280 #1
-    if (bme280_1_present) {
-        if (BME280_ReadAll(&bme280_1)) {
-            holding_registers[REG_CHANNEL_5] = (uint16_t)BME280_GetTemperature_x100(&bme280_1);
-            holding_registers[REG_CHANNEL_6] = BME280_GetHumidity_x100(&bme280_1);
-        }
+    SensorHub_StageRegister(REG_CHANNEL_3, SensorHub_ReadADC_0_10V(0));
+    SensorHub_StageRegister(REG_CHANNEL_4, SensorHub_ReadADC_0_10V(1));
+}
+
+/**
+ * Digital inputs task
+ */
+static void SensorHub_TaskDigital(void) {
+    SensorHub_StageRegister(REG_DI_STATUS, SensorHub_ReadDigitalInputs());
+}
+
+/*
+ * I2C sensor tasks only queue transfers on the async bus engine and
+ * return; results are staged by SensorHub_PublishReadings() once the
+ * transfers complete.
+ */
+
+/**
+ * BME280 #1 task
+ */
+static void SensorHub_TaskBME280_1(void) {
+    BME280_ReadAllAsync(&bme280_1);
+}
+
+/**
+ * BME280 #2 task (I2C2)
+ */
+static void SensorHub_TaskBME280_2(void) {
+    BME280_ReadAllAsync(&bme280_2);
+}
+
+/**
+ * BH1750 lux task
+ */
+static void SensorHub_TaskBH1750(void) {
+    BH1750_ReadLightAsync(&bh1750);
+}
+
+/**
+ * SCD40 CO2/Temp/Hum task
+ */
+static void SensorHub_TaskSCD40(void) {
+    SCD40_ReadMeasurementAsync(&scd40);
+}
+
+/**
+ * Atlas EZO pH / EC task
+ * Split-phase: each poll either triggers a reading or collects one that
+ * has finished converting, so both probes run in parallel and the loop
+ * never sits in the ~900ms conversion delay.
+ */
+static void SensorHub_TaskAtlas(void) {
+    if (atlas_ph_present) {
+        AtlasEZO_Poll(&atlas_ph);
     }
 
-    // Channel 7-8: BME280 sensor #2 on I2C2
-    // Channel 7: Temperature (°C * 100) from BME280 #2
-    // Channel 8: Humidity (%RH * 100) from BME280 #2
-    if (bme280_2_present) {
-        if (BME280_ReadAll(&bme280_2)) {
-            holding_registers[REG_CHANNEL_7] = (uint16_t)BME280_GetTemperature_x100(&bme280_2);
-            holding_registers[REG_CHANNEL_8] = BME280_GetHumidity_x100(&bme280_2);
-        }
+    if (atlas_ec_present) {
+        AtlasEZO_Poll(&atlas_ec);
+    }
+}
+
+/**
+ * Copy completed async readings into holding registers
+ * Only checks driver flags - no bus traffic.
+ */
+static void SensorHub_PublishReadings(void) {
+    // Channel 5-6: BME280 #1 Temperature (°C * 100), Humidity (%RH * 100)
+    if (bme280_1_present && BME280_HasNewData(&bme280_1)) {
+        SensorHub_StageRegister(REG_CHANNEL_5, (uint16_t)BME280_GetTemperature_x100(&bme280_1));
+        SensorHub_StageRegister(REG_CHANNEL_6, BME280_GetHumidity_x100(&bme280_1));
     }
 
-    // Digital inputs status
-    holding_registers[REG_DI_STATUS] = SensorHub_ReadDigitalInputs();
+    // Channel 7-8: BME280 #2 Temperature (°C * 100), Humidity (%RH * 100)
+    if (bme280_2_present && BME280_HasNewData(&bme280_2)) {
+        SensorHub_StageRegister(REG_CHANNEL_7, (uint16_t)BME280_GetTemperature_x100(&bme280_2));
+        SensorHub_StageRegister(REG_CHANNEL_8, BME280_GetHumidity_x100(&bme280_2));
+    }
 
-    // --- Extended Sensors ---
+    if (bh1750_present && BH1750_HasNewData(&bh1750)) {
+        uint32_t lux = BH1750_GetLux_x100(&bh1750);
+        SensorHub_StageRegister(REG_BH1750_LUX_HI, (uint16_t)((lux >> 16) & 0xFFFF));
+        SensorHub_StageRegister(REG_BH1750_LUX_LO, (uint16_t)(lux & 0xFFFF));
+    }
 
-    // BH1750 Lux
-    if (bh1750_present) {
-        if (BH1750_ReadLight(&bh1750)) {
-            uint32_t lux = BH1750_GetLux_x100(&bh1750);
-            holding_registers[REG_BH1750_LUX_HI] = (uint16_t)((lux >> 16) & 0xFFFF);
-            holding_registers[REG_BH1750_LUX_LO] = (uint16_t)(lux & 0xFFFF);
-        }
+    if (scd40_present && SCD40_HasNewData(&scd40)) {
+        SensorHub_StageRegister(REG_SCD40_CO2, SCD40_GetCO2(&scd40));
+        SensorHub_StageRegister(REG_SCD40_TEMP, (uint16_t)SCD40_GetTemperature_x100(&scd40));
+        SensorHub_StageRegister(REG_SCD40_HUM, SCD40_GetHumidity_x100(&scd40));
     }
 
-    // SCD40 CO2/Temp/Hum
-    if (scd40_present) {
-        if (SCD40_IsDataReady(&scd40)) {
-            if (SCD40_ReadMeasurement(&scd40)) {
-                holding_registers[REG_SCD40_CO2] = SCD40_GetCO2(&scd40);
-                holding_registers[REG_SCD40_TEMP] = (uint16_t)SCD40_GetTemperature_x100(&scd40);
-                holding_registers[REG_SCD40_HUM] = SCD40_GetHumidity_x100(&scd40);
+    if (atlas_ph_present && AtlasEZO_HasNewData(&atlas_ph)) {
+        SensorHub_StageRegister(REG_ATLAS_PH, AtlasEZO_pH_GetValue_x100(&atlas_ph));
+    }
+
+    if (atlas_ec_present && AtlasEZO_HasNewData(&atlas_ec)) {
+        uint32_t ec = (uint32_t)AtlasEZO_EC_GetEC(&atlas_ec);
+        SensorHub_StageRegister(REG_ATLAS_EC_HI, (uint16_t)((ec >> 16) & 0xFFFF));
+        SensorHub_StageRegister(REG_ATLAS_EC_LO, (uint16_t)(ec & 0xFFFF));
+    }
+}
+
+/**
+ * History task
+ * Records the published bank, so every record is a consistent snapshot.
+ */
+static void SensorHub_TaskHistory(void) {
+    History_Record(holding_registers);
+
+    uint32_t seq = History_GetNewestSeq();
+    SensorHub_StageRegister(REG_HIST_SEQ_HI, (uint16_t)((seq >> 16) & 0xFFFF));
+    SensorHub_StageRegister(REG_HIST_SEQ_LO, (uint16_t)(seq & 0xFFFF));
+}
+
+/**
+ * Diagnostics task
+ * Copies timing and error statistics into the diagnostics register
+ * block. These are written straight to the live bank, since they are
+ * independent counters, not a sample, and must not bump REG_SAMPLE_SEQ.
+ */
+static void SensorHub_TaskDiag(void) {
+    Modbus_HandleTypeDef *mb = hub_config->modbus;
+    I2CBus_HandleTypeDef *bus1 = I2CBus_Get(hub_config->hi2c1);
+    I2CBus_HandleTypeDef *bus2 = I2CBus_Get(hub_config->hi2c2);
+
+    if (diag_reset_pending) {
+        diag_reset_pending = false;
+
+        for (int i = 0; i < SENSOR_TASK_COUNT; i++) {
+            Diag_StatReset(&sensor_tasks[i].exec);
+            sensor_tasks[i].late_max_ms = 0;
+            sensor_tasks[i].overruns = 0;
+        }
+        Diag_StatReset(&loop_time);
+
+        I2CBus_HandleTypeDef *buses[] = { bus1, bus2 };
+        for (int i = 0; i < 2; i++) {
+            if (buses[i] != NULL) {
+                buses[i]->error_count = 0;
+                buses[i]->timeout_count = 0;
+                Diag_StatReset(&buses[i]->transfer_time);
             }
         }
+
+        // Modbus counters are updated from interrupts
+        if (mb != NULL) {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            mb->crc_error_count = 0;
+            mb->overrun_count = 0;
+            Diag_StatReset(&mb->turnaround);
+            __set_PRIMASK(primask);
+        }
+
+        holding_registers[REG_DIAG_RESET] = 0;
     }
 
-    // Atlas EZO pH
-    if (atlas_ph_present) {
-        // Trigger reading (Atlas sensors need time, this is a simple blocking approach which might be slow)
-        // Better approach: Trigger in one loop, read in next. For now, we assume continuous or fast enough.
-        // Actually, Atlas EZO I2C default is sleep-to-wake-to-read.
-        if (AtlasEZO_ReadValue(&atlas_ph)) {
-            holding_registers[REG_ATLAS_PH] = AtlasEZO_pH_GetValue_x100(&atlas_ph);
+    uint32_t jitter_ms = 0;
+    for (int i = 0; i < SENSOR_TASK_COUNT; i++) {
+        const SensorTask_t *task = &sensor_tasks[i];
+        uint16_t *regs = &holding_registers[REG_DIAG_TASK_BASE + i * REG_DIAG_TASK_REGS];
+
+        regs[0] = task->exec.count ? Diag_Clamp16(task->exec.min_us) : 0;
+        regs[1] = Diag_Clamp16(Diag_StatAvg(&task->exec));
+        regs[2] = Diag_Clamp16(task->exec.max_us);
+        regs[3] = Diag_Clamp16(task->overruns);
+
+        if (task->late_max_ms > jitter_ms) {
+            jitter_ms = task->late_max_ms;
         }
     }
 
-    // Atlas EZO EC
-    if (atlas_ec_present) {
-        if (AtlasEZO_ReadValue(&atlas_ec)) {
-            uint32_t ec = (uint32_t)AtlasEZO_EC_GetEC(&atlas_ec);
-            holding_registers[REG_ATLAS_EC_HI] = (uint16_t)((ec >> 16) & 0xFFFF);
-            holding_registers[REG_ATLAS_EC_LO] = (uint16_t)(ec & 0xFFFF);
+    holding_registers[REG_DIAG_LOOP_AVG_US] = Diag_Clamp16(Diag_StatAvg(&loop_time));
+    holding_registers[REG_DIAG_LOOP_MAX_US] = Diag_Clamp16(loop_time.max_us);
+    holding_registers[REG_DIAG_JITTER_MAX_MS] = Diag_Clamp16(jitter_ms);
+
+    if (mb != NULL) {
+        holding_registers[REG_DIAG_MB_TURN_US] = Diag_Clamp16(mb->turnaround.last_us);
+        holding_registers[REG_DIAG_MB_TURN_MAX_US] = Diag_Clamp16(mb->turnaround.max_us);
+        holding_registers[REG_DIAG_CRC_ERRORS] = Diag_Clamp16(mb->crc_error_count);
+        holding_registers[REG_DIAG_MB_OVERRUNS] = Diag_Clamp16(mb->overrun_count);
+    }
+    if (bus1 != NULL) {
+        holding_registers[REG_DIAG_I2C1_ERRORS] = Diag_Clamp16(bus1->error_count + bus1->timeout_count);
+        holding_registers[REG_DIAG_I2C1_MAX_US] = Diag_Clamp16(bus1->transfer_time.max_us);
+    }
+    if (bus2 != NULL) {
+        holding_registers[REG_DIAG_I2C2_ERRORS] = Diag_Clamp16(bus2->error_count + bus2->timeout_count);
+        holding_registers[REG_DIAG_I2C2_MAX_US] = Diag_Clamp16(bus2->transfer_time.max_us);
+    }
+}
+
+/**
+ * Request a statistics reset (applied by the next diagnostics task run)
+ */
+void SensorHub_ResetDiagnostics(void) {
+    diag_reset_pending = true;
+}
+
+/**
+ * Write a measurement to the work bank
+ * Becomes visible to Modbus at the next SensorHub_PublishRegisters().
+ * Unchanged values don't trigger a publish.
+ */
+static void SensorHub_StageRegister(uint16_t reg, uint16_t value) {
+    if (staging_registers[reg] != value) {
+        staging_registers[reg] = value;
+        staging_dirty = true;
+    }
+}
+
+/**
+ * Compare the work bank against each channel's deadband
+ * Returns the channels to flag in REG_CHANGE_MAP and moves their
+ * reference to the new value, so slow drift is reported once per
+ * deadband step rather than never.
+ */
+static uint16_t SensorHub_DetectChanges(void) {
+    uint16_t changed = 0;
+
+    for (int i = 0; i < CHANGE_CHANNEL_COUNT; i++) {
+        const ChangeChannel_t *ch = &change_channels[i];
+        uint32_t value = staging_registers[ch->reg];
+        int32_t delta;
+
+        // Signed wrap-around difference, so signed temperatures work too
+        if (ch->wide) {
+            value = (value << 16) | staging_registers[ch->reg + 1];
+            delta = (int32_t)(value - change_reference[i]);
+        } else {
+            delta = (int16_t)(uint16_t)(value - change_reference[i]);
+        }
+        if (delta < 0) {
+            delta = -delta;
+        }
+
+        if ((uint32_t)delta > holding_registers[REG_DEADBAND_BASE + i]) {
+            change_reference[i] = value;
+            changed |= (1u << i);
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * Copy the measurement block from the work bank to the live bank
+ * Runs with interrupts masked so a Modbus reply never sees a half-updated
+ * block (e.g. a torn LUX_HI/LO pair), then bumps REG_SAMPLE_SEQ so the
+ * master can tell a fresh sample from a repeat in the same read.
+ */
+static void SensorHub_PublishRegisters(void) {
+    if (!staging_dirty) {
+        return;
+    }
+
+    uint16_t changed = SensorHub_DetectChanges();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (int i = REG_CHANNEL_1; i <= REG_DI_STATUS; i++) {
+        holding_registers[i] = staging_registers[i];
+    }
+    for (int i = REG_BH1750_LUX_HI; i <= REG_ATLAS_EC_LO; i++) {
+        holding_registers[i] = staging_registers[i];
+    }
+    holding_registers[REG_HIST_SEQ_HI] = staging_registers[REG_HIST_SEQ_HI];
+    holding_registers[REG_HIST_SEQ_LO] = staging_registers[REG_HIST_SEQ_LO];
+    holding_registers[REG_CHANGE_MAP] |= changed;
+
+    // 0 is reserved for "nothing published yet"
+    if (++holding_registers[REG_SAMPLE_SEQ] == 0) {
+        holding_registers[REG_SAMPLE_SEQ] = 1;
+    }
+
+    __set_PRIMASK(primask);
+    staging_dirty = false;
+}
+
+/**
+ * Run the next due sensor task
+ * Call from the main loop on every pass. Services the I2C engine and
+ * stages finished readings, then runs at most one task, picking the
+ * most overdue one. Everything staged in the pass is published to
+ * Modbus in one atomic step; requests are answered from PendSV, which
+ * preempts this at any point outside the publish.
+ */
+void SensorHub_Update(void) {
+    uint32_t pass_start = DIAG_NOW();
+
+    I2CBus_Process();
+    SensorHub_PublishReadings();
+
+    uint32_t now = HAL_GetTick();
+    SensorTask_t *next = NULL;
+    int32_t most_late = -1;
+
+    for (int i = 0; i < SENSOR_TASK_COUNT; i++) {
+        SensorTask_t *task = &sensor_tasks[i];
+        if (!task->enabled) {
+            continue;
         }
+
+        // Signed difference handles tick wraparound
+        int32_t late = (int32_t)(now - task->next_due);
+        if (late > most_late) {
+            most_late = late;
+            next = task;
+        }
+    }
+
+    if (next == NULL) {
+        SensorHub_PublishRegisters();
+        Diag_StatAdd(&loop_time, Diag_Since(pass_start));
+        return;
+    }
+
+    if ((uint32_t)most_late > next->late_max_ms) {
+        next->late_max_ms = most_late;
+    }
+
+    uint32_t run_start = DIAG_NOW();
+    next->run();
+    SensorHub_PublishRegisters();
+
+    uint32_t duration_us = Diag_Since(run_start);
+    Diag_StatAdd(&next->exec, duration_us);
+    if (duration_us > next->deadline_ms * 1000) {
+        next->overruns++;
+    }
+
+    uint32_t end = HAL_GetTick();
+
+    // Keep a fixed cadence, but resync instead of bursting after a stall
+    next->next_due += next->period_ms;
+    if ((int32_t)(end - next->next_due) >= 0) {
+        next->next_due = end + next->period_ms;
     }
+
+    Diag_StatAdd(&loop_time, Diag_Since(pass_start));
+}
+
+/**
+ * Get scheduler entry for a task (statistics, period)
+ */
+const SensorTask_t* SensorHub_GetTask(SensorTask_Id_t id) {
+    if (id >= SENSOR_TASK_COUNT) {
+        return NULL;
+    }
+    return &sensor_tasks[id];
 }
 
 /**
@@ -375,6 +742,13 @@ uint16_t SensorHub_GetRegisterCount(void) {
     return HOLDING_REG_COUNT;
 }
 
+/**
+ * Get firmware revision string (Modbus device identification)
+ */
+const char* SensorHub_GetRevision(void) {
+    return FW_REVISION_STRING;
+}
+
 /**
  * Set analog output value (0-10V)
  * channel: 0 or 1
@@ -410,6 +784,15 @@ void SensorHub_SetAnalogOutput(uint8_t channel, uint16_t value) {
     }
 }
 
+/**
+ * Modbus writable check: analog outputs, deadbands and the diagnostics reset
+ */
+bool SensorHub_IsRegisterWritable(uint16_t reg_addr) {
+    return reg_addr == REG_AOUT_1 || reg_addr == REG_AOUT_2 ||
+           (reg_addr >= REG_DEADBAND_BASE && reg_addr < REG_DEADBAND_BASE + CHANGE_CHANNEL_COUNT) ||
+           reg_addr == REG_DIAG_RESET;
+}
+
 /**
  * Callback for Modbus register writes
  * Called when a register value is written via Modbus
@@ -422,8 +805,24 @@ void SensorHub_OnRegisterWrite(uint16_t reg_addr, uint16_t value) {
         case REG_AOUT_2:
             SensorHub_SetAnalogOutput(1, value);
             break;
+        case REG_DIAG_RESET:
+            if (value != 0) {
+                SensorHub_ResetDiagnostics();
+            }
+            break;
         default:
-            // Ignore writes to other registers (read-only)
+            // Deadbands take effect from the register itself
             break;
     }
 }
+
+/**
+ * Handle Modbus register read (called after the reply is built)
+ * Reading REG_CHANGE_MAP hands the flagged channels to the master, so
+ * the map starts over from zero.
+ */
+void SensorHub_OnRegisterRead(uint16_t start_addr, uint16_t quantity) {
+    if (start_addr <= REG_CHANGE_MAP && REG_CHANGE_MAP < start_addr + quantity) {
+        holding_registers[REG_CHANGE_MAP] = 0;
+    }
+}
@@ -8,6 +8,9 @@
 
 /* External variables */
 extern UART_HandleTypeDef huart2;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern I2C_HandleTypeDef hi2c1;
+extern I2C_HandleTypeDef hi2c2;
 extern Modbus_HandleTypeDef modbus;
 
 /**
@@ -15,25 +18,48 @@ extern Modbus_HandleTypeDef modbus;
  */
 void SysTick_Handler(void) {
     HAL_IncTick();
-
-    /* Check Modbus frame timeout */
-    Modbus_TimerCallback(&modbus);
 }
 
 /**
  * USART2 interrupt handler (RS485 Modbus)
  */
 void USART2_IRQHandler(void) {
-    /* Check for RX data */
-    if (__HAL_UART_GET_FLAG(&huart2, UART_FLAG_RXNE)) {
-        uint8_t data = (uint8_t)(huart2.Instance->RDR & 0xFF);
-        Modbus_RxCallback(&modbus, data);
-    }
+    /* Frame end (receiver timeout) - RX bytes arrive by circular DMA */
+    Modbus_IRQHandler(&modbus);
 
-    /* Handle other UART interrupts */
+    /* Handle other UART interrupts (TX complete) */
     HAL_UART_IRQHandler(&huart2);
 }
 
+/**
+ * DMA1 Channel2 interrupt handler (Modbus TX)
+ */
+void DMA1_Channel2_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&hdma_usart2_tx);
+}
+
+/**
+ * I2C1 event/error interrupt handlers (sensor bus 1)
+ */
+void I2C1_EV_IRQHandler(void) {
+    HAL_I2C_EV_IRQHandler(&hi2c1);
+}
+
+void I2C1_ER_IRQHandler(void) {
+    HAL_I2C_ER_IRQHandler(&hi2c1);
+}
+
+/**
+ * I2C2 event/error interrupt handlers (sensor bus 2)
+ */
+void I2C2_EV_IRQHandler(void) {
+    HAL_I2C_EV_IRQHandler(&hi2c2);
+}
+
+void I2C2_ER_IRQHandler(void) {
+    HAL_I2C_ER_IRQHandler(&hi2c2);
+}
+
 /**
  * Hard Fault Handler
  */
@@ -86,7 +112,9 @@ void SVC_Handler(void) {
 }
 
 /**
- * PendSV Handler
+ * PendSV Handler - Modbus frame processing
+ * Pended by Modbus_IRQHandler() at end of frame.
  */
 void PendSV_Handler(void) {
+    Modbus_Process(&modbus);
 }
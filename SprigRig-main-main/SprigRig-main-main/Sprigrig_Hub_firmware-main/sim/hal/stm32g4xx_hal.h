@@ -0,0 +1,367 @@
+/**
+ * STM32G4 HAL Shim - Host Simulator
+ * SprigRig Sensor Hub
+ *
+ * Just enough of the STM32G4 HAL and CMSIS for the hub sources to build
+ * on Linux. Peripheral handles are plain structs; the virtual hardware in
+ * hal_sim.c moves bytes between them and a pty, fake I2C devices and a
+ * fake ADC, and raises "interrupts" from its own thread.
+ */
+
+#ifndef __STM32G4XX_HAL_H
+#define __STM32G4XX_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Status */
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY           0xFFFFFFFFU
+
+/* Core registers (CMSIS) */
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+DWT_Type *Sim_DWT(void);                // Refreshes CYCCNT from the host clock
+extern SCB_Type sim_scb;
+extern CoreDebug_Type sim_core_debug;
+
+#define DWT                     (Sim_DWT())
+#define SCB                     (&sim_scb)
+#define CoreDebug               (&sim_core_debug)
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define SCB_ICSR_PENDSVSET_Msk          (1UL << 28)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+extern uint32_t SystemCoreClock;
+
+/* Interrupt masking - PRIMASK is emulated with the virtual NVIC lock */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+typedef enum {
+    PendSV_IRQn = -2,
+    SysTick_IRQn = -1,
+    DMA1_Channel1_IRQn = 11,
+    DMA1_Channel2_IRQn = 12,
+    DMA1_Channel3_IRQn = 13,
+    I2C1_EV_IRQn = 31,
+    I2C1_ER_IRQn = 32,
+    I2C2_EV_IRQn = 33,
+    I2C2_ER_IRQn = 34,
+    USART2_IRQn = 38
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn);
+
+/* Tick */
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+
+/* GPIO */
+typedef struct {
+    uint32_t id;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+#define GPIOA                   (&sim_gpioa)
+#define GPIOB                   (&sim_gpiob)
+#define GPIOC                   (&sim_gpioc)
+
+#define GPIO_PIN_0              0x0001U
+#define GPIO_PIN_1              0x0002U
+#define GPIO_PIN_2              0x0004U
+#define GPIO_PIN_3              0x0008U
+#define GPIO_PIN_4              0x0010U
+#define GPIO_PIN_5              0x0020U
+#define GPIO_PIN_6              0x0040U
+#define GPIO_PIN_7              0x0080U
+#define GPIO_PIN_8              0x0100U
+#define GPIO_PIN_9              0x0200U
+#define GPIO_PIN_10             0x0400U
+#define GPIO_PIN_11             0x0800U
+#define GPIO_PIN_12             0x1000U
+#define GPIO_PIN_13             0x2000U
+#define GPIO_PIN_14             0x4000U
+#define GPIO_PIN_15             0x8000U
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+/* DMA */
+typedef struct {
+    volatile uint32_t CNDTR;            // Remaining transfers (counts down, reloads in circular mode)
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    uint32_t Request;
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct {
+    DMA_Channel_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    uint8_t *buffer;                    // Destination set by HAL_DMA_Start
+    uint32_t length;
+} DMA_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t src, uint32_t dst, uint32_t length);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+#define __HAL_DMA_GET_COUNTER(h)        ((h)->Instance->CNDTR)
+
+/* UART */
+typedef struct {
+    volatile uint32_t CR3;
+    volatile uint32_t RDR;
+    volatile uint32_t ISR;
+} USART_TypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+    uint32_t OneBitSampling;
+    uint32_t ClockPrescaler;
+} UART_InitTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0,
+    HAL_UART_STATE_READY,
+    HAL_UART_STATE_BUSY_TX
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmarx;
+    DMA_HandleTypeDef *hdmatx;
+    volatile HAL_UART_StateTypeDef gState;
+    uint32_t rx_timeout_bits;
+} UART_HandleTypeDef;
+
+#define USART_CR3_DMAR                  (1UL << 6)
+#define UART_FLAG_ORE                   (1UL << 3)
+#define UART_FLAG_NE                    (1UL << 2)
+#define UART_FLAG_FE                    (1UL << 1)
+#define UART_FLAG_RTOF                  (1UL << 11)
+#define UART_CLEAR_OREF                 UART_FLAG_ORE
+#define UART_CLEAR_NEF                  UART_FLAG_NE
+#define UART_CLEAR_FEF                  UART_FLAG_FE
+#define UART_CLEAR_RTOF                 UART_FLAG_RTOF
+#define UART_IT_RTO                     (1UL << 26)
+
+#define SET_BIT(reg, bit)               ((reg) |= (bit))
+#define __HAL_UART_GET_FLAG(h, f)       (((h)->Instance->ISR & (f)) == (f))
+#define __HAL_UART_CLEAR_FLAG(h, f)     ((h)->Instance->ISR &= ~(f))
+#define __HAL_UART_ENABLE_IT(h, it)     ((void)(h), (void)(it))
+
+HAL_StatusTypeDef HAL_UART_ReceiverTimeout_Config(UART_HandleTypeDef *huart, uint32_t bits);
+HAL_StatusTypeDef HAL_UART_EnableReceiverTimeout(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+
+/* I2C */
+typedef struct {
+    uint32_t Timing;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+    uint32_t DualAddressMode;
+    uint32_t GeneralCallMode;
+    uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    I2C_InitTypeDef Init;
+    uint8_t bus;                        // 1 = I2C1, 2 = I2C2
+} I2C_HandleTypeDef;
+
+#define I2C_MEMADD_SIZE_8BIT            1U
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len);
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c);
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+/* ADC */
+typedef struct {
+    uint32_t Ratio;
+    uint32_t RightBitShift;
+    uint32_t TriggeredMode;
+    uint32_t OversamplingStopReset;
+} ADC_OversamplingTypeDef;
+
+typedef struct {
+    uint32_t ClockPrescaler;
+    uint32_t Resolution;
+    uint32_t DataAlign;
+    uint32_t GainCompensation;
+    uint32_t ScanConvMode;
+    uint32_t EOCSelection;
+    uint32_t LowPowerAutoWait;
+    uint32_t ContinuousConvMode;
+    uint32_t NbrOfConversion;
+    uint32_t DiscontinuousConvMode;
+    uint32_t ExternalTrigConv;
+    uint32_t ExternalTrigConvEdge;
+    uint32_t DMAContinuousRequests;
+    uint32_t Overrun;
+    uint32_t OversamplingMode;
+    ADC_OversamplingTypeDef Oversampling;
+} ADC_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    ADC_InitTypeDef Init;
+    DMA_HandleTypeDef *DMA_Handle;
+    uint32_t *scan;                     // DMA destination set by HAL_ADC_Start_DMA
+    uint32_t length;
+} ADC_HandleTypeDef;
+
+#define ADC_SINGLE_ENDED                0U
+#define ADC_CHANNEL_1                   1U
+#define ADC_CHANNEL_11                  11U
+#define ADC_CHANNEL_12                  12U
+#define ADC_CHANNEL_15                  15U
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc, uint32_t mode);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *data, uint32_t length);
+
+/* Timer */
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    TIM_Base_InitTypeDef Init;
+    uint32_t running;
+} TIM_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+
+/* DAC */
+typedef struct {
+    void *Instance;
+    uint32_t value[2];
+} DAC_HandleTypeDef;
+
+#define DAC_CHANNEL_1                   0x00U
+#define DAC_CHANNEL_2                   0x10U
+#define DAC_ALIGN_12B_R                 0x00U
+
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef *hdac, uint32_t channel);
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef *hdac, uint32_t channel, uint32_t alignment, uint32_t value);
+
+/* CRC */
+typedef struct {
+    uint32_t DefaultPolynomialUse;
+    uint32_t DefaultInitValueUse;
+    uint32_t GeneratingPolynomial;
+    uint32_t CRCLength;
+    uint32_t InitValue;
+    uint32_t InputDataInversionMode;
+    uint32_t OutputDataInversionMode;
+} CRC_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    CRC_InitTypeDef Init;
+    uint32_t InputDataFormat;
+} CRC_HandleTypeDef;
+
+#define CRC                             ((void *)0)
+#define DEFAULT_POLYNOMIAL_ENABLE       0U
+#define DEFAULT_POLYNOMIAL_DISABLE      1U
+#define DEFAULT_INIT_VALUE_ENABLE       0U
+#define DEFAULT_INIT_VALUE_DISABLE      1U
+#define CRC_POLYLENGTH_32B              32U
+#define CRC_POLYLENGTH_16B              16U
+#define CRC_POLYLENGTH_8B               8U
+#define CRC_INPUTDATA_INVERSION_NONE    0U
+#define CRC_INPUTDATA_INVERSION_BYTE    1U
+#define CRC_OUTPUTDATA_INVERSION_DISABLE 0U
+#define CRC_OUTPUTDATA_INVERSION_ENABLE 1U
+#define CRC_INPUTDATA_FORMAT_BYTES      1U
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc);
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t *buffer, uint32_t length);
+
+/* SPI (unused by the hub application, handle only) */
+typedef struct {
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+    uint32_t TIMode;
+    uint32_t CRCCalculation;
+} SPI_InitTypeDef;
+
+typedef struct {
+    void *Instance;
+    SPI_InitTypeDef Init;
+} SPI_HandleTypeDef;
+
+/* Peripheral setup used only by main.c's MX_*_Init */
+#include "stm32g4xx_hal_init.h"
+
+#endif /* __STM32G4XX_HAL_H */
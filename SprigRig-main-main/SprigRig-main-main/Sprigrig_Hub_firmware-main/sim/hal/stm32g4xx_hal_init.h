@@ -0,0 +1,236 @@
+/**
+ * STM32G4 HAL Shim - Peripheral Setup
+ * SprigRig Sensor Hub
+ *
+ * Clock, GPIO and peripheral init declarations used by main.c. The
+ * simulator wires its virtual hardware in sim_main.c instead, so these are
+ * only compiled (`make check`), never linked; values are placeholders.
+ */
+
+#ifndef __STM32G4XX_HAL_INIT_H
+#define __STM32G4XX_HAL_INIT_H
+
+#define ENABLE                          1U
+#define DISABLE                         0U
+
+/* Clocks */
+typedef struct {
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLM;
+    uint32_t PLLN;
+    uint32_t PLLP;
+    uint32_t PLLQ;
+    uint32_t PLLR;
+} RCC_PLLInitTypeDef;
+
+typedef struct {
+    uint32_t OscillatorType;
+    uint32_t HSIState;
+    uint32_t HSICalibrationValue;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct {
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define PWR_REGULATOR_VOLTAGE_SCALE1_BOOST 0U
+#define RCC_OSCILLATORTYPE_HSI          0x02U
+#define RCC_HSI_ON                      1U
+#define RCC_HSICALIBRATION_DEFAULT      0x40U
+#define RCC_PLL_ON                      2U
+#define RCC_PLLSOURCE_HSI               2U
+#define RCC_PLLM_DIV4                   3U
+#define RCC_PLLP_DIV2                   2U
+#define RCC_PLLQ_DIV2                   0U
+#define RCC_PLLR_DIV2                   0U
+#define RCC_CLOCKTYPE_SYSCLK            0x01U
+#define RCC_CLOCKTYPE_HCLK              0x02U
+#define RCC_CLOCKTYPE_PCLK1             0x04U
+#define RCC_CLOCKTYPE_PCLK2             0x08U
+#define RCC_SYSCLKSOURCE_PLLCLK         3U
+#define RCC_SYSCLK_DIV1                 0U
+#define RCC_HCLK_DIV1                   0U
+#define FLASH_LATENCY_4                 4U
+
+HAL_StatusTypeDef HAL_PWREx_ControlVoltageScaling(uint32_t scaling);
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *osc);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *clk, uint32_t latency);
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_DMAMUX1_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_ADC12_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_TIM6_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_DAC1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_I2C1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_I2C2_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_SPI2_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_USART2_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_CRC_CLK_ENABLE()      ((void)0)
+
+#define __HAL_LINKDMA(h, field, dma)    ((h)->field = &(dma))
+
+/* GPIO */
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_INPUT                 0x00U
+#define GPIO_MODE_OUTPUT_PP             0x01U
+#define GPIO_MODE_AF_PP                 0x02U
+#define GPIO_MODE_AF_OD                 0x12U
+#define GPIO_MODE_ANALOG                0x03U
+#define GPIO_NOPULL                     0U
+#define GPIO_PULLUP                     1U
+#define GPIO_PULLDOWN                   2U
+#define GPIO_SPEED_FREQ_HIGH            2U
+#define GPIO_AF4_I2C1                   4U
+#define GPIO_AF4_I2C2                   4U
+#define GPIO_AF5_SPI2                   5U
+#define GPIO_AF7_USART2                 7U
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+
+/* DMA */
+#define DMA1_Channel1                   ((DMA_Channel_TypeDef *)0)
+#define DMA1_Channel2                   ((DMA_Channel_TypeDef *)0)
+#define DMA1_Channel3                   ((DMA_Channel_TypeDef *)0)
+#define DMA_REQUEST_ADC1                5U
+#define DMA_REQUEST_USART2_RX           26U
+#define DMA_REQUEST_USART2_TX           27U
+#define DMA_PERIPH_TO_MEMORY            0U
+#define DMA_MEMORY_TO_PERIPH            1U
+#define DMA_PINC_DISABLE                0U
+#define DMA_MINC_ENABLE                 1U
+#define DMA_PDATAALIGN_BYTE             0U
+#define DMA_PDATAALIGN_HALFWORD         1U
+#define DMA_MDATAALIGN_BYTE             0U
+#define DMA_MDATAALIGN_HALFWORD         1U
+#define DMA_NORMAL                      0U
+#define DMA_CIRCULAR                    1U
+#define DMA_PRIORITY_LOW                0U
+#define DMA_PRIORITY_MEDIUM             1U
+#define DMA_PRIORITY_HIGH               2U
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+
+/* ADC */
+typedef struct {
+    uint32_t Channel;
+    uint32_t Rank;
+    uint32_t SamplingTime;
+    uint32_t SingleDiff;
+    uint32_t OffsetNumber;
+} ADC_ChannelConfTypeDef;
+
+#define ADC1                            ((void *)0)
+#define ADC_CLOCK_SYNC_PCLK_DIV4        3U
+#define ADC_RESOLUTION_12B              0U
+#define ADC_DATAALIGN_RIGHT             0U
+#define ADC_SCAN_ENABLE                 1U
+#define ADC_EOC_SEQ_CONV                2U
+#define ADC_EXTERNALTRIG_T6_TRGO        13U
+#define ADC_EXTERNALTRIGCONVEDGE_RISING 1U
+#define ADC_OVR_DATA_OVERWRITTEN        1U
+#define ADC_OVERSAMPLING_RATIO_256      7U
+#define ADC_RIGHTBITSHIFT_8             8U
+#define ADC_TRIGGEREDMODE_SINGLE_TRIGGER 0U
+#define ADC_REGOVERSAMPLING_CONTINUED_MODE 0U
+#define ADC_SAMPLETIME_47CYCLES_5       4U
+#define ADC_OFFSET_NONE                 0U
+#define ADC_REGULAR_RANK_1              1U
+#define ADC_REGULAR_RANK_2              2U
+#define ADC_REGULAR_RANK_3              3U
+#define ADC_REGULAR_RANK_4              4U
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *config);
+
+/* Timer */
+typedef struct {
+    uint32_t MasterOutputTrigger;
+    uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+#define TIM6                            ((void *)0)
+#define TIM_COUNTERMODE_UP              0U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE  0U
+#define TIM_TRGO_UPDATE                 2U
+#define TIM_MASTERSLAVEMODE_DISABLE     0U
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *config);
+
+/* DAC */
+typedef struct {
+    uint32_t DAC_HighFrequency;
+    uint32_t DAC_DMADoubleDataMode;
+    uint32_t DAC_SignedFormat;
+    uint32_t DAC_SampleAndHold;
+    uint32_t DAC_Trigger;
+    uint32_t DAC_OutputBuffer;
+    uint32_t DAC_ConnectOnChipPeripheral;
+    uint32_t DAC_UserTrimming;
+} DAC_ChannelConfTypeDef;
+
+#define DAC1                            ((void *)0)
+#define DAC_HIGH_FREQUENCY_INTERFACE_MODE_AUTOMATIC 2U
+#define DAC_SAMPLEANDHOLD_DISABLE       0U
+#define DAC_TRIGGER_NONE                0U
+#define DAC_OUTPUTBUFFER_ENABLE         0U
+#define DAC_CHIPCONNECT_EXTERNAL        1U
+#define DAC_TRIMMING_FACTORY            0U
+
+HAL_StatusTypeDef HAL_DAC_Init(DAC_HandleTypeDef *hdac);
+HAL_StatusTypeDef HAL_DAC_ConfigChannel(DAC_HandleTypeDef *hdac, DAC_ChannelConfTypeDef *config, uint32_t channel);
+
+/* I2C */
+#define I2C1                            ((void *)0)
+#define I2C2                            ((void *)0)
+#define I2C_ADDRESSINGMODE_7BIT         1U
+#define I2C_DUALADDRESS_DISABLE         0U
+#define I2C_GENERALCALL_DISABLE         0U
+#define I2C_NOSTRETCH_DISABLE           0U
+
+/* SPI */
+#define SPI2                            ((void *)0)
+#define SPI_MODE_MASTER                 1U
+#define SPI_DIRECTION_2LINES            0U
+#define SPI_DATASIZE_8BIT               7U
+#define SPI_POLARITY_LOW                0U
+#define SPI_PHASE_1EDGE                 0U
+#define SPI_NSS_SOFT                    1U
+#define SPI_BAUDRATEPRESCALER_32        4U
+#define SPI_FIRSTBIT_MSB                0U
+#define SPI_TIMODE_DISABLE              0U
+#define SPI_CRCCALCULATION_DISABLE      0U
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+
+/* UART */
+#define USART2                          ((USART_TypeDef *)0)
+#define UART_WORDLENGTH_8B              0U
+#define UART_STOPBITS_1                 0U
+#define UART_PARITY_NONE                0U
+#define UART_MODE_TX_RX                 3U
+#define UART_HWCONTROL_NONE             0U
+#define UART_OVERSAMPLING_16            0U
+#define UART_ONE_BIT_SAMPLE_DISABLE     0U
+#define UART_PRESCALER_DIV1             0U
+#define UART_DE_POLARITY_HIGH           0U
+
+HAL_StatusTypeDef HAL_RS485Ex_Init(UART_HandleTypeDef *huart, uint32_t polarity, uint32_t assertion, uint32_t deassertion);
+
+#endif /* __STM32G4XX_HAL_INIT_H */
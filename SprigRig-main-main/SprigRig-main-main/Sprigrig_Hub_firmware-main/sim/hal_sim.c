@@ -0,0 +1,872 @@
+/**
+ * Virtual Hub Hardware - Host Simulator
+ * SprigRig Sensor Hub
+ *
+ * The firmware's main loop runs on the process main thread. Everything the
+ * MCU does in hardware or in interrupt context runs on one "NVIC" thread:
+ *  - RX bytes from the pty are clocked into the circular DMA ring at the
+ *    configured baud, and the receiver timeout fires after t3.5 of silence
+ *  - TX DMA replies are held for their wire time, then written to the pty
+ *  - I2C _IT transfers complete after each device's scripted latency
+ *  - the ADC scan buffer is refreshed at the TIM6 trigger rate
+ *
+ * Interrupt handlers run with the NVIC lock held. __disable_irq() on the
+ * main thread takes the same lock, so the firmware's PRIMASK sections are
+ * atomic against them exactly as on the MCU.
+ */
+
+#define _GNU_SOURCE
+#include "hal_sim.h"
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#undef CR3   // termios output delay flag; clashes with USART_TypeDef.CR3
+
+/* Private defines */
+#define SIM_RX_QUEUE_SIZE       1024
+#define SIM_TX_BUFFER_SIZE      512
+#define SIM_I2C_MISSING_US      100     // Address NACK after the address byte
+#define SIM_BITS_PER_CHAR       10      // 8N1
+
+/* Private types */
+typedef enum {
+    SIM_I2C_TX,
+    SIM_I2C_RX,
+    SIM_I2C_MEM_TX,
+    SIM_I2C_MEM_RX
+} Sim_I2COp_t;
+
+typedef struct {
+    bool active;
+    Sim_I2COp_t op;
+    I2C_HandleTypeDef *hi2c;
+    Sim_I2CDevice_t *device;            // NULL = no device at that address
+    uint8_t reg;
+    uint8_t *data;
+    uint16_t length;
+    uint64_t due_ns;
+} Sim_I2CTransfer_t;
+
+/* Public variables (CMSIS / HAL globals) */
+uint32_t SystemCoreClock = 170000000;
+SCB_Type sim_scb;
+CoreDebug_Type sim_core_debug;
+GPIO_TypeDef sim_gpioa = { 0 }, sim_gpiob = { 1 }, sim_gpioc = { 2 };
+
+/* Private variables */
+static Sim_Config_t sim_config;
+static DWT_Type sim_dwt;
+static uint64_t start_ns;
+
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int irq_waiting;
+static __thread uint32_t primask;
+
+static int pty_master = -1;
+static int pty_slave = -1;
+static char pty_name[64];
+
+static UART_HandleTypeDef *sim_uart;
+static uint8_t rx_queue[SIM_RX_QUEUE_SIZE];
+static uint16_t rx_queue_head;
+static uint16_t rx_queue_tail;
+static uint64_t rx_next_ns;             // When the next queued byte finishes arriving
+static uint64_t rx_last_ns;             // When the last byte landed in the ring
+static bool rx_timeout_armed;
+
+static uint8_t tx_buffer[SIM_TX_BUFFER_SIZE];
+static uint16_t tx_length;
+static uint64_t tx_done_ns;
+
+static Sim_I2CDevice_t devices[SIM_I2C_DEVICE_MAX];
+static uint8_t device_count;
+static Sim_I2CTransfer_t i2c_transfer[2];
+
+static ADC_HandleTypeDef *sim_adc;
+static uint64_t adc_next_ns;
+
+/* Private function prototypes */
+static uint64_t Sim_NowNs(void);
+static uint64_t Sim_CharNs(void);
+static void* Sim_IrqThread(void *arg);
+static void Sim_EnterIrq(void);
+static void Sim_ExitIrq(void);
+static void Sim_RaiseUsart(void);
+static void Sim_PumpRx(uint64_t now);
+static void Sim_CompleteI2C(Sim_I2CTransfer_t *xfer);
+static void Sim_UpdateAdc(void);
+static Sim_I2CDevice_t* Sim_FindDevice(I2C_HandleTypeDef *hi2c, uint16_t addr);
+static void Sim_DeviceRead(Sim_I2CDevice_t *dev, bool mem, uint8_t reg, uint8_t *data, uint16_t len);
+static void Sim_DeviceWrite(Sim_I2CDevice_t *dev, bool mem, uint8_t reg, const uint8_t *data, uint16_t len);
+static HAL_StatusTypeDef Sim_StartI2C(I2C_HandleTypeDef *hi2c, Sim_I2COp_t op, uint16_t addr,
+                                      uint8_t reg, uint8_t *data, uint16_t len);
+
+/**
+ * Set up the virtual hardware
+ * Opens the pty and (optionally) links it; the NVIC thread is started
+ * later by Sim_Start() so firmware init runs without interrupts.
+ */
+bool Sim_Init(const Sim_Config_t *config, UART_HandleTypeDef *huart) {
+    sim_config = *config;
+    sim_uart = huart;
+    start_ns = Sim_NowNs();
+
+    if (sim_config.device_script && !Sim_LoadDevices(sim_config.device_script)) {
+        return false;
+    }
+
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_master < 0 || grantpt(pty_master) != 0 || unlockpt(pty_master) != 0) {
+        perror("posix_openpt");
+        return false;
+    }
+    snprintf(pty_name, sizeof(pty_name), "%s", ptsname(pty_master));
+
+    // Hold the slave open so the master survives hosts reconnecting,
+    // and make it raw so nothing is echoed or translated
+    pty_slave = open(pty_name, O_RDWR | O_NOCTTY);
+    if (pty_slave < 0) {
+        perror(pty_name);
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(pty_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty_slave, TCSANOW, &tio);
+
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+
+    if (sim_config.link_path) {
+        unlink(sim_config.link_path);
+        if (symlink(pty_name, sim_config.link_path) != 0) {
+            perror(sim_config.link_path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Load the I2C device script
+ * One device per line:
+ *   <bus> <addr> <latency_us> regs <reg>=<b0>,<b1>,... [<reg>=...]
+ *   <bus> <addr> <latency_us> stream <b0>,<b1>,...
+ * bus is i2c1 or i2c2; numbers are hex for addresses and bytes.
+ */
+bool Sim_LoadDevices(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char *save = NULL;
+        char *bus = strtok_r(line, " \t\r\n", &save);
+        if (bus == NULL) {
+            continue;
+        }
+
+        char *addr = strtok_r(NULL, " \t\r\n", &save);
+        char *latency = strtok_r(NULL, " \t\r\n", &save);
+        char *kind = strtok_r(NULL, " \t\r\n", &save);
+        if (addr == NULL || latency == NULL || kind == NULL || device_count >= SIM_I2C_DEVICE_MAX) {
+            fprintf(stderr, "%s:%d: bad device line\n", path, line_number);
+            fclose(file);
+            return false;
+        }
+
+        Sim_I2CDevice_t *dev = &devices[device_count++];
+        memset(dev, 0, sizeof(*dev));
+        dev->bus = (strcmp(bus, "i2c2") == 0) ? 2 : 1;
+        dev->address = (uint8_t)strtoul(addr, NULL, 16);
+        dev->latency_us = (uint32_t)strtoul(latency, NULL, 10);
+        dev->stream = (strcmp(kind, "stream") == 0);
+
+        char *field;
+        while ((field = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            char *bytes = field;
+            uint8_t reg = 0;
+
+            if (!dev->stream) {
+                char *eq = strchr(field, '=');
+                if (eq == NULL) {
+                    fprintf(stderr, "%s:%d: expected <reg>=<bytes>\n", path, line_number);
+                    fclose(file);
+                    return false;
+                }
+                *eq = '\0';
+                reg = (uint8_t)strtoul(field, NULL, 16);
+                bytes = eq + 1;
+            }
+
+            char *byte_save = NULL;
+            for (char *b = strtok_r(bytes, ",", &byte_save); b; b = strtok_r(NULL, ",", &byte_save)) {
+                uint8_t value = (uint8_t)strtoul(b, NULL, 16);
+                if (dev->stream) {
+                    if (dev->stream_len < SIM_I2C_STREAM_MAX) {
+                        dev->stream_data[dev->stream_len++] = value;
+                    }
+                } else {
+                    dev->regs[reg++] = value;
+                }
+            }
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * Start the NVIC thread - call once firmware init is done
+ */
+void Sim_Start(void) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, Sim_IrqThread, NULL);
+    pthread_detach(thread);
+}
+
+/**
+ * Name of the pty slave the host should open
+ */
+const char* Sim_GetPtyName(void) {
+    return pty_name;
+}
+
+/* ========== NVIC thread ========== */
+
+/**
+ * Virtual interrupt controller and peripheral clock
+ */
+static void* Sim_IrqThread(void *arg) {
+    (void)arg;
+    adc_next_ns = Sim_NowNs();
+
+    while (1) {
+        uint64_t now = Sim_NowNs();
+
+        Sim_PumpRx(now);
+
+        // Receiver timeout: t3.5 of silence after the last byte
+        uint64_t t35_ns = (uint64_t)sim_uart->rx_timeout_bits * 1000000000ULL / sim_uart->Init.BaudRate;
+        if (rx_timeout_armed && rx_queue_head == rx_queue_tail && now >= rx_last_ns + t35_ns) {
+            rx_timeout_armed = false;
+            sim_uart->Instance->ISR |= UART_FLAG_RTOF;
+            Sim_RaiseUsart();
+        }
+
+        // TX DMA + wire time done: bytes reach the host, line goes idle
+        pthread_mutex_lock(&sim_lock);
+        bool tx_done = (sim_uart->gState == HAL_UART_STATE_BUSY_TX && now >= tx_done_ns);
+        pthread_mutex_unlock(&sim_lock);
+        if (tx_done) {
+            ssize_t written = write(pty_master, tx_buffer, tx_length);
+            (void)written;
+            sim_uart->gState = HAL_UART_STATE_READY;
+        }
+
+        // I2C completions (event / error interrupts)
+        for (int i = 0; i < 2; i++) {
+            pthread_mutex_lock(&sim_lock);
+            bool due = i2c_transfer[i].active && now >= i2c_transfer[i].due_ns;
+            Sim_I2CTransfer_t xfer = i2c_transfer[i];
+            if (due) {
+                i2c_transfer[i].active = false;
+            }
+            pthread_mutex_unlock(&sim_lock);
+
+            if (due) {
+                Sim_CompleteI2C(&xfer);
+            }
+        }
+
+        // TIM6-triggered ADC scan
+        if (now >= adc_next_ns) {
+            Sim_UpdateAdc();
+            adc_next_ns += SIM_ADC_PERIOD_US * 1000ULL;
+        }
+
+        // Sleep until the next event or pty input
+        uint64_t next = adc_next_ns;
+        if (rx_queue_head != rx_queue_tail && rx_next_ns < next) {
+            next = rx_next_ns;
+        }
+        if (rx_timeout_armed && rx_last_ns + t35_ns < next) {
+            next = rx_last_ns + t35_ns;
+        }
+        pthread_mutex_lock(&sim_lock);
+        if (sim_uart->gState == HAL_UART_STATE_BUSY_TX && tx_done_ns < next) {
+            next = tx_done_ns;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (i2c_transfer[i].active && i2c_transfer[i].due_ns < next) {
+                next = i2c_transfer[i].due_ns;
+            }
+        }
+        pthread_mutex_unlock(&sim_lock);
+
+        now = Sim_NowNs();
+        uint64_t wait_ns = (next > now) ? next - now : 0;
+        struct timespec timeout = { (time_t)(wait_ns / 1000000000ULL), (long)(wait_ns % 1000000000ULL) };
+        struct pollfd pfd = { .fd = pty_master, .events = POLLIN };
+        if (ppoll(&pfd, 1, &timeout, NULL) > 0 && (pfd.revents & POLLIN)) {
+            uint8_t buf[256];
+            ssize_t n = read(pty_master, buf, sizeof(buf));
+            now = Sim_NowNs();
+            for (ssize_t i = 0; i < n; i++) {
+                uint16_t next_head = (rx_queue_head + 1) % SIM_RX_QUEUE_SIZE;
+                if (next_head == rx_queue_tail) {
+                    break;  // Host is far ahead of the wire - drop
+                }
+                if (rx_queue_head == rx_queue_tail && rx_next_ns < now + Sim_CharNs()) {
+                    rx_next_ns = now + Sim_CharNs();
+                }
+                rx_queue[rx_queue_head] = buf[i];
+                rx_queue_head = next_head;
+            }
+        } else if (pfd.revents & POLLHUP) {
+            // No host attached to the slave side
+            struct timespec idle = { 0, 1000000 };
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Take the NVIC lock for a handler
+ * Interrupts win over the main thread, as they would on the MCU: the main
+ * thread backs off while a handler is waiting (see __set_PRIMASK).
+ */
+static void Sim_EnterIrq(void) {
+    atomic_fetch_add(&irq_waiting, 1);
+    pthread_mutex_lock(&irq_lock);
+    atomic_fetch_sub(&irq_waiting, 1);
+    primask = 1;
+}
+
+static void Sim_ExitIrq(void) {
+    primask = 0;
+    pthread_mutex_unlock(&irq_lock);
+}
+
+/**
+ * Run the USART2 interrupt, then PendSV if it was pended
+ */
+static void Sim_RaiseUsart(void) {
+    Sim_EnterIrq();
+
+    USART2_IRQHandler();
+
+    if (SCB->ICSR & SCB_ICSR_PENDSVSET_Msk) {
+        SCB->ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+        PendSV_Handler();
+    }
+
+    Sim_ExitIrq();
+}
+
+/**
+ * Clock queued RX bytes into the DMA ring at the wire rate
+ */
+static void Sim_PumpRx(uint64_t now) {
+    DMA_HandleTypeDef *hdma = sim_uart->hdmarx;
+
+    while (rx_queue_head != rx_queue_tail && now >= rx_next_ns) {
+        uint8_t byte = rx_queue[rx_queue_tail];
+        rx_queue_tail = (rx_queue_tail + 1) % SIM_RX_QUEUE_SIZE;
+
+        if ((sim_uart->Instance->CR3 & USART_CR3_DMAR) && hdma->buffer != NULL) {
+            hdma->buffer[hdma->length - hdma->Instance->CNDTR] = byte;
+            hdma->Instance->CNDTR--;
+            if (hdma->Instance->CNDTR == 0) {
+                hdma->Instance->CNDTR = hdma->length;  // Circular reload
+            }
+        }
+
+        rx_last_ns = rx_next_ns;
+        rx_next_ns += Sim_CharNs();
+        rx_timeout_armed = true;
+    }
+}
+
+/**
+ * Finish an interrupt-driven I2C transfer and call the HAL callback
+ */
+static void Sim_CompleteI2C(Sim_I2CTransfer_t *xfer) {
+    Sim_EnterIrq();
+
+    if (xfer->device == NULL) {
+        HAL_I2C_ErrorCallback(xfer->hi2c);
+    } else {
+        switch (xfer->op) {
+            case SIM_I2C_TX:
+                Sim_DeviceWrite(xfer->device, false, 0, xfer->data, xfer->length);
+                HAL_I2C_MasterTxCpltCallback(xfer->hi2c);
+                break;
+            case SIM_I2C_RX:
+                Sim_DeviceRead(xfer->device, false, 0, xfer->data, xfer->length);
+                HAL_I2C_MasterRxCpltCallback(xfer->hi2c);
+                break;
+            case SIM_I2C_MEM_TX:
+                Sim_DeviceWrite(xfer->device, true, xfer->reg, xfer->data, xfer->length);
+                HAL_I2C_MemTxCpltCallback(xfer->hi2c);
+                break;
+            case SIM_I2C_MEM_RX:
+                Sim_DeviceRead(xfer->device, true, xfer->reg, xfer->data, xfer->length);
+                HAL_I2C_MemRxCpltCallback(xfer->hi2c);
+                break;
+        }
+    }
+
+    Sim_ExitIrq();
+}
+
+/**
+ * Write one oversampled scan into the ADC DMA buffer
+ */
+static void Sim_UpdateAdc(void) {
+    if (sim_adc == NULL || sim_adc->scan == NULL) {
+        return;
+    }
+
+    // 12-bit results, halfword DMA into the firmware's uint16_t buffer
+    volatile uint16_t *scan = (volatile uint16_t *)sim_adc->scan;
+    for (uint32_t i = 0; i < sim_adc->length && i < SIM_ADC_CHANNELS; i++) {
+        int32_t value = sim_config.adc_level[i];
+        if (sim_config.adc_noise) {
+            value += (rand() % (2 * sim_config.adc_noise + 1)) - sim_config.adc_noise;
+        }
+        if (value < 0) {
+            value = 0;
+        } else if (value > 4095) {
+            value = 4095;
+        }
+        scan[i] = (uint16_t)value;
+    }
+}
+
+/* ========== Clock ========== */
+
+static uint64_t Sim_NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Time one 8N1 character occupies the wire
+ */
+static uint64_t Sim_CharNs(void) {
+    return (uint64_t)SIM_BITS_PER_CHAR * 1000000000ULL / sim_uart->Init.BaudRate;
+}
+
+/**
+ * DWT cycle counter derived from the host clock at SystemCoreClock
+ */
+DWT_Type *Sim_DWT(void) {
+    uint64_t ns = Sim_NowNs() - start_ns;
+    sim_dwt.CYCCNT = (uint32_t)(ns * (SystemCoreClock / 1000000U) / 1000U);
+    return &sim_dwt;
+}
+
+HAL_StatusTypeDef HAL_Init(void) {
+    return HAL_OK;
+}
+
+void HAL_IncTick(void) {
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)((Sim_NowNs() - start_ns) / 1000000ULL);
+}
+
+void HAL_Delay(uint32_t ms) {
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* ========== Interrupt masking ========== */
+
+/*
+ * PRIMASK is per thread: the NVIC thread runs handlers with it set, and
+ * the main thread sets it by taking the NVIC lock. Nesting (saving and
+ * restoring PRIMASK) works because only the 0 -> 1 edge locks.
+ */
+uint32_t __get_PRIMASK(void) {
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t value) {
+    if (value && !primask) {
+        while (atomic_load(&irq_waiting)) {
+            sched_yield();
+        }
+        pthread_mutex_lock(&irq_lock);
+        primask = 1;
+    } else if (!value && primask) {
+        primask = 0;
+        pthread_mutex_unlock(&irq_lock);
+    }
+}
+
+void __disable_irq(void) {
+    __set_PRIMASK(1);
+}
+
+void __enable_irq(void) {
+    __set_PRIMASK(0);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub) {
+    (void)irqn;
+    (void)preempt;
+    (void)sub;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn) {
+    (void)irqn;
+}
+
+/* ========== GPIO ========== */
+
+/**
+ * DIP switches encode (address - 1), active low; digital inputs idle high
+ */
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    static const struct {
+        GPIO_TypeDef *port;
+        uint16_t pin;
+    } dip[4] = {
+        { DIP_SW1_PORT, DIP_SW1_PIN },
+        { DIP_SW2_PORT, DIP_SW2_PIN },
+        { DIP_SW3_PORT, DIP_SW3_PIN },
+        { DIP_SW4_PORT, DIP_SW4_PIN },
+    };
+    uint8_t code = (uint8_t)(sim_config.address - 1);
+
+    for (int i = 0; i < 4; i++) {
+        if (port == dip[i].port && pin == dip[i].pin) {
+            return (code & (1 << i)) ? GPIO_PIN_RESET : GPIO_PIN_SET;
+        }
+    }
+    return GPIO_PIN_SET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    (void)port;
+    (void)pin;
+    (void)state;
+}
+
+/* ========== DMA / UART ========== */
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t src, uint32_t dst, uint32_t length) {
+    (void)src;
+    hdma->buffer = (uint8_t *)(uintptr_t)dst;
+    hdma->length = length;
+    hdma->Instance->CNDTR = length;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+    (void)hdma;
+}
+
+HAL_StatusTypeDef HAL_UART_ReceiverTimeout_Config(UART_HandleTypeDef *huart, uint32_t bits) {
+    huart->rx_timeout_bits = bits;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_EnableReceiverTimeout(UART_HandleTypeDef *huart) {
+    (void)huart;
+    return HAL_OK;
+}
+
+/**
+ * Queue a reply; the NVIC thread writes it to the pty after its wire time
+ */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+    if (size > SIM_TX_BUFFER_SIZE) {
+        return HAL_ERROR;
+    }
+
+    pthread_mutex_lock(&sim_lock);
+    if (huart->gState != HAL_UART_STATE_READY) {
+        pthread_mutex_unlock(&sim_lock);
+        return HAL_BUSY;
+    }
+    memcpy(tx_buffer, data, size);
+    tx_length = size;
+    tx_done_ns = Sim_NowNs() + size * Sim_CharNs();
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    pthread_mutex_unlock(&sim_lock);
+
+    return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+/* ========== I2C ========== */
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
+    (void)hi2c;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
+    pthread_mutex_lock(&sim_lock);
+    i2c_transfer[hi2c->bus == 2].active = false;
+    pthread_mutex_unlock(&sim_lock);
+    return HAL_OK;
+}
+
+/* Blocking transfers (driver init) complete immediately */
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len, uint32_t timeout) {
+    (void)timeout;
+    Sim_I2CDevice_t *dev = Sim_FindDevice(hi2c, addr);
+    if (dev == NULL) {
+        return HAL_ERROR;
+    }
+    Sim_DeviceWrite(dev, false, 0, data, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len, uint32_t timeout) {
+    (void)timeout;
+    Sim_I2CDevice_t *dev = Sim_FindDevice(hi2c, addr);
+    if (dev == NULL) {
+        return HAL_ERROR;
+    }
+    Sim_DeviceRead(dev, false, 0, data, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len, uint32_t timeout) {
+    (void)reg_size;
+    (void)timeout;
+    Sim_I2CDevice_t *dev = Sim_FindDevice(hi2c, addr);
+    if (dev == NULL) {
+        return HAL_ERROR;
+    }
+    Sim_DeviceWrite(dev, true, (uint8_t)reg, data, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len, uint32_t timeout) {
+    (void)reg_size;
+    (void)timeout;
+    Sim_I2CDevice_t *dev = Sim_FindDevice(hi2c, addr);
+    if (dev == NULL) {
+        return HAL_ERROR;
+    }
+    Sim_DeviceRead(dev, true, (uint8_t)reg, data, len);
+    return HAL_OK;
+}
+
+/* Interrupt-driven transfers complete on the NVIC thread after the device latency */
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len) {
+    return Sim_StartI2C(hi2c, SIM_I2C_TX, addr, 0, data, len);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint8_t *data, uint16_t len) {
+    return Sim_StartI2C(hi2c, SIM_I2C_RX, addr, 0, data, len);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len) {
+    (void)reg_size;
+    return Sim_StartI2C(hi2c, SIM_I2C_MEM_TX, addr, (uint8_t)reg, data, len);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t *data, uint16_t len) {
+    (void)reg_size;
+    return Sim_StartI2C(hi2c, SIM_I2C_MEM_RX, addr, (uint8_t)reg, data, len);
+}
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c) {
+    (void)hi2c;
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c) {
+    (void)hi2c;
+}
+
+static HAL_StatusTypeDef Sim_StartI2C(I2C_HandleTypeDef *hi2c, Sim_I2COp_t op, uint16_t addr,
+                                      uint8_t reg, uint8_t *data, uint16_t len) {
+    Sim_I2CTransfer_t *xfer = &i2c_transfer[hi2c->bus == 2];
+    Sim_I2CDevice_t *dev = Sim_FindDevice(hi2c, addr);
+
+    pthread_mutex_lock(&sim_lock);
+    if (xfer->active) {
+        pthread_mutex_unlock(&sim_lock);
+        return HAL_BUSY;
+    }
+
+    xfer->op = op;
+    xfer->hi2c = hi2c;
+    xfer->device = dev;
+    xfer->reg = reg;
+    xfer->data = data;
+    xfer->length = len;
+    xfer->due_ns = Sim_NowNs() + 1000ULL * (dev ? dev->latency_us : SIM_I2C_MISSING_US);
+    xfer->active = true;
+    pthread_mutex_unlock(&sim_lock);
+
+    return HAL_OK;
+}
+
+static Sim_I2CDevice_t* Sim_FindDevice(I2C_HandleTypeDef *hi2c, uint16_t addr) {
+    uint8_t address = (uint8_t)(addr >> 1);
+    for (uint8_t i = 0; i < device_count; i++) {
+        if (devices[i].bus == hi2c->bus && devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Register-file devices auto-increment from the register (memory access)
+ * or the pointer set by the first written byte; stream devices replay
+ * their bytes on every read and ignore writes.
+ */
+static void Sim_DeviceRead(Sim_I2CDevice_t *dev, bool mem, uint8_t reg, uint8_t *data, uint16_t len) {
+    if (dev->stream) {
+        for (uint16_t i = 0; i < len; i++) {
+            data[i] = dev->stream_len ? dev->stream_data[i % dev->stream_len] : 0xFF;
+        }
+        return;
+    }
+
+    uint8_t pointer = mem ? reg : dev->pointer;
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = dev->regs[pointer++];
+    }
+    dev->pointer = pointer;
+}
+
+static void Sim_DeviceWrite(Sim_I2CDevice_t *dev, bool mem, uint8_t reg, const uint8_t *data, uint16_t len) {
+    if (dev->stream) {
+        return;
+    }
+
+    if (!mem) {
+        if (len == 0) {
+            return;
+        }
+        reg = data[0];
+        data++;
+        len--;
+    }
+
+    dev->pointer = reg;
+    for (uint16_t i = 0; i < len; i++) {
+        dev->regs[reg++] = data[i];
+    }
+}
+
+/* ========== CRC ========== */
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc) {
+    if (hcrc->Init.CRCLength != CRC_POLYLENGTH_16B && hcrc->Init.CRCLength != CRC_POLYLENGTH_8B &&
+        hcrc->Init.CRCLength != CRC_POLYLENGTH_32B) {
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+/**
+ * Bit-serial model of the CRC unit for byte input: MSB-first shift
+ * register, optional per-byte input reversal and output reversal
+ */
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t *buffer, uint32_t length) {
+    const uint8_t *data = (const uint8_t *)buffer;
+    uint32_t width = hcrc->Init.CRCLength;
+    uint32_t top = 1UL << (width - 1);
+    uint32_t mask = (width == 32) ? 0xFFFFFFFFUL : (1UL << width) - 1;
+    uint32_t poly = (hcrc->Init.DefaultPolynomialUse == DEFAULT_POLYNOMIAL_ENABLE) ? 0x04C11DB7UL : hcrc->Init.GeneratingPolynomial;
+    uint32_t crc = ((hcrc->Init.DefaultInitValueUse == DEFAULT_INIT_VALUE_ENABLE) ? 0xFFFFFFFFUL : hcrc->Init.InitValue) & mask;
+
+    for (uint32_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for (int b = 0; b < 8; b++) {
+            bool in = (hcrc->Init.InputDataInversionMode == CRC_INPUTDATA_INVERSION_BYTE)
+                      ? (byte >> b) & 1 : (byte >> (7 - b)) & 1;
+            bool msb = (crc & top) != 0;
+            crc = (crc << 1) & mask;
+            if (msb ^ in) {
+                crc ^= poly;
+            }
+        }
+    }
+
+    if (hcrc->Init.OutputDataInversionMode == CRC_OUTPUTDATA_INVERSION_ENABLE) {
+        uint32_t reflected = 0;
+        for (uint32_t b = 0; b < width; b++) {
+            if (crc & (1UL << b)) {
+                reflected |= 1UL << (width - 1 - b);
+            }
+        }
+        crc = reflected;
+    }
+    return crc & mask;
+}
+
+/* ========== ADC / TIM / DAC ========== */
+
+HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc, uint32_t mode) {
+    (void)hadc;
+    (void)mode;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *data, uint32_t length) {
+    hadc->scan = data;
+    hadc->length = length;
+    sim_adc = hadc;
+    Sim_UpdateAdc();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim) {
+    htim->running = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef *hdac, uint32_t channel) {
+    (void)hdac;
+    (void)channel;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef *hdac, uint32_t channel, uint32_t alignment, uint32_t value) {
+    (void)alignment;
+    hdac->value[channel == DAC_CHANNEL_2] = value;
+    return HAL_OK;
+}
@@ -0,0 +1,57 @@
+/**
+ * Virtual Hub Hardware - Host Simulator
+ * SprigRig Sensor Hub
+ *
+ * Stands in for the STM32G431 peripherals the hub firmware uses:
+ *  - USART2 + RX/TX DMA, as a pty the host opens like a USB-RS485 adapter
+ *  - I2C1/I2C2, as scripted fake devices with per-device transfer latency
+ *  - ADC1 scan DMA, as constant levels plus noise
+ *  - NVIC, as one "interrupt" thread holding a lock that __disable_irq()
+ *    also takes, so PRIMASK sections stay atomic against ISRs
+ */
+
+#ifndef __HAL_SIM_H
+#define __HAL_SIM_H
+
+#include "stm32g4xx_hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Configuration */
+#define SIM_I2C_DEVICE_MAX      16
+#define SIM_I2C_STREAM_MAX      64
+#define SIM_ADC_CHANNELS        4
+#define SIM_ADC_PERIOD_US       10000   // TIM6 trigger rate (100Hz)
+
+/* Simulator options */
+typedef struct {
+    const char *link_path;              // Symlink to the pty slave (NULL = none)
+    const char *device_script;          // I2C device script (NULL = no devices)
+    uint8_t address;                    // DIP switch address (1-16)
+    uint16_t adc_level[SIM_ADC_CHANNELS];
+    uint16_t adc_noise;                 // +/- counts
+} Sim_Config_t;
+
+/* Scripted I2C device */
+typedef struct {
+    uint8_t bus;                        // 1 = I2C1, 2 = I2C2
+    uint8_t address;                    // 7-bit
+    uint32_t latency_us;                // Interrupt-driven transfer duration
+    bool stream;                        // true: reads return stream[], writes ignored
+    uint8_t regs[256];                  // Register file (auto-increment)
+    uint8_t pointer;                    // Register pointer for plain reads/writes
+    uint8_t stream_data[SIM_I2C_STREAM_MAX];
+    uint8_t stream_len;
+} Sim_I2CDevice_t;
+
+/* Function prototypes */
+bool Sim_Init(const Sim_Config_t *config, UART_HandleTypeDef *huart);
+bool Sim_LoadDevices(const char *path);
+void Sim_Start(void);
+const char* Sim_GetPtyName(void);
+
+/* Firmware interrupt handlers raised by the virtual NVIC (stm32g4xx_it.c) */
+void USART2_IRQHandler(void);
+void PendSV_Handler(void);
+
+#endif /* __HAL_SIM_H */
@@ -0,0 +1,345 @@
+/**
+ * Modbus Benchmark - Host Simulator
+ * SprigRig Sensor Hub
+ *
+ * Drives a hub (hubsim's pty, or a real hub on a USB-RS485 adapter) with
+ * the app's polling mix and reports request latency, throughput and the
+ * hub's own timing diagnostics. Exits non-zero when a threshold is
+ * exceeded, so CI can catch turnaround or blocking regressions.
+ *
+ * Usage: hubbench -p port [-a address] [-b baud] [-n requests]
+ *                 [--max-p99-us N] [--max-turnaround-us N] [--max-loop-us N]
+ */
+
+#define _GNU_SOURCE
+#include "main.h"
+#include "sensor_hub.h"
+#include "history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Configuration */
+#define BENCH_TIMEOUT_MS        1000
+#define BENCH_DIAG_EVERY        10      // Every Nth request reads the diagnostics block
+#define BENCH_HISTORY_EVERY     25      // Every Nth request reads history (0x41)
+#define BENCH_POLL_REGS         25      // 0-24: data, sequences, change map
+#define BENCH_DIAG_REGS         (REG_DIAG_TASK_BASE + SENSOR_TASK_COUNT * REG_DIAG_TASK_REGS - REG_DIAG_LOOP_AVG_US)
+
+/* Options */
+static const char *port;
+static uint8_t address = 1;
+static uint32_t baud = 9600;
+static uint32_t request_count = 500;
+static uint32_t max_p99_us;
+static uint32_t max_turnaround_us;
+static uint32_t max_loop_us;
+
+static int fd = -1;
+
+static const char *task_names[SENSOR_TASK_COUNT] = {
+    "analog", "digital", "bme280_1", "bme280_2", "bh1750",
+    "scd40", "atlas", "history", "diag"
+};
+
+/* Private function prototypes */
+static uint64_t Bench_NowUs(void);
+static uint16_t Bench_CRC16(const uint8_t *data, uint16_t length);
+static bool Bench_Open(void);
+static int Bench_Transact(const uint8_t *pdu, uint16_t pdu_len, uint8_t *resp, uint16_t resp_max);
+static bool Bench_ReadRegisters(uint16_t start, uint16_t count, uint16_t *values);
+static int Bench_CompareU32(const void *a, const void *b);
+
+int main(int argc, char **argv) {
+    static const struct option options[] = {
+        { "port", required_argument, NULL, 'p' },
+        { "address", required_argument, NULL, 'a' },
+        { "baud", required_argument, NULL, 'b' },
+        { "requests", required_argument, NULL, 'n' },
+        { "max-p99-us", required_argument, NULL, 'P' },
+        { "max-turnaround-us", required_argument, NULL, 'T' },
+        { "max-loop-us", required_argument, NULL, 'L' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:a:b:n:", options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': port = optarg; break;
+            case 'a': address = (uint8_t)atoi(optarg); break;
+            case 'b': baud = (uint32_t)atoi(optarg); break;
+            case 'n': request_count = (uint32_t)atoi(optarg); break;
+            case 'P': max_p99_us = (uint32_t)atoi(optarg); break;
+            case 'T': max_turnaround_us = (uint32_t)atoi(optarg); break;
+            case 'L': max_loop_us = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s -p port [-a address] [-b baud] [-n requests] "
+                        "[--max-p99-us N] [--max-turnaround-us N] [--max-loop-us N]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (port == NULL || request_count == 0 || baud == 0) {
+        fprintf(stderr, "%s: -p port is required\n", argv[0]);
+        return 2;
+    }
+    if (!Bench_Open()) {
+        return 1;
+    }
+
+    // Clear the hub's statistics so the report covers this run only
+    uint8_t reset[5] = { 0x06, REG_DIAG_RESET >> 8, REG_DIAG_RESET & 0xFF, 0x00, 0x01 };
+    uint8_t resp[256];
+    if (Bench_Transact(reset, sizeof(reset), resp, sizeof(resp)) <= 0) {
+        fprintf(stderr, "hubbench: no response from address %u on %s\n", address, port);
+        return 1;
+    }
+
+    uint32_t *latency = calloc(request_count, sizeof(uint32_t));
+    uint32_t completed = 0;
+    uint32_t timeouts = 0;
+    uint32_t errors = 0;
+    uint64_t bytes = 0;
+    uint64_t start = Bench_NowUs();
+
+    for (uint32_t i = 0; i < request_count; i++) {
+        uint8_t pdu[8];
+        uint16_t pdu_len;
+
+        if (i % BENCH_HISTORY_EVERY == BENCH_HISTORY_EVERY - 1) {
+            // Oldest records first, as a reconnecting app would
+            pdu[0] = HISTORY_FC_READ;
+            pdu[1] = pdu[2] = pdu[3] = pdu[4] = 0;
+            pdu[5] = HISTORY_MAX_PER_RESPONSE;
+            pdu_len = 6;
+        } else {
+            uint16_t first = REG_CHANNEL_1;
+            uint16_t count = BENCH_POLL_REGS;
+            if (i % BENCH_DIAG_EVERY == BENCH_DIAG_EVERY - 1) {
+                first = REG_DIAG_LOOP_AVG_US;
+                count = BENCH_DIAG_REGS;
+            }
+            pdu[0] = 0x03;
+            pdu[1] = first >> 8;
+            pdu[2] = first & 0xFF;
+            pdu[3] = count >> 8;
+            pdu[4] = count & 0xFF;
+            pdu_len = 5;
+        }
+
+        uint64_t t0 = Bench_NowUs();
+        int n = Bench_Transact(pdu, pdu_len, resp, sizeof(resp));
+        uint64_t elapsed = Bench_NowUs() - t0;
+
+        if (n == 0) {
+            timeouts++;
+        } else if (n < 0 || (resp[1] & 0x80)) {
+            errors++;
+        } else {
+            latency[completed++] = (uint32_t)elapsed;
+            bytes += (uint64_t)pdu_len + 3 + (uint64_t)n + 2;
+        }
+    }
+
+    double seconds = (double)(Bench_NowUs() - start) / 1e6;
+
+    // Hub-side view: worst blocking in the sensor loop, turnaround, per task
+    uint16_t diag[BENCH_DIAG_REGS];
+    bool have_diag = Bench_ReadRegisters(REG_DIAG_LOOP_AVG_US, BENCH_DIAG_REGS, diag);
+#define DIAG(reg)   (diag[(reg) - REG_DIAG_LOOP_AVG_US])
+
+    printf("requests      %u ok, %u timeouts, %u errors\n", completed, timeouts, errors);
+    printf("throughput    %.1f frames/s, %.0f bytes/s (%lu baud)\n",
+           completed / seconds, bytes / seconds, (unsigned long)baud);
+
+    uint32_t p99 = 0;
+    if (completed > 0) {
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < completed; i++) {
+            total += latency[i];
+        }
+        qsort(latency, completed, sizeof(uint32_t), Bench_CompareU32);
+        p99 = latency[(completed * 99 + 99) / 100 - 1];
+        printf("latency us    min %u  avg %lu  p50 %u  p99 %u  max %u\n",
+               latency[0], (unsigned long)(total / completed),
+               latency[completed / 2], p99, latency[completed - 1]);
+    }
+
+    if (have_diag) {
+        printf("hub loop us   avg %u  max %u (worst-case blocking)\n",
+               DIAG(REG_DIAG_LOOP_AVG_US), DIAG(REG_DIAG_LOOP_MAX_US));
+        printf("hub jitter    max %u ms\n", DIAG(REG_DIAG_JITTER_MAX_MS));
+        printf("turnaround us last %u  max %u\n",
+               DIAG(REG_DIAG_MB_TURN_US), DIAG(REG_DIAG_MB_TURN_MAX_US));
+        printf("modbus        %u CRC errors, %u dropped frames\n",
+               DIAG(REG_DIAG_CRC_ERRORS), DIAG(REG_DIAG_MB_OVERRUNS));
+        printf("i2c           bus1 %u errors / max %u us, bus2 %u errors / max %u us\n",
+               DIAG(REG_DIAG_I2C1_ERRORS), DIAG(REG_DIAG_I2C1_MAX_US),
+               DIAG(REG_DIAG_I2C2_ERRORS), DIAG(REG_DIAG_I2C2_MAX_US));
+        printf("task          min us  avg us  max us  overruns\n");
+        for (int t = 0; t < SENSOR_TASK_COUNT; t++) {
+            uint16_t base = REG_DIAG_TASK_BASE + t * REG_DIAG_TASK_REGS;
+            printf("  %-10s  %6u  %6u  %6u  %8u\n", task_names[t],
+                   DIAG(base), DIAG(base + 1), DIAG(base + 2), DIAG(base + 3));
+        }
+    } else {
+        printf("hub diagnostics unavailable (firmware older than 1.3?)\n");
+    }
+
+    // Thresholds
+    int status = 0;
+    if (completed == 0 || timeouts > 0 || errors > 0) {
+        fprintf(stderr, "FAIL: %u timeouts, %u errors\n", timeouts, errors);
+        status = 1;
+    }
+    if (max_p99_us && p99 > max_p99_us) {
+        fprintf(stderr, "FAIL: p99 latency %u us > %u us\n", p99, max_p99_us);
+        status = 1;
+    }
+    if (max_turnaround_us && have_diag && DIAG(REG_DIAG_MB_TURN_MAX_US) > max_turnaround_us) {
+        fprintf(stderr, "FAIL: hub turnaround %u us > %u us\n", DIAG(REG_DIAG_MB_TURN_MAX_US), max_turnaround_us);
+        status = 1;
+    }
+    if (max_loop_us && have_diag && DIAG(REG_DIAG_LOOP_MAX_US) > max_loop_us) {
+        fprintf(stderr, "FAIL: hub loop %u us > %u us\n", DIAG(REG_DIAG_LOOP_MAX_US), max_loop_us);
+        status = 1;
+    }
+#undef DIAG
+
+    free(latency);
+    close(fd);
+    return status;
+}
+
+/**
+ * Open the port raw at the requested baud (ignored by a pty)
+ */
+static bool Bench_Open(void) {
+    fd = open(port, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(port);
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, baud == 19200 ? B19200 : baud == 38400 ? B38400 :
+                         baud == 57600 ? B57600 : baud == 115200 ? B115200 : B9600);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH);
+    return true;
+}
+
+/**
+ * Send one request and collect the reply
+ * The reply length follows from its header (exception, echo, or byte
+ * count), so no inter-frame gap is waited out. Returns the frame length
+ * without CRC, 0 on timeout, -1 on a bad frame.
+ */
+static int Bench_Transact(const uint8_t *pdu, uint16_t pdu_len, uint8_t *resp, uint16_t resp_max) {
+    uint8_t frame[260];
+    frame[0] = address;
+    memcpy(&frame[1], pdu, pdu_len);
+    uint16_t crc = Bench_CRC16(frame, pdu_len + 1);
+    frame[pdu_len + 1] = crc & 0xFF;
+    frame[pdu_len + 2] = crc >> 8;
+
+    if (write(fd, frame, pdu_len + 3) != pdu_len + 3) {
+        return -1;
+    }
+
+    uint64_t deadline = Bench_NowUs() + BENCH_TIMEOUT_MS * 1000ULL;
+    uint16_t length = 0;
+    uint16_t expected = resp_max;
+
+    while (length < expected) {
+        uint64_t now = Bench_NowUs();
+        if (now >= deadline) {
+            break;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, (int)((deadline - now + 999) / 1000)) <= 0) {
+            break;
+        }
+        ssize_t n = read(fd, &resp[length], resp_max - length);
+        if (n <= 0) {
+            break;
+        }
+        length += (uint16_t)n;
+
+        if (length >= 3) {
+            if (resp[1] & 0x80) {
+                expected = 5;                   // Addr + FC + Code + CRC
+            } else if (resp[1] == 0x05 || resp[1] == 0x06 || resp[1] == 0x0F || resp[1] == 0x10) {
+                expected = 8;                   // Echo
+            } else {
+                expected = 5 + resp[2];         // Addr + FC + ByteCount + data + CRC
+            }
+            if (expected > resp_max) {
+                return -1;
+            }
+        }
+    }
+
+    if (length == 0) {
+        return 0;
+    }
+    if (length < expected || resp[0] != address) {
+        return -1;
+    }
+    uint16_t got = resp[length - 2] | (resp[length - 1] << 8);
+    if (got != Bench_CRC16(resp, length - 2)) {
+        return -1;
+    }
+    return length - 2;
+}
+
+/**
+ * Read a block of holding registers (0x03)
+ */
+static bool Bench_ReadRegisters(uint16_t start, uint16_t count, uint16_t *values) {
+    uint8_t pdu[5] = { 0x03, start >> 8, start & 0xFF, count >> 8, count & 0xFF };
+    uint8_t resp[256];
+    int n = Bench_Transact(pdu, sizeof(pdu), resp, sizeof(resp));
+    if (n != 3 + count * 2 || resp[1] != 0x03) {
+        return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        values[i] = (resp[3 + i * 2] << 8) | resp[4 + i * 2];
+    }
+    return true;
+}
+
+static uint16_t Bench_CRC16(const uint8_t *data, uint16_t length) {
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static uint64_t Bench_NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int Bench_CompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
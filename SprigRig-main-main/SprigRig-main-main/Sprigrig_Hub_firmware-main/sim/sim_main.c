@@ -0,0 +1,142 @@
+/**
+ * SprigRig Sensor Hub Firmware - Host Simulator
+ *
+ * Runs the unmodified hub application (sensor scheduler, Modbus slave,
+ * history, diagnostics) on Linux against the virtual hardware in
+ * hal_sim.c. The Modbus port is a pty; point the app or hubbench at it.
+ *
+ * Usage: hubsim [-a address] [-b baud] [-l link] [-d devices.txt]
+ */
+
+#include "main.h"
+#include "modbus.h"
+#include "sensor_hub.h"
+#include "history.h"
+#include "diag.h"
+#include "hal_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+
+/* Peripheral handles (same names as main.c; stm32g4xx_it.c uses them) */
+ADC_HandleTypeDef hadc1;
+CRC_HandleTypeDef hcrc;
+DAC_HandleTypeDef hdac1;
+I2C_HandleTypeDef hi2c1 = { .bus = 1 };
+I2C_HandleTypeDef hi2c2 = { .bus = 2 };
+SPI_HandleTypeDef hspi2;
+UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+TIM_HandleTypeDef htim6;
+
+Modbus_HandleTypeDef modbus;
+
+/* Register blocks behind the handles */
+static USART_TypeDef usart2;
+static DMA_Channel_TypeDef dma1_channel1;
+static DMA_Channel_TypeDef dma1_channel2;
+
+/**
+ * Main entry point
+ */
+int main(int argc, char **argv) {
+    Sim_Config_t sim = {
+        .link_path = NULL,
+        .device_script = NULL,
+        .address = 1,
+        .adc_level = { 1241, 2482, 1000, 3000 },    // 8mA, 16mA, ~2.4V, ~7.3V
+        .adc_noise = 4
+    };
+    uint32_t baud = 9600;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:l:d:n:")) != -1) {
+        switch (opt) {
+            case 'a': sim.address = (uint8_t)atoi(optarg); break;
+            case 'b': baud = (uint32_t)atoi(optarg); break;
+            case 'l': sim.link_path = optarg; break;
+            case 'd': sim.device_script = optarg; break;
+            case 'n': sim.adc_noise = (uint16_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-a address] [-b baud] [-l link] [-d devices.txt] [-n adc_noise]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (sim.address < 1 || sim.address > 16 || baud == 0) {
+        fprintf(stderr, "address must be 1-16 and baud non-zero\n");
+        return 2;
+    }
+
+    /* Virtual peripherals (MX_*_Init equivalents) */
+    huart2.Instance = &usart2;
+    huart2.Init.BaudRate = baud;
+    huart2.hdmarx = &hdma_usart2_rx;
+    huart2.hdmatx = &hdma_usart2_tx;
+    huart2.gState = HAL_UART_STATE_READY;
+    hdma_usart2_rx.Instance = &dma1_channel1;
+    hdma_usart2_tx.Instance = &dma1_channel2;
+
+    hcrc.Instance = CRC;
+    hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_DISABLE;
+    hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_DISABLE;
+    hcrc.Init.GeneratingPolynomial = 0x8005;
+    hcrc.Init.CRCLength = CRC_POLYLENGTH_16B;
+    hcrc.Init.InitValue = 0xFFFF;
+    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+    HAL_CRC_Init(&hcrc);
+
+    HAL_Init();
+    if (!Sim_Init(&sim, &huart2)) {
+        return 1;
+    }
+
+    /* Cycle counter for timing diagnostics */
+    Diag_Init();
+
+    /* Application wiring - keep in step with main.c */
+    SensorHub_Config_t hub_config = {
+        .hadc = &hadc1,
+        .htim_adc = &htim6,
+        .hdac = &hdac1,
+        .hi2c1 = &hi2c1,
+        .hi2c2 = &hi2c2,
+        .hspi2 = &hspi2,
+        .modbus = &modbus
+    };
+    SensorHub_Init(&hub_config);
+
+    uint8_t modbus_address = SensorHub_ReadAddress();
+
+    Modbus_Init(&modbus, &huart2,
+                modbus_address,
+                SensorHub_GetRegisters(),
+                SensorHub_GetRegisterCount());
+
+    bool crc_unit = Modbus_UseCRCUnit(&modbus, &hcrc);
+
+    Modbus_SetWriteCallback(&modbus, SensorHub_OnRegisterWrite);
+    Modbus_SetWritableCallback(&modbus, SensorHub_IsRegisterWritable);
+    Modbus_SetReadCallback(&modbus, SensorHub_OnRegisterRead);
+    Modbus_SetFunctionHandler(&modbus, HISTORY_FC_READ, History_HandleRead);
+    Modbus_SetDeviceId(&modbus, "SprigRig", "SprigRig Sensor Hub", SensorHub_GetRevision());
+
+    printf("hubsim: address %u, %lu baud, %s CRC, port %s%s%s\n",
+           modbus_address, (unsigned long)baud, crc_unit ? "unit" : "table", Sim_GetPtyName(),
+           sim.link_path ? " -> " : "", sim.link_path ? sim.link_path : "");
+    fflush(stdout);
+
+    /* Interrupts on */
+    Sim_Start();
+
+    while (1) {
+        SensorHub_Update();
+
+        // Let the NVIC thread in promptly on single-core hosts; on the MCU
+        // an interrupt preempts this loop immediately
+        sched_yield();
+    }
+}
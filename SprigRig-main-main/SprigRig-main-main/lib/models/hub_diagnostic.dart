@@ -7,6 +7,18 @@ class HubDiagnostic {
   final double? averageResponseTimeMs;
   final String? lastErrorMessage;
 
+  // Hub firmware telemetry (diagnostics registers 48-95, firmware 1.3+)
+  final int? loopAvgUs;
+  final int? loopMaxUs;
+  final int? jitterMaxMs;
+  final int? turnaroundUs;
+  final int? turnaroundMaxUs;
+  final int? crcErrors;
+  final int? frameOverruns;
+  final int? i2cErrors;
+  final int? i2cMaxUs;
+  final String? taskTiming; // JSON: task name -> {min_us, avg_us, max_us, overruns}
+
   HubDiagnostic({
     required this.id,
     required this.hubId,
@@ -15,6 +27,16 @@ class HubDiagnostic {
     this.successfulReads = 0,
     this.averageResponseTimeMs,
     this.lastErrorMessage,
+    this.loopAvgUs,
+    this.loopMaxUs,
+    this.jitterMaxMs,
+    this.turnaroundUs,
+    this.turnaroundMaxUs,
+    this.crcErrors,
+    this.frameOverruns,
+    this.i2cErrors,
+    this.i2cMaxUs,
+    this.taskTiming,
   });
 
   factory HubDiagnostic.fromMap(Map<String, dynamic> map) {
@@ -26,6 +48,16 @@ class HubDiagnostic {
       successfulReads: map['successful_reads'] as int? ?? 0,
       averageResponseTimeMs: (map['average_response_time_ms'] as num?)?.toDouble(),
       lastErrorMessage: map['last_error_message'] as String?,
+      loopAvgUs: map['loop_avg_us'] as int?,
+      loopMaxUs: map['loop_max_us'] as int?,
+      jitterMaxMs: map['jitter_max_ms'] as int?,
+      turnaroundUs: map['turnaround_us'] as int?,
+      turnaroundMaxUs: map['turnaround_max_us'] as int?,
+      crcErrors: map['crc_errors'] as int?,
+      frameOverruns: map['frame_overruns'] as int?,
+      i2cErrors: map['i2c_errors'] as int?,
+      i2cMaxUs: map['i2c_max_us'] as int?,
+      taskTiming: map['task_timing'] as String?,
     );
   }
 
@@ -38,6 +70,16 @@ class HubDiagnostic {
       'successful_reads': successfulReads,
       'average_response_time_ms': averageResponseTimeMs,
       'last_error_message': lastErrorMessage,
+      'loop_avg_us': loopAvgUs,
+      'loop_max_us': loopMaxUs,
+      'jitter_max_ms': jitterMaxMs,
+      'turnaround_us': turnaroundUs,
+      'turnaround_max_us': turnaroundMaxUs,
+      'crc_errors': crcErrors,
+      'frame_overruns': frameOverruns,
+      'i2c_errors': i2cErrors,
+      'i2c_max_us': i2cMaxUs,
+      'task_timing': taskTiming,
     };
   }
 }
@@ -124,6 +124,8 @@ class Sensor {
         return ['co2'];
       case 'pressure_sensor':
         return ['pressure'];
+      case 'flow_rate':
+        return ['flow_rate'];
       default:
         return ['temperature'];
     }
@@ -243,3 +245,50 @@ class SensorReading {
     );
   }
 }
+
+/// Min/avg/max of one sensor's readings over a time bucket
+/// Rows of sensor_readings_hourly/daily, or buckets computed on the fly.
+class SensorReadingRollup {
+  final int sensorId;
+  final String readingType;
+  final int timestamp;    // Bucket start, Unix seconds
+  final double avgValue;
+  final double minValue;
+  final double maxValue;
+  final int sampleCount;
+
+  SensorReadingRollup({
+    required this.sensorId,
+    required this.readingType,
+    required this.timestamp,
+    required this.avgValue,
+    required this.minValue,
+    required this.maxValue,
+    required this.sampleCount,
+  });
+
+  /// This bucket with one more sample added
+  SensorReadingRollup merge(double value) {
+    final count = sampleCount + 1;
+    return SensorReadingRollup(
+      sensorId: sensorId,
+      readingType: readingType,
+      timestamp: timestamp,
+      avgValue: avgValue + (value - avgValue) / count,
+      minValue: value < minValue ? value : minValue,
+      maxValue: value > maxValue ? value : maxValue,
+      sampleCount: count,
+    );
+  }
+
+  /// The bucket average as a plain reading (for code that plots readings)
+  SensorReading toReading() {
+    return SensorReading(
+      id: 0,
+      sensorId: sensorId,
+      readingType: readingType,
+      value: avgValue,
+      timestamp: timestamp,
+    );
+  }
+}
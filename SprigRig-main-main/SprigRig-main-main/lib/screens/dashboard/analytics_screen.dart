@@ -127,7 +127,8 @@ class _AnalyticsScreenState extends State<AnalyticsScreen> {
       if (sensor.sensorType.contains('light')) readingType = 'light_intensity';
       if (sensor.sensorType.contains('soil')) readingType = 'moisture';
 
-      final readings = await _databaseHelper.getSensorReadings(
+      // Bucketed series; long ranges come from the hourly/daily rollups
+      final series = await _databaseHelper.getSensorSeries(
         sensorId,
         readingType,
         startTime: start.millisecondsSinceEpoch ~/ 1000,
@@ -135,13 +136,12 @@ class _AnalyticsScreenState extends State<AnalyticsScreen> {
       );
 
       final points = <FlSpot>[];
-      for (final reading in readings) {
-        final timestamp = reading.timestamp.toDouble();
-        final value = reading.value;
-        points.add(FlSpot(timestamp, value));
+      for (final bucket in series) {
+        final timestamp = bucket.timestamp.toDouble();
+        points.add(FlSpot(timestamp, bucket.avgValue));
         
-        if (value < globalMin) globalMin = value;
-        if (value > globalMax) globalMax = value;
+        if (bucket.minValue < globalMin) globalMin = bucket.minValue;
+        if (bucket.maxValue > globalMax) globalMax = bucket.maxValue;
       }
       newData[sensorId] = points;
     }
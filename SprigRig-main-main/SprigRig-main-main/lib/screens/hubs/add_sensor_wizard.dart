@@ -2,6 +2,7 @@ import 'package:flutter/material.dart';
 import '../../models/sensor_hub.dart';
 import '../../models/sensor.dart';
 import '../../services/database_helper.dart';
+import '../../services/sensor_ingest_pipeline.dart';
 import '../../widgets/common/virtual_keyboard_wrapper.dart';
 
 class AddSensorWizard extends StatefulWidget {
@@ -209,6 +210,7 @@ class _AddSensorWizardState extends State<AddSensorWizard> {
       );
 
       await _db.addSensor(newSensor);
+      SensorIngestPipeline.instance.invalidate();
       
       if (mounted) {
         Navigator.pop(context);
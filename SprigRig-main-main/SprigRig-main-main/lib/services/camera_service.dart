@@ -1,5 +1,4 @@
 // lib/services/camera_service.dart
-import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
 import 'package:flutter/foundation.dart';
@@ -10,6 +9,7 @@ import '../models/timelapse_image.dart';
 import '../services/database_helper.dart';
 import '../services/hardware_service.dart';
 import '../services/interval_scheduler_service.dart';
+import '../services/job_scheduler.dart';
 
 /// CameraService handles camera operations including capture, timelapse, and management
 class CameraService {
@@ -23,7 +23,7 @@ class CameraService {
   final HardwareService _hardware = HardwareService.instance;
 
   // State
-  final Map<int, Timer> _timelapseTimers = {};
+  final Map<int, ScheduledJob> _timelapseJobs = {};
   bool _isInitialized = false;
 
   /// Initialize the camera service
@@ -43,11 +43,11 @@ class CameraService {
 
   /// Dispose the camera service
   void dispose() {
-    // Cancel all timelapse timers
-    for (final timer in _timelapseTimers.values) {
-      timer.cancel();
+    // Cancel all timelapse jobs
+    for (final job in _timelapseJobs.values) {
+      job.cancel();
     }
-    _timelapseTimers.clear();
+    _timelapseJobs.clear();
     _isInitialized = false;
   }
 
@@ -86,16 +86,17 @@ class CameraService {
         throw Exception('Camera is disabled: $cameraId');
       }
 
-      // Cancel existing timer if running
-      _timelapseTimers[cameraId]?.cancel();
+      // Cancel existing job if running
+      _timelapseJobs[cameraId]?.cancel();
 
       // Calculate interval in milliseconds
       final intervalMs = (camera.captureIntervalHours * 60 * 60 * 1000).round();
 
-      // Start periodic timer
-      _timelapseTimers[cameraId] = Timer.periodic(
+      // Start periodic capture; a shot up to a minute late is fine
+      _timelapseJobs[cameraId] = JobScheduler.instance.every(
+        'timelapse_$cameraId',
         Duration(milliseconds: intervalMs),
-        (timer) async {
+        () async {
           try {
             // Check if we should only capture when lights are on
             if (camera.onlyWhenLightsOn) {
@@ -118,6 +119,7 @@ class CameraService {
             debugPrint('Error capturing timelapse image: $e');
           }
         },
+        tolerance: const Duration(minutes: 1),
       );
 
       debugPrint('Timelapse started for camera $cameraId');
@@ -128,14 +130,14 @@ class CameraService {
 
   /// Stop timelapse for a camera
   void stopTimelapse(int cameraId) {
-    _timelapseTimers[cameraId]?.cancel();
-    _timelapseTimers.remove(cameraId);
+    _timelapseJobs[cameraId]?.cancel();
+    _timelapseJobs.remove(cameraId);
     debugPrint('Timelapse stopped for camera $cameraId');
   }
 
   /// Check if timelapse is running for a camera
   bool isTimelapseRunning(int cameraId) {
-    return _timelapseTimers.containsKey(cameraId);
+    return _timelapseJobs.containsKey(cameraId);
   }
 
   /// Get all cameras
@@ -171,7 +173,7 @@ class CameraService {
     await _db.updateCamera(camera);
 
     // Restart timelapse if it was running
-    if (camera.id != null && _timelapseTimers.containsKey(camera.id)) {
+    if (camera.id != null && _timelapseJobs.containsKey(camera.id)) {
       stopTimelapse(camera.id!);
       // Note: growId would need to be tracked separately for restart
       debugPrint('Camera ${camera.id} updated, timelapse needs manual restart');
@@ -0,0 +1,350 @@
+import 'dart:async';
+import 'package:flutter/foundation.dart';
+import '../models/environmental_control.dart';
+import '../models/sensor.dart';
+import 'database_helper.dart';
+import 'job_scheduler.dart';
+import 'sensor_ingest_pipeline.dart';
+
+/// Switches a control on or off; supplied by the owner of the controls
+typedef ControlActuator = Future<void> Function(int controlId, bool state);
+
+/// Sensor-threshold controls evaluated on every new sample
+/// Enabled 'sensor' schedules are compiled into in-memory rules with
+/// hysteresis and minimum on/off times, indexed by sensor. Each sample from
+/// [SensorIngestPipeline.samples] updates only the rules that read that
+/// sensor and switches the affected controls straight away; nothing on
+/// that path reads the database. Rules are recompiled by [reload].
+///
+/// A control is only switched off by the engine if the engine holds it on,
+/// and not while another of its schedules (time, astral, ...) wants it on;
+/// controls on for any other reason are left alone.
+///
+/// Per-control settings (control_settings), all optional:
+///   sensor_id          sensor to follow (default: every zone sensor of the type)
+///   reading_type       temperature, humidity, ... (default by control type)
+///   trigger_direction  'above' or 'below' (default by control type)
+///   hysteresis         release band past the threshold
+///   min_on_seconds / min_off_seconds
+class ControlRuleEngine {
+  static ControlRuleEngine? _instance;
+  static ControlRuleEngine get instance => _instance ??= ControlRuleEngine._internal();
+
+  ControlRuleEngine._internal();
+
+  static const int DEFAULT_MIN_ON_SECONDS = 30;
+  static const int DEFAULT_MIN_OFF_SECONDS = 30;
+
+  // Samples older than this (history backfill) don't drive outputs
+  static const int MAX_SAMPLE_AGE_SECONDS = 60;
+
+  static const Map<String, double> DEFAULT_HYSTERESIS = {
+    'temperature': 0.5,
+    'humidity': 2.0,
+    'moisture': 2.0,
+    'ph': 0.1,
+    'ec': 50.0,
+    'co2': 50.0,
+  };
+
+  // Control type name -> (reading type, direction) when not configured
+  static const Map<String, List<String>> TYPE_DEFAULTS = {
+    'ventilation': ['temperature', 'above'],
+    'vent_actuator': ['temperature', 'above'],
+    'heating': ['temperature', 'below'],
+    'humidity': ['humidity', 'below'],
+    'water_pump': ['moisture', 'below'],
+    'ph_control': ['ph', 'above'],
+    'ec_control': ['ec', 'below'],
+  };
+
+  final DatabaseHelper _db = DatabaseHelper();
+
+  ControlActuator? _actuate;
+  bool Function(int controlId)? _isActive;
+  Future<bool> Function(ControlSchedule schedule)? _scheduleWantsOn;
+  StreamSubscription<SensorSample>? _subscription;
+
+  Map<int, List<_ThresholdRule>> _rulesBySensor = {};
+  Map<int, _ControlState> _controls = {};
+  Map<int, _ThresholdRule> _rulesBySchedule = {};
+
+  // Totals since start
+  int samplesEvaluated = 0;
+  int switches = 0;
+
+  /// Compile the rules and start following the sample stream
+  /// [scheduleWantsOn] says whether a non-sensor schedule wants its control
+  /// on right now; it is evaluated in memory, without database reads.
+  Future<void> start({
+    required ControlActuator actuate,
+    required bool Function(int controlId) isActive,
+    required Future<bool> Function(ControlSchedule schedule) scheduleWantsOn,
+  }) async {
+    _actuate = actuate;
+    _isActive = isActive;
+    _scheduleWantsOn = scheduleWantsOn;
+    await reload();
+    _subscription ??= SensorIngestPipeline.instance.samples.listen(_onSample);
+  }
+
+  void stop() {
+    _subscription?.cancel();
+    _subscription = null;
+    for (final control in _controls.values) {
+      control.retry?.cancel();
+    }
+  }
+
+  /// Whether the rule for sensor schedule [scheduleId] currently calls for on
+  bool isTriggered(int scheduleId) => _rulesBySchedule[scheduleId]?.triggered ?? false;
+
+  /// Recompile rules from control_schedules / control_settings
+  /// Latched states and switch times carry over for unchanged schedules.
+  Future<void> reload() async {
+    final rulesBySensor = <int, List<_ThresholdRule>>{};
+    final controls = <int, _ControlState>{};
+    final rulesBySchedule = <int, _ThresholdRule>{};
+
+    try {
+      for (final zone in await _db.getZones()) {
+        if (!zone.enabled) continue;
+
+        final zoneControls = await _db.getZoneControls(zone.id);
+        List<Sensor>? zoneSensors;
+
+        for (final control in zoneControls) {
+          if (!control.enabled) continue;
+
+          final allSchedules = (await _db.getControlSchedules(control.id)).where((s) => s.enabled);
+          final schedules = allSchedules
+              .where((s) => s.scheduleType == 'sensor' && s.triggerThreshold != null)
+              .toList();
+          if (schedules.isEmpty) continue;
+
+          zoneSensors ??= await _db.getZoneSensors(zone.id);
+          final settings = {
+            for (final setting in await _db.getControlSettings(control.id))
+              setting.settingName: setting.settingValue
+          };
+
+          final state = controls[control.id] = _ControlState(
+            control.id,
+            minOnSeconds: int.tryParse(settings['min_on_seconds'] ?? '') ?? DEFAULT_MIN_ON_SECONDS,
+            minOffSeconds: int.tryParse(settings['min_off_seconds'] ?? '') ?? DEFAULT_MIN_OFF_SECONDS,
+            lastSwitched: _controls[control.id]?.lastSwitched,
+            ownedOn: _controls[control.id]?.ownedOn ?? false,
+            otherSchedules: [
+              for (final s in allSchedules)
+                if (s.scheduleType != 'sensor') s
+            ],
+          );
+
+          for (final schedule in schedules) {
+            final rule = _compile(control, schedule, settings, zoneSensors, state);
+            if (rule == null) continue;
+
+            final previous = _rulesBySchedule[schedule.id];
+            if (previous != null) {
+              rule.triggered = previous.triggered;
+              rule.latest.addAll(previous.latest);
+            }
+
+            state.rules.add(rule);
+            rulesBySchedule[schedule.id] = rule;
+            for (final sensorId in rule.sensorIds) {
+              (rulesBySensor[sensorId] ??= []).add(rule);
+            }
+          }
+        }
+      }
+    } catch (e) {
+      debugPrint('Error compiling sensor rules: $e');
+      return;
+    }
+
+    for (final control in _controls.values) {
+      control.retry?.cancel();
+    }
+    _rulesBySensor = rulesBySensor;
+    _controls = controls;
+    _rulesBySchedule = rulesBySchedule;
+    debugPrint('Sensor rules: ${rulesBySchedule.length} rule(s) on ${controls.length} control(s)');
+  }
+
+  _ThresholdRule? _compile(EnvironmentalControl control, ControlSchedule schedule,
+      Map<String, String> settings, List<Sensor> zoneSensors, _ControlState state) {
+    final defaults = TYPE_DEFAULTS[control.typeName] ?? const ['temperature', 'above'];
+    final readingType = settings['reading_type'] ?? defaults[0];
+    final below = (settings['trigger_direction'] ?? defaults[1]) == 'below';
+    final hysteresis = double.tryParse(settings['hysteresis'] ?? '') ??
+        DEFAULT_HYSTERESIS[readingType] ?? 0.0;
+
+    final explicit = int.tryParse(settings['sensor_id'] ?? '');
+    final sensorIds = explicit != null
+        ? [explicit]
+        : [
+            for (final sensor in zoneSensors)
+              if (sensor.enabled && sensor.isActive) sensor.id
+          ];
+    if (sensorIds.isEmpty) {
+      debugPrint('Sensor rule ${schedule.id} (${control.name}): no sensors in zone');
+      return null;
+    }
+
+    final threshold = schedule.triggerThreshold!;
+    return _ThresholdRule(
+      scheduleId: schedule.id,
+      control: state,
+      readingType: readingType,
+      sensorIds: sensorIds,
+      // Latch on at the threshold, release once back past it by the hysteresis
+      onAt: threshold,
+      offAt: below ? threshold + hysteresis : threshold - hysteresis,
+      below: below,
+    );
+  }
+
+  void _onSample(SensorSample sample) {
+    final rules = _rulesBySensor[sample.sensorId];
+    if (rules == null) return;
+
+    final now = DateTime.now().millisecondsSinceEpoch ~/ 1000;
+    if (now - sample.timestamp > MAX_SAMPLE_AGE_SECONDS) return;
+
+    samplesEvaluated++;
+    for (final rule in rules) {
+      if (rule.readingType != sample.readingType) continue;
+      rule.latest[sample.sensorId] = sample.value;
+      rule.evaluate();
+      _drive(rule.control);
+    }
+  }
+
+  /// Bring a control in line with its rules, within its minimum on/off time
+  void _drive(_ControlState control) {
+    if (control.switching) return;
+    final want = control.rules.any((r) => r.triggered);
+    final isOn = _isActive?.call(control.controlId) ?? false;
+
+    if (want && isOn) {
+      // Already on (another schedule or the user); the rules hold it from now
+      control.ownedOn = true;
+      return;
+    }
+    if (!want && !(isOn && control.ownedOn)) {
+      // Off already, or on for someone else
+      control.ownedOn = false;
+      return;
+    }
+
+    final last = control.lastSwitched;
+    if (last != null) {
+      final hold = Duration(seconds: isOn ? control.minOnSeconds : control.minOffSeconds);
+      final remaining = hold - DateTime.now().difference(last);
+      if (remaining > Duration.zero) {
+        control.retry ??= JobScheduler.instance.after('sensor_rule_hold', remaining, () {
+          control.retry = null;
+          _drive(control);
+        }, priority: JobPriority.control);
+        return;
+      }
+    }
+
+    control.retry?.cancel();
+    control.retry = null;
+    control.switching = true;
+    _switch(control, want).whenComplete(() => control.switching = false);
+  }
+
+  Future<void> _switch(_ControlState control, bool on) async {
+    try {
+      if (!on && await _heldElsewhere(control)) {
+        // Another schedule wants it on: hand it over rather than switch off
+        control.ownedOn = false;
+        return;
+      }
+
+      control.lastSwitched = DateTime.now();
+      control.ownedOn = on;
+      switches++;
+      debugPrint('Sensor rule switching control ${control.controlId} ${on ? 'on' : 'off'}');
+      await _actuate!(control.controlId, on);
+    } catch (e) {
+      debugPrint('Sensor rule failed to switch control ${control.controlId}: $e');
+    }
+  }
+
+  /// Whether one of the control's time, astral or interval schedules wants it on
+  Future<bool> _heldElsewhere(_ControlState control) async {
+    for (final schedule in control.otherSchedules) {
+      if (await _scheduleWantsOn!(schedule)) return true;
+    }
+    return false;
+  }
+}
+
+class _ControlState {
+  final int controlId;
+  final int minOnSeconds;
+  final int minOffSeconds;
+  final List<_ThresholdRule> rules = [];
+  final List<ControlSchedule> otherSchedules; // Enabled non-sensor schedules, as of reload
+  DateTime? lastSwitched;
+  bool ownedOn; // Switched on (or held on) by the rules
+  ScheduledJob? retry;
+  bool switching = false;
+
+  _ControlState(this.controlId, {
+    required this.minOnSeconds,
+    required this.minOffSeconds,
+    this.lastSwitched,
+    this.ownedOn = false,
+    this.otherSchedules = const [],
+  });
+}
+
+class _ThresholdRule {
+  final int scheduleId;
+  final _ControlState control;
+  final String readingType;
+  final List<int> sensorIds;
+  final double onAt;
+  final double offAt;
+  final bool below; // Trigger when the value falls to onAt instead of rising
+  final Map<int, double> latest = {}; // Sensor ID -> last value
+  bool triggered = false;
+
+  _ThresholdRule({
+    required this.scheduleId,
+    required this.control,
+    required this.readingType,
+    required this.sensorIds,
+    required this.onAt,
+    required this.offAt,
+    required this.below,
+  });
+
+  /// Update [triggered] from the mean of the sensors heard from so far
+  void evaluate() {
+    double sum = 0;
+    for (final value in latest.values) {
+      sum += value;
+    }
+    final value = sum / latest.length;
+
+    if (below) {
+      if (value <= onAt) {
+        triggered = true;
+      } else if (value >= offAt) {
+        triggered = false;
+      }
+    } else {
+      if (value >= onAt) {
+        triggered = true;
+      } else if (value <= offAt) {
+        triggered = false;
+      }
+    }
+  }
+}
@@ -43,7 +43,7 @@ class DatabaseHelper {
   DatabaseHelper._internal();
 
   static Database? _database;
-  static const int _databaseVersion = 42;
+  static const int _databaseVersion = 44;
 
   Future<Database> get database async {
     if (_database != null) return _database!;
@@ -78,6 +78,14 @@ class DatabaseHelper {
   Future<void> _onConfigure(Database db) async {
     // Enable foreign keys
     await db.execute('PRAGMA foreign_keys = ON');
+
+    // Write-ahead log: readers don't block the sensor writer, and a commit
+    // appends to the log instead of rewriting pages in place. NORMAL only
+    // syncs at checkpoints, which is safe in WAL mode (a power cut can lose
+    // the last commits, not corrupt the file). journal_mode returns a row,
+    // so it must go through rawQuery.
+    await db.rawQuery('PRAGMA journal_mode = WAL');
+    await db.execute('PRAGMA synchronous = NORMAL');
   }
 
   Future<void> _createDatabase(Database db, int version) async {
@@ -1114,6 +1122,85 @@ class DatabaseHelper {
         debugPrint('Error applying version 37 migration: $e');
       }
     }
+
+    if (oldVersion < 43) {
+      // Version 43: Hub firmware timing telemetry in hub_diagnostics
+      debugPrint('Applying version 43 migration: Hub timing diagnostics');
+      try {
+        final List<Map<String, dynamic>> columns = await db.rawQuery('PRAGMA table_info(hub_diagnostics)');
+        final columnNames = columns.map((c) => c['name'] as String).toList();
+
+        const newColumns = {
+          'average_response_time_ms': 'REAL',
+          'loop_avg_us': 'INTEGER',
+          'loop_max_us': 'INTEGER',
+          'jitter_max_ms': 'INTEGER',
+          'turnaround_us': 'INTEGER',
+          'turnaround_max_us': 'INTEGER',
+          'crc_errors': 'INTEGER',
+          'frame_overruns': 'INTEGER',
+          'i2c_errors': 'INTEGER',
+          'i2c_max_us': 'INTEGER',
+          'task_timing': 'TEXT',
+        };
+        for (final entry in newColumns.entries) {
+          if (!columnNames.contains(entry.key)) {
+            await db.execute('ALTER TABLE hub_diagnostics ADD COLUMN ${entry.key} ${entry.value}');
+          }
+        }
+      } catch (e) {
+        debugPrint('Error applying version 43 migration: $e');
+      }
+    }
+
+    if (oldVersion < 44) {
+      // Version 44: Populate the reading rollups (fresh installs since v37
+      // never created them; upgraded ones have them empty)
+      debugPrint('Applying version 44 migration: Sensor reading rollups');
+      try {
+        await _createReadingRollupTables(db);
+        await _rebuildReadingRollups(db);
+      } catch (e) {
+        debugPrint('Error applying version 44 migration: $e');
+      }
+    }
+  }
+
+  /// Rollup tables: one row per sensor, reading type and UTC hour/day
+  Future<void> _createReadingRollupTables(DatabaseExecutor db) async {
+    for (final level in ['hourly', 'daily']) {
+      final column = level == 'hourly' ? 'hour_timestamp' : 'day_timestamp';
+      await db.execute('''
+        CREATE TABLE IF NOT EXISTS sensor_readings_$level (
+          id INTEGER PRIMARY KEY AUTOINCREMENT,
+          sensor_id INTEGER NOT NULL,
+          reading_type TEXT NOT NULL,
+          $column INTEGER NOT NULL,
+          avg_value REAL,
+          min_value REAL,
+          max_value REAL,
+          sample_count INTEGER,
+          FOREIGN KEY (sensor_id) REFERENCES sensors(id),
+          UNIQUE(sensor_id, reading_type, $column)
+        )
+      ''');
+    }
+    await db.execute('CREATE INDEX IF NOT EXISTS idx_readings_sensor_time ON sensor_readings(sensor_id, reading_type, timestamp)');
+  }
+
+  /// Recompute both rollup tables from the raw readings
+  Future<void> _rebuildReadingRollups(DatabaseExecutor db) async {
+    for (final level in _rollupLevels) {
+      await db.execute('DELETE FROM ${level.table}');
+      await db.execute('''
+        INSERT INTO ${level.table}
+          (sensor_id, reading_type, ${level.column}, avg_value, min_value, max_value, sample_count)
+        SELECT sensor_id, reading_type, (timestamp / ${level.seconds}) * ${level.seconds},
+               AVG(value), MIN(value), MAX(value), COUNT(*)
+        FROM sensor_readings
+        GROUP BY sensor_id, reading_type, timestamp / ${level.seconds}
+      ''');
+    }
   }
 
   Future<void> _createScheduleTables(Database db) async {
@@ -1248,7 +1335,18 @@ class DatabaseHelper {
         timestamp TEXT NOT NULL,
         successful_reads INTEGER DEFAULT 0,
         communication_errors INTEGER DEFAULT 0,
+        average_response_time_ms REAL,
         last_error_message TEXT,
+        loop_avg_us INTEGER,
+        loop_max_us INTEGER,
+        jitter_max_ms INTEGER,
+        turnaround_us INTEGER,
+        turnaround_max_us INTEGER,
+        crc_errors INTEGER,
+        frame_overruns INTEGER,
+        i2c_errors INTEGER,
+        i2c_max_us INTEGER,
+        task_timing TEXT,
         FOREIGN KEY (hub_id) REFERENCES sensor_hubs (id)
       )
     ''');
@@ -2353,7 +2451,17 @@ class DatabaseHelper {
           communication_errors INTEGER DEFAULT 0,
           successful_reads INTEGER DEFAULT 0,
           average_response_time_ms REAL,
-          last_error_message TEXT
+          last_error_message TEXT,
+          loop_avg_us INTEGER,
+          loop_max_us INTEGER,
+          jitter_max_ms INTEGER,
+          turnaround_us INTEGER,
+          turnaround_max_us INTEGER,
+          crc_errors INTEGER,
+          frame_overruns INTEGER,
+          i2c_errors INTEGER,
+          i2c_max_us INTEGER,
+          task_timing TEXT
         )
       ''');
 
@@ -2369,6 +2477,9 @@ class DatabaseHelper {
         )
       ''');
 
+      // Hourly/daily rollups of sensor_readings
+      await _createReadingRollupTables(db);
+
       // Watering timers table
       await db.execute('''
         CREATE TABLE IF NOT EXISTS watering_timers (
@@ -4419,6 +4530,9 @@ class DatabaseHelper {
       where: 'sensor_id = ?',
       whereArgs: [sensorId],
     );
+    for (final level in _rollupLevels) {
+      await db.delete(level.table, where: 'sensor_id = ?', whereArgs: [sensorId]);
+    }
 
     // Delete the sensor
     return await db.delete('sensors', where: 'id = ?', whereArgs: [sensorId]);
@@ -4431,15 +4545,162 @@ class DatabaseHelper {
     int? timestamp,
   }) async {
     final db = await database;
+    final reading = SensorReading(
+      id: 0,
+      sensorId: sensorId,
+      readingType: readingType,
+      value: value,
+      timestamp: timestamp ?? (DateTime.now().millisecondsSinceEpoch ~/ 1000),
+    );
+
+    return await db.transaction((txn) async {
+      final id = await txn.insert('sensor_readings', {
+        'sensor_id': reading.sensorId,
+        'reading_type': reading.readingType,
+        'value': reading.value,
+        'timestamp': reading.timestamp,
+      });
+      await _foldIntoRollups(txn, [reading]);
+      return id;
+    });
+  }
+
+  /// Insert many readings in one transaction
+  /// Rows go in as multi-row INSERTs of up to 200 rows (800 bound values,
+  /// under SQLite's default 999 limit), so a flush compiles a handful of
+  /// statements instead of one per reading. Used by SensorReadingBuffer.
+  Future<void> insertSensorReadings(List<SensorReading> readings) async {
+    if (readings.isEmpty) return;
+    const rowsPerStatement = 200;
+    final db = await database;
 
-    return await db.insert('sensor_readings', {
-      'sensor_id': sensorId,
-      'reading_type': readingType,
-      'value': value,
-      'timestamp': timestamp ?? (DateTime.now().millisecondsSinceEpoch ~/ 1000),
+    await db.transaction((txn) async {
+      for (int start = 0; start < readings.length; start += rowsPerStatement) {
+        final end = start + rowsPerStatement < readings.length ? start + rowsPerStatement : readings.length;
+        final chunk = readings.sublist(start, end);
+
+        final args = <Object>[];
+        for (final reading in chunk) {
+          args..add(reading.sensorId)..add(reading.readingType)..add(reading.value)..add(reading.timestamp);
+        }
+        await txn.rawInsert(
+          'INSERT INTO sensor_readings (sensor_id, reading_type, value, timestamp) VALUES '
+          '${List.filled(chunk.length, '(?, ?, ?, ?)').join(', ')}',
+          args,
+        );
+      }
+      await _foldIntoRollups(txn, readings);
     });
   }
 
+  static const List<_RollupLevel> _rollupLevels = [
+    _RollupLevel('sensor_readings_hourly', 'hour_timestamp', 3600),
+    _RollupLevel('sensor_readings_daily', 'day_timestamp', 86400),
+  ];
+
+  /// Merge newly inserted readings into the hourly and daily rollups
+  /// Readings are pre-aggregated per bucket, so a flush costs one upsert
+  /// per sensor/type/bucket rather than one per reading.
+  Future<void> _foldIntoRollups(Transaction txn, List<SensorReading> readings) async {
+    final batch = txn.batch();
+
+    for (final level in _rollupLevels) {
+      final buckets = <String, SensorReadingRollup>{};
+      for (final r in readings) {
+        final bucket = (r.timestamp ~/ level.seconds) * level.seconds;
+        final key = '${r.sensorId}|${r.readingType}|$bucket';
+        final existing = buckets[key];
+        buckets[key] = existing == null
+            ? SensorReadingRollup(
+                sensorId: r.sensorId, readingType: r.readingType, timestamp: bucket,
+                avgValue: r.value, minValue: r.value, maxValue: r.value, sampleCount: 1)
+            : existing.merge(r.value);
+      }
+
+      for (final b in buckets.values) {
+        batch.rawInsert('''
+          INSERT INTO ${level.table}
+            (sensor_id, reading_type, ${level.column}, avg_value, min_value, max_value, sample_count)
+          VALUES (?, ?, ?, ?, ?, ?, ?)
+          ON CONFLICT(sensor_id, reading_type, ${level.column}) DO UPDATE SET
+            avg_value = (avg_value * sample_count + excluded.avg_value * excluded.sample_count)
+                        / (sample_count + excluded.sample_count),
+            min_value = MIN(min_value, excluded.min_value),
+            max_value = MAX(max_value, excluded.max_value),
+            sample_count = sample_count + excluded.sample_count
+        ''', [b.sensorId, b.readingType, b.timestamp, b.avgValue, b.minValue, b.maxValue, b.sampleCount]);
+      }
+    }
+
+    await batch.commit(noResult: true);
+  }
+
+  /// Readings between [startTime] and [endTime] (Unix seconds), about
+  /// [points] buckets of min/avg/max, oldest first
+  /// Served from the coarsest source whose resolution still gives [points]
+  /// buckets: daily rollups, hourly rollups, or the raw table grouped in
+  /// SQL. A month at the default 300 points reads ~720 hourly rows instead
+  /// of millions of raw ones. Buckets at the edges of the range cover
+  /// whole hours/days.
+  Future<List<SensorReadingRollup>> getSensorSeries(
+    int sensorId,
+    String readingType, {
+    required int startTime,
+    required int endTime,
+    int points = 300,
+  }) async {
+    final db = await database;
+    final span = endTime - startTime;
+    final bucket = span > points ? span ~/ points : 1;
+
+    _RollupLevel? level;
+    for (final l in _rollupLevels.reversed) {
+      if (bucket >= l.seconds) {
+        level = l;
+        break;
+      }
+    }
+
+    final List<Map<String, dynamic>> rows;
+    if (level == null) {
+      rows = await db.rawQuery('''
+        SELECT (timestamp / ?) * ? AS ts, AVG(value) AS avg_value, MIN(value) AS min_value,
+               MAX(value) AS max_value, COUNT(*) AS sample_count
+        FROM sensor_readings
+        WHERE sensor_id = ? AND reading_type = ? AND timestamp >= ? AND timestamp <= ?
+        GROUP BY timestamp / ?
+        ORDER BY ts
+      ''', [bucket, bucket, sensorId, readingType, startTime, endTime, bucket]);
+    } else {
+      // Rows of the level, regrouped to the requested bucket (sample-weighted)
+      final groupSeconds = (bucket ~/ level.seconds) * level.seconds;
+      rows = await db.rawQuery('''
+        SELECT (${level.column} / ?) * ? AS ts,
+               SUM(avg_value * sample_count) / SUM(sample_count) AS avg_value,
+               MIN(min_value) AS min_value, MAX(max_value) AS max_value,
+               SUM(sample_count) AS sample_count
+        FROM ${level.table}
+        WHERE sensor_id = ? AND reading_type = ? AND ${level.column} >= ? AND ${level.column} <= ?
+        GROUP BY ${level.column} / ?
+        ORDER BY ts
+      ''', [groupSeconds, groupSeconds, sensorId, readingType,
+            (startTime ~/ level.seconds) * level.seconds, endTime, groupSeconds]);
+    }
+
+    return [
+      for (final row in rows)
+        SensorReadingRollup(
+          sensorId: sensorId,
+          readingType: readingType,
+          timestamp: row['ts'] as int,
+          avgValue: (row['avg_value'] as num).toDouble(),
+          minValue: (row['min_value'] as num).toDouble(),
+          maxValue: (row['max_value'] as num).toDouble(),
+          sampleCount: row['sample_count'] as int,
+        )
+    ];
+  }
+
   Future<List<SensorReading>> getSensorReadings(
     int sensorId,
     String readingType, {
@@ -5759,6 +6020,22 @@ Future<void> createIoChannelsForModule(int moduleNumber, int channelCount, {Stri
     return await db.insert('hub_diagnostics', map);
   }
 
+  /// Save hub status changes and diagnostics rows from the poller in one batch
+  Future<void> saveHubPollResults(List<SensorHub> hubs, List<HubDiagnostic> diagnostics) async {
+    if (hubs.isEmpty && diagnostics.isEmpty) return;
+    final db = await database;
+    final batch = db.batch();
+    for (final hub in hubs) {
+      batch.update('sensor_hubs', hub.toMap(), where: 'id = ?', whereArgs: [hub.id]);
+    }
+    for (final diagnostic in diagnostics) {
+      final map = diagnostic.toMap();
+      map.remove('id');
+      batch.insert('hub_diagnostics', map);
+    }
+    await batch.commit(noResult: true);
+  }
+
 
 
   // --- Guardian Helper Methods ---
@@ -5907,3 +6184,12 @@ Future<void> createIoChannelsForModule(int moduleNumber, int channelCount, {Stri
     }
   }
 }
+
+/// One rollup table: name, bucket column and bucket width in seconds
+class _RollupLevel {
+  final String table;
+  final String column;
+  final int seconds;
+
+  const _RollupLevel(this.table, this.column, this.seconds);
+}
@@ -10,6 +10,8 @@ import '../services/astral_simulation_service.dart';
 import '../services/database_helper.dart';
 import '../services/hardware_service.dart';
 import '../services/astral_service.dart';
+import '../services/control_rule_engine.dart';
+import '../services/job_scheduler.dart';
 
 /// Environmental Control Service manages automated environmental controls
 /// based on schedules, sensor readings, and astral events
@@ -24,14 +26,18 @@ class EnvironmentalControlService {
   final DatabaseHelper _db = DatabaseHelper();
   final HardwareService _hardware = HardwareService.instance;
   final AstralService _astral = AstralService.instance;
+  final ControlRuleEngine _rules = ControlRuleEngine.instance;
   
   // Constants
   static const Duration _sensorLogInterval = Duration(minutes: 5);
+  static const Duration _ruleReloadInterval = Duration(minutes: 5);
+  static const Duration _scheduleCheckInterval = Duration(minutes: 1);
 
   // State
-  final Map<int, Timer> _scheduleTimers = {};
-  final Map<int, Timer> _sensorTimers = {};
-  Timer? _sensorLogTimer;
+  final JobScheduler _jobs = JobScheduler.instance;
+  final Map<int, ScheduledJob> _scheduleJobs = {};
+  ScheduledJob? _ruleReloadJob;
+  ScheduledJob? _sensorLogJob;
   bool _isInitialized = false;
 
   // Active state tracking
@@ -71,16 +77,14 @@ class EnvironmentalControlService {
 
   /// Dispose the environmental control service
   void dispose() {
-    // Cancel all timers
-    for (final timer in _scheduleTimers.values) {
-      timer.cancel();
+    // Cancel all jobs
+    for (final job in _scheduleJobs.values) {
+      job.cancel();
     }
-    for (final timer in _sensorTimers.values) {
-      timer.cancel();
-    }
-    _scheduleTimers.clear();
-    _sensorTimers.clear();
-    _sensorLogTimer?.cancel();
+    _scheduleJobs.clear();
+    _ruleReloadJob?.cancel();
+    _rules.stop();
+    _sensorLogJob?.cancel();
     _activeControlsController.close();
     _isInitialized = false;
   }
@@ -214,9 +218,10 @@ class EnvironmentalControlService {
 
           for (final schedule in schedules) {
             if (!schedule.enabled) continue;
+            if (schedule.scheduleType == 'sensor') continue; // Driven by the rule engine
 
             // Start monitoring this schedule
-            await _startScheduleTimer(control, schedule);
+            await _startScheduleCheck(control, schedule);
           }
         }
       }
@@ -225,33 +230,36 @@ class EnvironmentalControlService {
     }
   }
 
-  /// Start a timer for a specific schedule
-  Future<void> _startScheduleTimer(
+  /// Start a periodic check for a specific schedule
+  /// Checks may start up to 10 s late, so all schedules' checks share a
+  /// handful of wakeups a minute instead of one each.
+  Future<void> _startScheduleCheck(
     EnvironmentalControl control,
     ControlSchedule schedule,
   ) async {
     try {
-      // Cancel existing timer
-      _scheduleTimers[schedule.id]?.cancel();
+      // Cancel existing check
+      _scheduleJobs[schedule.id]?.cancel();
 
       // Run immediately to check state
       await _processSchedule(control, schedule);
 
       // Then run periodically
-      final scheduleTimer = Timer.periodic(const Duration(minutes: 1), (
-        timer,
-      ) async {
-        await _processSchedule(control, schedule);
-        
-        // Also check astral lighting if this is a grow light
-        if (control.controlTypeId == 1) {
-          await _checkAstralLighting(control.zoneId);
-        }
-      });
-
-      _scheduleTimers[schedule.id] = scheduleTimer;
+      _scheduleJobs[schedule.id] = _jobs.every(
+        'schedule_${schedule.id}',
+        _scheduleCheckInterval,
+        () async {
+          await _processSchedule(control, schedule);
+
+          // Also check astral lighting if this is a grow light
+          if (control.controlTypeId == 1) {
+            await _checkAstralLighting(control.zoneId);
+          }
+        },
+        tolerance: const Duration(seconds: 10),
+      );
     } catch (e) {
-      debugPrint('Error starting schedule timer: $e');
+      debugPrint('Error starting schedule check: $e');
     }
   }
 
@@ -428,18 +436,10 @@ class EnvironmentalControlService {
     }
   }
 
-  /// Check sensor-based schedule
+  /// Check sensor-based schedule (latched state kept by the rule engine)
   Future<bool> _checkSensorSchedule(ControlSchedule schedule) async {
     if (schedule.triggerThreshold == null) return false;
-
-    try {
-      // This would need more implementation based on specific sensor requirements
-      // For now, return false
-      return false;
-    } catch (e) {
-      debugPrint('Error checking sensor schedule: $e');
-      return false;
-    }
+    return _rules.isTriggered(schedule.id);
   }
 
   /// Check interval-based schedule
@@ -487,31 +487,28 @@ class EnvironmentalControlService {
   }
 
   /// Start sensor monitoring for threshold-based controls
+  /// Rules react to each sample from the ingestion pipeline; the reload
+  /// job only picks up edited schedules and settings.
   Future<void> _startSensorMonitoring() async {
     try {
-      // Get all zones
-      final zones = await _db.getZones();
-
-      for (final zone in zones) {
-        if (!zone.enabled) continue;
-
-        // Get sensors for this zone
-        final sensors = await _db.getZoneSensors(zone.id);
+      await _rules.start(
+        actuate: setControl,
+        isActive: isControlActive,
+        scheduleWantsOn: _checkScheduleCondition,
+      );
 
-        if (sensors.isNotEmpty) {
-          // Start sensor monitoring timer for this zone
-          _sensorTimers[zone.id] = Timer.periodic(
-            const Duration(minutes: 5),
-            (timer) => _checkSensorThresholds(zone.id),
-          );
-        }
-      }
+      _ruleReloadJob?.cancel();
+      _ruleReloadJob = _jobs.every('sensor_rule_reload', _ruleReloadInterval, _rules.reload,
+          priority: JobPriority.background, tolerance: const Duration(minutes: 1));
     } catch (e) {
       debugPrint('Error starting sensor monitoring: $e');
     }
   }
 
-  /// Check sensor thresholds for a zone
+  /// Recompile sensor rules now, e.g. after editing a threshold
+  Future<void> reloadSensorRules() => _rules.reload();
+
+  /// Apply the astral lighting simulation for a zone
   Future<void> _checkAstralLighting(int zoneId) async {
     final settings = await _db.getAstralSimulationSettings(zoneId);
     if (settings == null || !settings.enabled) return;
@@ -559,31 +556,6 @@ class EnvironmentalControlService {
     }
     return 0.0;
   }
-  Future<void> _checkSensorThresholds(int zoneId) async {
-    try {
-      // Get controls with sensor-based schedules
-      final controls = await getZoneControls(zoneId);
-
-      for (final control in controls) {
-        if (!control.enabled) continue;
-
-        final schedules = await _db.getControlSchedules(control.id);
-        final sensorSchedules = schedules.where(
-          (s) => s.scheduleType == 'sensor' && s.enabled,
-        );
-
-        for (final schedule in sensorSchedules) {
-          final shouldActivate = await _checkSensorSchedule(schedule);
-          if (shouldActivate) {
-            await setControl(control.id, true);
-          }
-        }
-      }
-    } catch (e) {
-      debugPrint('Error checking sensor thresholds for zone $zoneId: $e');
-    }
-  }
-
 
   /// Set lighting state for a zone
   Future<void> _setLightingState(int zoneId, bool state) async {
@@ -591,14 +563,13 @@ class EnvironmentalControlService {
       final controls = await getZoneControls(zoneId);
       final lights = controls.where((c) => c.controlTypeId == 1); // 1 = Grow Light
       
-      for (final light in lights) {
-        if (!light.enabled) continue;
-        
-        // Only change if state is different to avoid spamming hardware
-        if (isControlActive(light.id) != state) {
-          await setControl(light.id, state);
-        }
-      }
+      // Only change if state is different to avoid spamming hardware.
+      // Switched together so the relay coalescer sends one write per board.
+      await Future.wait([
+        for (final light in lights)
+          if (light.enabled && isControlActive(light.id) != state)
+            setControl(light.id, state)
+      ]);
     } catch (e) {
       debugPrint('Error setting lighting state for zone $zoneId: $e');
     }
@@ -629,13 +600,15 @@ class EnvironmentalControlService {
 
   /// Start sensor data logging
   void _startSensorLogging() {
-    _sensorLogTimer?.cancel();
-    _sensorLogTimer = Timer.periodic(_sensorLogInterval, (timer) async {
-      await _logAllSensors();
-    });
+    _sensorLogJob?.cancel();
+    _sensorLogJob = _jobs.every('sensor_log', _sensorLogInterval, _logAllSensors,
+        priority: JobPriority.background, tolerance: const Duration(minutes: 1));
   }
 
   /// Log data from all enabled sensors
+  /// Hub-attached sensors are logged by the hub poll as samples arrive;
+  /// this reads the ones wired to the controller itself. Each value goes
+  /// through the same calibration/deadband/batching pipeline.
   Future<void> _logAllSensors() async {
     try {
       final zones = await _db.getZones();
@@ -644,21 +617,14 @@ class EnvironmentalControlService {
 
         final sensors = await _db.getZoneSensors(zone.id);
         for (final sensor in sensors) {
-          if (!sensor.enabled) continue;
-
-          // In a real implementation, we would read from hardware
-          // For now, we simulate readings or read from last known state
-          // This is a placeholder for actual hardware reading logic
-          try {
-            // Simulate reading based on sensor type
-            // double value = 0.0;
-            // TODO: Replace with actual hardware reading
-            // value = await _hardware.readSensor(sensor.id); 
-            
-            // Log the reading
-            // await _db.logSensorReading(sensor.id, sensor.sensorType, value);
-          } catch (e) {
-            debugPrint('Error reading/logging sensor ${sensor.name}: $e');
+          if (!sensor.enabled || !sensor.isActive || sensor.hubId != null) continue;
+
+          for (final readingType in sensor.getSupportedReadingTypes()) {
+            try {
+              await _hardware.readSensor(sensor.id, readingType);
+            } catch (e) {
+              debugPrint('Error reading/logging sensor ${sensor.name}: $e');
+            }
           }
         }
       }
@@ -56,18 +56,23 @@ class GuardianContextBuilder {
           currentReadings[type] = latest.value;
         }
 
-        // History
-        final history = await _db.getSensorReadings(
+        // History, newest first with the latest raw reading on top: hourly
+        // buckets from the rollups for windows of a day or more, 5-minute
+        // buckets from the raw readings for shorter ones
+        final series = await _db.getSensorSeries(
           sensor.id,
           type,
           startTime: cutoffEpoch,
+          endTime: DateTime.now().millisecondsSinceEpoch ~/ 1000,
+          points: historyHours >= 24 ? historyHours : historyHours * 12,
         );
+        final history = series.reversed.map((b) => b.toReading()).toList();
+        if (latest != null) history.insert(0, latest);
         sensorHistory[type] = history;
 
         // Statistics
-        if (history.isNotEmpty) {
-          final values = history.map((r) => r.value).toList();
-          statistics[type] = _calculateStatistics(values);
+        if (series.isNotEmpty) {
+          statistics[type] = _calculateSeriesStatistics(series);
         }
       }
     }
@@ -269,6 +274,33 @@ class GuardianContextBuilder {
     );
   }
 
+  /// Statistics over bucketed readings
+  /// Mean is sample-weighted and min/max come from the buckets' extremes;
+  /// spread and trend are taken from the bucket averages.
+  SensorStatistics _calculateSeriesStatistics(List<SensorReadingRollup> series) {
+    final base = _calculateStatistics(series.map((b) => b.avgValue).toList());
+
+    int samples = 0;
+    double sum = 0;
+    double minVal = double.infinity;
+    double maxVal = double.negativeInfinity;
+    for (final b in series) {
+      samples += b.sampleCount;
+      sum += b.avgValue * b.sampleCount;
+      minVal = min(minVal, b.minValue);
+      maxVal = max(maxVal, b.maxValue);
+    }
+
+    return SensorStatistics(
+      mean: samples == 0 ? base.mean : sum / samples,
+      min: minVal,
+      max: maxVal,
+      stdDev: base.stdDev,
+      trend: base.trend,
+      percentInRange: base.percentInRange,
+    );
+  }
+
   SensorStatistics _calculateStatistics(List<double> values) {
     if (values.isEmpty) {
       return SensorStatistics(
@@ -6,7 +6,12 @@ import 'package:flutter/foundation.dart';
 import '../models/io_channel.dart';
 import '../models/camera.dart';
 import '../services/database_helper.dart';
+import '../services/modbus_protocol.dart';
 import '../services/modbus_service.dart';
+import '../services/relay_coalescer.dart';
+import '../services/sensor_hub_service.dart';
+import '../services/sensor_ingest_pipeline.dart';
+import '../services/sensor_worker.dart';
 
 /// HardwareService handles interactions with the physical hardware
 /// including GPIO control, sensor reading, camera operations, and Waveshare relay control.
@@ -23,6 +28,10 @@ class HardwareService {
   // Python script paths
   final String _scriptsDir = '/opt/sprigrig/python';
 
+  // Persistent sensor reader process (started on first reading)
+  late final SensorWorker _sensorWorker =
+      SensorWorker(path.join(_scriptsDir, 'hardware/sensor_worker.py'));
+
   // Cache for IO assignments
   final Map<int, List<IoAssignment>> _zoneIOCache = {};
 
@@ -110,7 +119,7 @@ class HardwareService {
         final relayIndex = mainControl.channelNumber!; // Use 0-7 index directly
         final state = mainControl.invertLogic ? false : true;
 
-        final success = await _setWaveshareRelay(relayIndex, state);
+        final success = await _setWaveshareRelay(mainControl.moduleNumber!, relayIndex, state);
         if (!success) {
           // Don't throw exception, just log warning. 
           // This allows the UI to update even if readback fails.
@@ -166,7 +175,7 @@ class HardwareService {
         final relayIndex = mainControl.channelNumber!; // Use 0-7 index directly
         final state = mainControl.invertLogic ? true : false;
 
-        final success = await _setWaveshareRelay(relayIndex, state);
+        final success = await _setWaveshareRelay(mainControl.moduleNumber!, relayIndex, state);
         if (!success) {
           debugPrint('Warning: No response from Waveshare relay $relayIndex (deactivate), assuming success');
         }
@@ -200,11 +209,19 @@ class HardwareService {
   }
 
   /// Set Waveshare relay state
-  Future<bool> _setWaveshareRelay(int relayIndex, bool state) async {
-    // Relay index is 0-7
-    
+  /// Goes through the coalescer, so relays switched together (zone, scene,
+  /// lighting schedule) share one write per board and no-op changes are
+  /// dropped. Module 100 + N is sensor hub N, not a relay board: its
+  /// outputs are written through SensorHubService instead.
+  Future<bool> _setWaveshareRelay(int moduleNumber, int relayIndex, bool state) async {
+    if (moduleNumber > ModbusProtocol.WAVESHARE_MODULE_BASE) {
+      return SensorHubService()
+          .switchOutput(moduleNumber - ModbusProtocol.WAVESHARE_MODULE_BASE, relayIndex, state);
+    }
+
     try {
-      return await ModbusService().setRelay(relayIndex, state);
+      // Relay index is 0-7; the relay board is at address 1
+      return await RelayCommandCoalescer.instance.setRelay(relayIndex, state);
     } catch (e) {
       debugPrint('Error controlling Waveshare relay: $e');
       return false;
@@ -306,7 +323,7 @@ class HardwareService {
     }
   }
 
-  /// Read a sensor value
+  /// Read a sensor value (calibrated)
   Future<double> readSensor(int sensorId, String readingType) async {
     try {
       // Get sensor details from database
@@ -322,31 +339,18 @@ class HardwareService {
         );
       }
 
-      // Run the sensor reading script
-      final result = await _runPythonScript('hardware/sensor_reader.py', [
-        '--type',
+      // Read through the long-lived worker (no interpreter start per value)
+      final value = await _sensorWorker.read(
         sensor.sensorType,
-        '--address',
-        sensor.address ?? '',
-        '--reading',
+        sensor.address ?? sensor.i2cAddress ?? '',
         readingType,
-      ]);
-
-      // Check result
-      if (result.exitCode != 0) {
-        throw Exception('Failed to read sensor $sensorId: ${result.stderr}');
-      }
-
-      // Parse the result
-      final value = double.tryParse(result.stdout.trim());
-      if (value == null) {
-        throw Exception('Invalid sensor reading: ${result.stdout}');
+      );
+      if (value.isNaN) {
+        throw Exception('Invalid sensor reading from sensor $sensorId');
       }
 
-      // Log the reading in the database
-      await _db.logSensorReading(sensorId, readingType, value);
-
-      return value;
+      // Calibrate and log (deadband filtered, batched)
+      return await SensorIngestPipeline.instance.ingestValue(sensor, readingType, value);
     } catch (e) {
       throw Exception('Error reading sensor $sensorId: $e');
     }
@@ -461,7 +465,7 @@ class HardwareService {
         final relayIndex = mainControl.channelNumber!; // Use 0-7 index directly
         final actualState = mainControl.invertLogic ? !state : state;
 
-        final success = await _setWaveshareRelay(relayIndex, actualState);
+        final success = await _setWaveshareRelay(mainControl.moduleNumber!, relayIndex, actualState);
         if (!success) {
            debugPrint('Warning: No response from Waveshare relay $relayIndex (setControl), assuming success');
         }
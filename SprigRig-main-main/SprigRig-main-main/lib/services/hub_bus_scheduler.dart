@@ -0,0 +1,145 @@
+import 'dart:async';
+import 'dart:collection';
+import 'job_scheduler.dart';
+
+/// Transaction priority on the hub bus, highest first
+enum BusPriority {
+  control,     // Output writes the user or a rule is waiting on
+  poll,        // Periodic hub reads
+  background,  // History backfill, diagnostics, discovery
+}
+
+/// Owns the hub RS485 segment (modbus_hub_port, /dev/ttySC1 by default)
+/// Every hub transaction is submitted here and runs one at a time,
+/// highest priority first, FIFO within a priority. The next transaction
+/// starts as soon as the previous reply is in, so with several hubs
+/// polling at once the line never idles while one hub's results are
+/// processed. Hub polls are registered with their own interval as
+/// [JobScheduler] jobs, with enough slack that all hubs' polls start on
+/// one wakeup.
+class HubBusScheduler {
+  static final HubBusScheduler _instance = HubBusScheduler._internal();
+  factory HubBusScheduler() => _instance;
+  HubBusScheduler._internal();
+
+  final List<Queue<_BusJob>> _queues = [
+    for (int i = 0; i < BusPriority.values.length; i++) Queue<_BusJob>()
+  ];
+  bool _busy = false;
+
+  // Periodic polls by key (hub ID)
+  final Map<int, _PollEntry> _polls = {};
+  final Stopwatch _clock = Stopwatch()..start();
+
+  // Bus utilisation since the last reset
+  int _transactions = 0;
+  int _busyUs = 0;
+  final Stopwatch _window = Stopwatch()..start();
+
+  /// Run [transaction] when the bus is free and nothing more urgent waits
+  Future<T> submit<T>(BusPriority priority, Future<T> Function() transaction) {
+    final job = _BusJob<T>(transaction);
+    _queues[priority.index].add(job);
+    _pump();
+    return job.completer.future;
+  }
+
+  /// Transactions waiting, all priorities
+  int get pending => _queues.fold(0, (sum, q) => sum + q.length);
+
+  /// Fraction of wall time the bus spent in transactions since [resetStats]
+  double get utilisation {
+    final elapsed = _window.elapsedMicroseconds;
+    return elapsed == 0 ? 0 : _busyUs / elapsed;
+  }
+
+  int get transactions => _transactions;
+
+  void resetStats() {
+    _transactions = 0;
+    _busyUs = 0;
+    _window
+      ..reset()
+      ..start();
+  }
+
+  Future<void> _pump() async {
+    if (_busy) return;
+    _busy = true;
+
+    while (true) {
+      _BusJob? job;
+      for (final queue in _queues) {
+        if (queue.isNotEmpty) {
+          job = queue.removeFirst();
+          break;
+        }
+      }
+      if (job == null) break;
+
+      final start = _clock.elapsedMicroseconds;
+      await job.run();
+      _busyUs += _clock.elapsedMicroseconds - start;
+      _transactions++;
+    }
+
+    _busy = false;
+  }
+
+  // --- Periodic polls ---
+
+  /// Run [poll] every [interval] until [cancelPoll]
+  /// A poll still running when it next falls due is not restarted; the
+  /// slot is skipped and counted as an overrun.
+  void schedulePoll(int key, Duration interval, Future<void> Function() poll) {
+    final existing = _polls[key];
+    if (existing != null) {
+      // Rescheduled: keep its phase
+      existing.poll = poll;
+      existing.job.setInterval(interval);
+      return;
+    }
+
+    // First poll straight away; the bus queues them one hub at a time
+    final entry = _PollEntry(poll);
+    entry.job = JobScheduler.instance.every('hub_poll_$key', interval, () => entry.poll(),
+        tolerance: interval ~/ 10, firstRunIn: Duration.zero);
+    _polls[key] = entry;
+  }
+
+  void cancelPoll(int key) {
+    _polls.remove(key)?.job.cancel();
+  }
+
+  void cancelAllPolls() {
+    for (final entry in _polls.values) {
+      entry.job.cancel();
+    }
+    _polls.clear();
+  }
+
+  /// Polls skipped because the previous one was still running
+  int pollOverruns(int key) => _polls[key]?.job.stats.overruns ?? 0;
+}
+
+class _BusJob<T> {
+  final Future<T> Function() transaction;
+  final Completer<T> completer = Completer<T>();
+
+  _BusJob(this.transaction);
+
+  Future<void> run() async {
+    try {
+      completer.complete(await transaction());
+    } catch (e, stack) {
+      completer.completeError(e, stack);
+    }
+  }
+}
+
+class _PollEntry {
+  Future<void> Function() poll;
+  late final ScheduledJob job;
+
+  _PollEntry(this.poll);
+}
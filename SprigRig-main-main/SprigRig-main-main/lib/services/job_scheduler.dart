@@ -0,0 +1,365 @@
+import 'dart:async';
+import 'package:flutter/foundation.dart';
+
+/// Job priority, highest first; orders jobs that fall due together
+enum JobPriority {
+  control,     // Relay/actuator deadlines
+  normal,      // Polls and schedule checks
+  background,  // Persistence, reloads, housekeeping
+}
+
+/// Single timer service for the app's time-driven work
+/// Jobs are kept in a hierarchical timing wheel (10 ms ticks, 64 slots per
+/// level, five levels: ~124 days) and one Dart timer is armed for the
+/// earliest deadline, so the process wakes once per distinct deadline
+/// rather than once per registered timer.
+///
+/// A job with [tolerance] may start up to that much late; its deadline is
+/// rounded up to the coarsest grid (10 ms, 100 ms, 1 s, 10 s, 1 min) that
+/// fits in the tolerance, so slack jobs with similar periods share a
+/// wakeup. Jobs with no tolerance run at their exact deadline.
+///
+/// Periodic jobs keep their cadence (next = previous deadline + interval)
+/// and are skipped, counted as an overrun, while their previous run is
+/// still going. Deadlines run on a monotonic clock; [at] converts a wall
+/// clock time once, when registered.
+///
+/// One instance per isolate.
+class JobScheduler {
+  static JobScheduler? _instance;
+  static JobScheduler get instance => _instance ??= JobScheduler._internal();
+
+  JobScheduler._internal() : _clockUs = _stopwatch();
+
+  /// Scheduler driven by [nowUs] instead of its own stopwatch, for tests
+  @visibleForTesting
+  JobScheduler.withClock(int Function() nowUs) : _clockUs = nowUs;
+
+  static const int TICK_US = 10000;
+  static const int LEVEL_BITS = 6;
+  static const int SLOTS = 1 << LEVEL_BITS;
+  static const int LEVELS = 5;
+
+  // Slack grids, coarsest first
+  static const List<int> _gridsUs = [60000000, 10000000, 1000000, 100000, TICK_US];
+
+  final int Function() _clockUs; // Monotonic
+  final List<List<List<ScheduledJob>>> _wheel = List.generate(
+      LEVELS, (_) => List.generate(SLOTS, (_) => <ScheduledJob>[]));
+  final List<ScheduledJob> _current = []; // Filed at or before the cursor, not yet due
+  final List<ScheduledJob> _overflow = []; // Beyond the top level
+  int _cursor = 0; // Last tick processed
+  int _jobCount = 0;
+
+  Timer? _timer;
+  int _armedUs = -1;
+
+  final Map<String, JobStats> _stats = {};
+  int wakeups = 0;
+
+  int get _nowUs => _clockUs();
+
+  static int Function() _stopwatch() {
+    final clock = Stopwatch()..start();
+    return () => clock.elapsedMicroseconds;
+  }
+
+  /// Run [run] every [interval], first after [firstRunIn] (default: one interval)
+  ScheduledJob every(String name, Duration interval, FutureOr<void> Function() run, {
+    JobPriority priority = JobPriority.normal,
+    Duration tolerance = Duration.zero,
+    Duration? firstRunIn,
+  }) {
+    final job = ScheduledJob._(this, name, run, priority, interval.inMicroseconds,
+        tolerance.inMicroseconds, _statsFor(name));
+    _add(job, _nowUs + (firstRunIn ?? interval).inMicroseconds);
+    return job;
+  }
+
+  /// Run [run] once after [delay]
+  ScheduledJob after(String name, Duration delay, FutureOr<void> Function() run, {
+    JobPriority priority = JobPriority.normal,
+    Duration tolerance = Duration.zero,
+  }) {
+    final job = ScheduledJob._(this, name, run, priority, null,
+        tolerance.inMicroseconds, _statsFor(name));
+    _add(job, _nowUs + (delay.isNegative ? 0 : delay.inMicroseconds));
+    return job;
+  }
+
+  /// Run [run] once at wall clock [time]
+  ScheduledJob at(String name, DateTime time, FutureOr<void> Function() run, {
+    JobPriority priority = JobPriority.normal,
+    Duration tolerance = Duration.zero,
+  }) {
+    return after(name, time.difference(DateTime.now()), run,
+        priority: priority, tolerance: tolerance);
+  }
+
+  /// Remove [job]; a run already in progress finishes
+  void cancel(ScheduledJob job) {
+    if (!job._active) return;
+    job._active = false;
+    _jobCount--;
+    _unfile(job);
+    if (job._dueUs <= _armedUs) _arm();
+  }
+
+  /// Per-name runtime statistics
+  Map<String, JobStats> get stats => Map.unmodifiable(_stats);
+
+  int get jobCount => _jobCount;
+
+  JobStats _statsFor(String name) => _stats.putIfAbsent(name, () => JobStats(name));
+
+  void _add(ScheduledJob job, int deadlineUs) {
+    _jobCount++;
+    _setDeadline(job, deadlineUs);
+    _file(job);
+
+    // Only a new earliest deadline needs the timer moved
+    if (_timer == null || job._dueUs < _armedUs) _arm();
+  }
+
+  void _setDeadline(ScheduledJob job, int deadlineUs) {
+    job._deadlineUs = deadlineUs;
+    job._dueUs = deadlineUs;
+    for (final grid in _gridsUs) {
+      if (grid <= job._toleranceUs) {
+        job._dueUs = (deadlineUs + grid - 1) ~/ grid * grid;
+        break;
+      }
+    }
+  }
+
+  void _file(ScheduledJob job) {
+    final tick = job._dueUs ~/ TICK_US;
+    List<ScheduledJob> bucket = _overflow;
+
+    if (tick <= _cursor) {
+      bucket = _current;
+    } else {
+      // Lowest level whose slot range reaches the tick
+      for (int level = 0; level < LEVELS; level++) {
+        final shift = LEVEL_BITS * level;
+        if ((tick >> shift) - (_cursor >> shift) < SLOTS) {
+          bucket = _wheel[level][(tick >> shift) & (SLOTS - 1)];
+          break;
+        }
+      }
+    }
+
+    bucket.add(job);
+    job._bucket = bucket;
+  }
+
+  void _unfile(ScheduledJob job) {
+    job._bucket?.remove(job);
+    job._bucket = null;
+  }
+
+  /// Move the cursor to [nowUs]: slots passed at each level are emptied
+  /// and their jobs either returned as due or filed again lower down
+  List<ScheduledJob> _advance(int nowUs) {
+    final nowTick = nowUs ~/ TICK_US;
+    final refile = <ScheduledJob>[..._current];
+    _current.clear();
+
+    if (nowTick > _cursor) {
+      for (int level = 0; level < LEVELS; level++) {
+        final shift = LEVEL_BITS * level;
+        final from = (_cursor >> shift) + 1;
+        final to = nowTick >> shift;
+        if (to < from) break; // Higher levels haven't moved either
+
+        // After a long sleep every slot is visited once, not once per lap
+        final last = to - from >= SLOTS ? from + SLOTS - 1 : to;
+        for (int slot = from; slot <= last; slot++) {
+          final bucket = _wheel[level][slot & (SLOTS - 1)];
+          if (bucket.isEmpty) continue;
+          refile.addAll(bucket);
+          bucket.clear();
+        }
+      }
+      refile.addAll(_overflow);
+      _overflow.clear();
+      _cursor = nowTick;
+    }
+
+    final due = <ScheduledJob>[];
+    for (final job in refile) {
+      if (job._dueUs <= nowUs) {
+        job._bucket = null;
+        due.add(job);
+      } else {
+        _file(job);
+      }
+    }
+    return due;
+  }
+
+  /// Earliest due time of any filed job
+  int? _earliestUs() {
+    int? earliest;
+    void consider(List<ScheduledJob> bucket) {
+      for (final job in bucket) {
+        if (earliest == null || job._dueUs < earliest!) earliest = job._dueUs;
+      }
+    }
+
+    consider(_current);
+    // Within a level slots are in time order from the cursor, so the
+    // first occupied one holds that level's earliest job
+    for (int level = 0; level < LEVELS; level++) {
+      final base = _cursor >> (LEVEL_BITS * level);
+      for (int i = 1; i < SLOTS; i++) {
+        final bucket = _wheel[level][(base + i) & (SLOTS - 1)];
+        if (bucket.isNotEmpty) {
+          consider(bucket);
+          break;
+        }
+      }
+    }
+    consider(_overflow);
+    return earliest;
+  }
+
+  void _arm() {
+    final next = _earliestUs();
+    if (next == null) {
+      _timer?.cancel();
+      _timer = null;
+      _armedUs = -1;
+      return;
+    }
+    if (_timer != null && next == _armedUs) return;
+
+    _timer?.cancel();
+    _armedUs = next;
+    // Whole milliseconds, rounded up: an early wakeup would find nothing due
+    final delayUs = next - _nowUs;
+    _timer = Timer(Duration(milliseconds: delayUs > 0 ? (delayUs + 999) ~/ 1000 : 0), _wake);
+  }
+
+  void _wake() {
+    _timer = null;
+    _armedUs = -1;
+    wakeups++;
+
+    final nowUs = _nowUs;
+    final due = _advance(nowUs);
+    due.sort((a, b) {
+      final byPriority = a.priority.index - b.priority.index;
+      return byPriority != 0 ? byPriority : a._deadlineUs.compareTo(b._deadlineUs);
+    });
+    for (final job in due) {
+      if (job._active) _start(job, nowUs); // May be cancelled by an earlier job
+    }
+
+    _arm();
+  }
+
+  void _start(ScheduledJob job, int nowUs) {
+    final stats = job.stats;
+    final lateUs = nowUs - job._deadlineUs;
+
+    final intervalUs = job._intervalUs;
+    if (intervalUs != null) {
+      var next = job._deadlineUs + intervalUs;
+      if (next <= nowUs) {
+        // Fell behind (slow job or suspended process): realign, don't burst
+        next = nowUs + intervalUs;
+      }
+      _setDeadline(job, next);
+      _file(job);
+    } else {
+      job._active = false;
+      _jobCount--;
+    }
+
+    if (job._running) {
+      stats.overruns++;
+      return;
+    }
+
+    job._running = true;
+    if (lateUs > stats.maxLateUs) stats.maxLateUs = lateUs;
+    stats.lastRun = DateTime.now();
+    final startedUs = _nowUs;
+
+    Future.sync(job._run).then((_) {}, onError: (Object e) {
+      stats.errors++;
+      debugPrint('Job ${job.name} failed: $e');
+    }).whenComplete(() {
+      final runUs = _nowUs - startedUs;
+      stats.runs++;
+      stats.totalRunUs += runUs;
+      if (runUs > stats.maxRunUs) stats.maxRunUs = runUs;
+      job._running = false;
+    });
+  }
+}
+
+/// Handle for a job registered with [JobScheduler]
+class ScheduledJob {
+  final JobScheduler _scheduler;
+  final String name;
+  final FutureOr<void> Function() _run;
+  final JobPriority priority;
+  final JobStats stats;
+  int? _intervalUs; // Null for one-shot jobs
+  final int _toleranceUs;
+
+  int _deadlineUs = 0; // Requested
+  int _dueUs = 0;      // Rounded into the tolerance window
+  List<ScheduledJob>? _bucket;
+  bool _active = true;
+  bool _running = false;
+
+  ScheduledJob._(this._scheduler, this.name, this._run, this.priority,
+      this._intervalUs, this._toleranceUs, this.stats);
+
+  bool get isActive => _active;
+  bool get isRunning => _running;
+
+  /// When the job is next due to start
+  DateTime? get nextRun => _active
+      ? DateTime.now().add(Duration(microseconds: _dueUs - _scheduler._nowUs))
+      : null;
+
+  /// Change a periodic job's interval from its next run on
+  void setInterval(Duration interval) {
+    if (_intervalUs != null) _intervalUs = interval.inMicroseconds;
+  }
+
+  void cancel() => _scheduler.cancel(this);
+}
+
+/// Runtime statistics for the jobs sharing one name
+class JobStats {
+  final String name;
+  int runs = 0;
+  int overruns = 0;   // Due while the previous run was still going; skipped
+  int errors = 0;
+  int totalRunUs = 0;
+  int maxRunUs = 0;
+  int maxLateUs = 0;  // Start after the requested deadline
+  DateTime? lastRun;
+
+  JobStats(this.name);
+
+  double get avgRunMs => runs == 0 ? 0 : totalRunUs / runs / 1000.0;
+
+  Map<String, dynamic> toMap() {
+    return {
+      'name': name,
+      'runs': runs,
+      'overruns': overruns,
+      'errors': errors,
+      'avg_run_ms': avgRunMs,
+      'max_run_ms': maxRunUs / 1000.0,
+      'max_late_ms': maxLateUs / 1000.0,
+      'last_run': lastRun?.toIso8601String(),
+    };
+  }
+}
@@ -4,8 +4,18 @@ class ModbusProtocol {
   // Constants
   static const int WAVESHARE_MODULE_BASE = 100;
   static const int MODBUS_READ_COILS = 0x01;
+  static const int MODBUS_READ_DISCRETE_INPUTS = 0x02;
   static const int MODBUS_WRITE_SINGLE_COIL = 0x05;
+  static const int MODBUS_WRITE_SINGLE_REGISTER = 0x06;
   static const int MODBUS_WRITE_MULTIPLE_COILS = 0x0F;
+  static const int MODBUS_READ_HOLDING_REGISTERS = 0x03;
+  static const int MODBUS_READ_INPUT_REGISTERS = 0x04;
+  static const int MODBUS_WRITE_MULTIPLE_REGISTERS = 0x10;
+  static const int MODBUS_READ_WRITE_MULTIPLE_REGISTERS = 0x17;
+  static const int MODBUS_ENCAPSULATED_INTERFACE = 0x2B;
+  static const int MODBUS_MEI_DEVICE_ID = 0x0E;
+  static const int SPRIGRIG_READ_HISTORY = 0x41; // Hub sample history (user-defined FC)
+  static const int HISTORY_REGISTER_COUNT = 21;  // Registers 0-20 per history record
 
   /// Calculate CRC16 for Modbus
   static int calculateCRC(List<int> data) {
@@ -38,6 +48,34 @@ class ModbusProtocol {
     return receivedCRC == calculatedCRC;
   }
 
+  /// Full length of a response frame, from its first 3 bytes
+  /// Returns null if fewer than 3 bytes have arrived or the function has no
+  /// length field (read device identification); the reader then falls back
+  /// to the inter-frame gap.
+  static int? responseFrameLength(List<int> header) {
+    if (header.length < 3) return null;
+
+    final functionCode = header[1];
+    if ((functionCode & 0x80) != 0) return 5; // Addr, Func, Exception, CRC
+
+    switch (functionCode) {
+      case MODBUS_WRITE_SINGLE_COIL:
+      case MODBUS_WRITE_SINGLE_REGISTER:
+      case MODBUS_WRITE_MULTIPLE_COILS:
+      case MODBUS_WRITE_MULTIPLE_REGISTERS:
+        return 8; // Echo of address/quantity
+      case MODBUS_READ_COILS:
+      case MODBUS_READ_DISCRETE_INPUTS:
+      case MODBUS_READ_HOLDING_REGISTERS:
+      case MODBUS_READ_INPUT_REGISTERS:
+      case MODBUS_READ_WRITE_MULTIPLE_REGISTERS:
+      case SPRIGRIG_READ_HISTORY:
+        return 5 + header[2]; // Addr, Func, ByteCount, data, CRC
+      default:
+        return null;
+    }
+  }
+
   /// Generate command to control a single relay (Function 0x05)
   /// [address]: Device address (1-255)
   /// [relayIndex]: Relay index (0-7)
@@ -70,6 +108,20 @@ class ModbusProtocol {
     ]);
   }
 
+  /// Generate command to set all 8 relays to a coil image (Function 0x0F)
+  /// [address]: Device address (1-255)
+  /// [states]: Bit n = relay n
+  static Uint8List writeRelayStates(int address, int states) {
+    return withCRC([
+      address,
+      MODBUS_WRITE_MULTIPLE_COILS,
+      0x00, 0x00,           // Start Address 0
+      0x00, 0x08,           // Quantity 8
+      0x01,                 // Byte Count 1
+      states & 0xFF
+    ]);
+  }
+
   /// Generate command to read relay status (Function 0x01)
   /// [address]: Device address (1-255)
   /// [startRelay]: Start relay index (usually 0)
@@ -100,4 +152,169 @@ class ModbusProtocol {
       (delayUnits >> 8) & 0xFF, delayUnits & 0xFF
     ]);
   }
-}
\ No newline at end of file
+
+  /// Generate command to read holding (0x03) or input (0x04) registers
+  /// [address]: Device address (1-247)
+  /// [startReg]: First register
+  /// [count]: Number of registers (1-125)
+  static Uint8List readRegisters(int address, int functionCode, int startReg, int count) {
+    return withCRC([
+      address,
+      functionCode,
+      (startReg >> 8) & 0xFF, startReg & 0xFF,
+      (count >> 8) & 0xFF, count & 0xFF
+    ]);
+  }
+
+  /// Generate command to write multiple registers (Function 0x10)
+  /// [address]: Device address (1-247)
+  /// [startReg]: First register
+  /// [values]: Register values (1-123)
+  static Uint8List writeMultipleRegisters(int address, int startReg, List<int> values) {
+    return withCRC([
+      address,
+      MODBUS_WRITE_MULTIPLE_REGISTERS,
+      (startReg >> 8) & 0xFF, startReg & 0xFF,
+      (values.length >> 8) & 0xFF, values.length & 0xFF,
+      values.length * 2,
+      ..._registerBytes(values)
+    ]);
+  }
+
+  /// Generate command to write then read registers in one exchange (Function 0x17)
+  /// [address]: Device address (1-247)
+  /// [readStart]/[readCount]: Registers to read back (1-125)
+  /// [writeStart]/[values]: Registers to write first (1-121)
+  static Uint8List readWriteMultipleRegisters(
+      int address, int readStart, int readCount, int writeStart, List<int> values) {
+    return withCRC([
+      address,
+      MODBUS_READ_WRITE_MULTIPLE_REGISTERS,
+      (readStart >> 8) & 0xFF, readStart & 0xFF,
+      (readCount >> 8) & 0xFF, readCount & 0xFF,
+      (writeStart >> 8) & 0xFF, writeStart & 0xFF,
+      (values.length >> 8) & 0xFF, values.length & 0xFF,
+      values.length * 2,
+      ..._registerBytes(values)
+    ]);
+  }
+
+  /// Generate command to read basic device identification (Function 0x2B / MEI 0x0E)
+  /// [address]: Device address (1-247)
+  static Uint8List readDeviceIdentification(int address, {int objectId = 0}) {
+    return withCRC([
+      address,
+      MODBUS_ENCAPSULATED_INTERFACE,
+      MODBUS_MEI_DEVICE_ID,
+      0x01, // Basic device identification (stream access)
+      objectId
+    ]);
+  }
+
+  /// Parse register values from a read response (0x03, 0x04, 0x17)
+  /// Response: ADDR FUNC BYTECOUNT DATA... CRC CRC
+  static List<int> parseRegisters(Uint8List response) {
+    if (response.length < 5) return [];
+    final byteCount = response[2];
+    if (response.length < 5 + byteCount) return [];
+
+    final values = <int>[];
+    for (int i = 0; i + 1 < byteCount; i += 2) {
+      values.add((response[3 + i] << 8) | response[4 + i]);
+    }
+    return values;
+  }
+
+  /// Parse objects from a Read Device Identification response
+  /// Returns object ID -> string (0 = vendor, 1 = product code, 2 = revision)
+  static Map<int, String> parseDeviceIdentification(Uint8List response) {
+    final objects = <int, String>{};
+    if (response.length < 10) return objects;
+
+    final count = response[7];
+    int index = 8;
+    for (int i = 0; i < count; i++) {
+      if (index + 2 > response.length - 2) break;
+      final id = response[index];
+      final length = response[index + 1];
+      index += 2;
+      if (index + length > response.length - 2) break;
+      objects[id] = String.fromCharCodes(response.sublist(index, index + length));
+      index += length;
+    }
+    return objects;
+  }
+
+  /// Generate command to read hub sample history (Function 0x41)
+  /// [address]: Device address (1-247)
+  /// [startSeq]: First record sequence number wanted
+  /// [maxCount]: Records per response (hub caps this at 5)
+  static Uint8List readHistory(int address, int startSeq, {int maxCount = 5}) {
+    return withCRC([
+      address,
+      SPRIGRIG_READ_HISTORY,
+      (startSeq >> 24) & 0xFF, (startSeq >> 16) & 0xFF,
+      (startSeq >> 8) & 0xFF, startSeq & 0xFF,
+      maxCount
+    ]);
+  }
+
+  /// Parse a Read History response
+  /// Response: ADDR 41 BYTECOUNT FIRSTSEQ(4) COUNT NEWESTSEQ(4) NOWTICK(4)
+  ///           COUNT x [TICK(4) REG0..REG20] CRC CRC
+  static HubHistoryPage? parseHistory(Uint8List response) {
+    if (response.length < 18 || response[1] != SPRIGRIG_READ_HISTORY) return null;
+
+    int u32(int i) =>
+        (response[i] << 24) | (response[i + 1] << 16) | (response[i + 2] << 8) | response[i + 3];
+
+    final firstSeq = u32(3);
+    final count = response[7];
+    final newestSeq = u32(8);
+    final nowTick = u32(12);
+
+    const recordSize = 4 + HISTORY_REGISTER_COUNT * 2;
+    if (response.length < 16 + count * recordSize + 2) return null;
+
+    final records = <HubHistoryRecord>[];
+    for (int n = 0; n < count; n++) {
+      final base = 16 + n * recordSize;
+      final registers = <int>[];
+      for (int r = 0; r < HISTORY_REGISTER_COUNT; r++) {
+        registers.add((response[base + 4 + r * 2] << 8) | response[base + 5 + r * 2]);
+      }
+      records.add(HubHistoryRecord(
+        sequence: firstSeq + n,
+        ageMs: (nowTick - u32(base)) & 0xFFFFFFFF,
+        registers: registers,
+      ));
+    }
+
+    return HubHistoryPage(firstSeq: firstSeq, newestSeq: newestSeq, records: records);
+  }
+
+  /// Split 16-bit register values into big-endian bytes
+  static List<int> _registerBytes(List<int> values) {
+    return [
+      for (final value in values) ...[(value >> 8) & 0xFF, value & 0xFF]
+    ];
+  }
+}
+
+/// One hub history snapshot (registers 0-20)
+class HubHistoryRecord {
+  final int sequence;
+  final int ageMs; // Age relative to when the hub sent the response
+  final List<int> registers;
+
+  HubHistoryRecord({required this.sequence, required this.ageMs, required this.registers});
+}
+
+/// One Read History response
+class HubHistoryPage {
+  final int firstSeq;
+  final int newestSeq;
+  final List<HubHistoryRecord> records;
+
+  HubHistoryPage({required this.firstSeq, required this.newestSeq, required this.records});
+}
@@ -1,9 +1,9 @@
 import 'dart:async';
 import 'dart:typed_data';
 import 'package:flutter/foundation.dart';
-import 'package:flutter_libserialport/flutter_libserialport.dart';
 import 'database_helper.dart';
 import 'modbus_protocol.dart';
+import 'modbus_transport.dart';
 
 class ModbusService {
   static final ModbusService _instance = ModbusService._internal();
@@ -13,9 +13,9 @@ class ModbusService {
 
   final DatabaseHelper _db = DatabaseHelper();
   
-  // Serial ports
-  SerialPort? _relayPort;
-  SerialPort? _hubPort;
+  // Serial ports, owned by the transport isolates; name each is open on
+  final ModbusTransport _transport = ModbusTransport.instance;
+  final Map<ModbusLink, String> _openPorts = {};
   
   // Configuration cache
   String? _relayPortName;
@@ -23,8 +23,14 @@ class ModbusService {
   int _relayBaud = 9600;
   int _hubBaud = 9600;
 
+  // Last confirmed coil image per relay board (bit n = relay n)
+  final Map<int, int> _relayImages = {};
+
+  // Learned response timing per slave, keyed by "<port>#<address>"
+  final Map<String, ModbusDeviceTiming> _timings = {};
+  Map<String, ModbusDeviceTiming> get deviceTimings => Map.unmodifiable(_timings);
+
   bool _isInitialized = false;
-  bool _isTransactionInProgress = false;
   
   // Debug Logging
   final _logController = StreamController<String>.broadcast();
@@ -32,6 +38,9 @@ class ModbusService {
   final List<String> _logs = [];
   List<String> get logs => List.unmodifiable(_logs);
 
+  /// Every bus transaction on either port, reported by the transport isolates
+  Stream<ModbusTransaction> get transactionStream => _transport.transactions;
+
   void _log(String message) {
     final timestamp = DateTime.now().toIso8601String().split('T')[1].substring(0, 8);
     final logMsg = '[$timestamp] $message';
@@ -63,10 +72,11 @@ class ModbusService {
 
   Future<void> reloadSettings() async {
     _isInitialized = false;
-    _relayPort?.close();
-    _hubPort?.close();
-    _relayPort = null;
-    _hubPort = null;
+    await _transport.close(ModbusLink.relay);
+    await _transport.close(ModbusLink.hub);
+    _openPorts.clear();
+    _timings.clear();
+    _relayImages.clear();
     await initialize();
     _log('Settings reloaded');
   }
@@ -80,31 +90,16 @@ class ModbusService {
     if (portName == null) return;
 
     // Check if port needs to be opened
-    SerialPort? port = isRelay ? _relayPort : _hubPort;
-    
-    if (port == null || port.name != portName || !port.isOpen) {
-      // Close existing if changed
-      port?.close();
-      
+    final link = isRelay ? ModbusLink.relay : ModbusLink.hub;
+
+    if (_openPorts[link] != portName) {
       try {
-        final newPort = SerialPort(portName);
-        if (newPort.openReadWrite()) {
-          final config = SerialPortConfig();
-          config.baudRate = baudRate;
-          config.bits = 8;
-          config.stopBits = 1;
-          config.parity = SerialPortParity.none;
-          config.setFlowControl(SerialPortFlowControl.none);
-          newPort.config = config;
-          config.dispose(); // Release native resources
-          
-          if (isRelay) {
-            _relayPort = newPort;
-          } else {
-            _hubPort = newPort;
-          }
+        // Reopening closes the previous port first
+        if (await _transport.open(link, portName, baudRate)) {
+          _openPorts[link] = portName;
           _log('Opened serial port: $portName');
         } else {
+          _openPorts.remove(link);
           _log('Failed to open serial port: $portName');
           // On Mac/Dev, this might fail if hardware isn't present.
           // We'll proceed but commands will just log.
@@ -115,15 +110,25 @@ class ModbusService {
     }
   }
 
+  /// Last confirmed relay states of a board (bit n = relay n), null if unknown
+  /// Updated by every successful relay read or write through this service.
+  int? relayImage(int address) => _relayImages[address];
+
   /// Send command to Waveshare Relay Board
-  Future<bool> setRelay(int relayIndex, bool isOn) async {
+  Future<bool> setRelay(int relayIndex, bool isOn, {int address = 1}) async {
     await _ensureConnection(true);
     
     // Default address for Waveshare Relay is usually 1, but could be configured.
-    const address = 1; 
-    
     final command = ModbusProtocol.controlSingleRelay(address, relayIndex, isOn);
-    return _sendCommand(_relayPort, command);
+    final success = await _sendCommand(ModbusLink.relay, command);
+
+    final image = _relayImages[address];
+    if (success && image != null) {
+      _relayImages[address] = isOn ? image | (1 << relayIndex) : image & ~(1 << relayIndex);
+    } else if (!success) {
+      _relayImages.remove(address);
+    }
+    return success;
   }
 
   /// Control all relays at once
@@ -131,7 +136,27 @@ class ModbusService {
     await _ensureConnection(true);
     const address = 1;
     final command = ModbusProtocol.controlAllRelays(address, turnOn);
-    return _sendCommand(_relayPort, command);
+    final success = await _sendCommand(ModbusLink.relay, command);
+    if (success) {
+      _relayImages[address] = turnOn ? 0xFF : 0x00;
+    } else {
+      _relayImages.remove(address);
+    }
+    return success;
+  }
+
+  /// Set all 8 relays of a board in one Write Multiple Coils (Function 0x0F)
+  /// [states]: Bit n = relay n
+  Future<bool> writeRelayStates(int address, int states) async {
+    await _ensureConnection(true);
+    final command = ModbusProtocol.writeRelayStates(address, states);
+    final success = await _sendCommand(ModbusLink.relay, command);
+    if (success) {
+      _relayImages[address] = states & 0xFF;
+    } else {
+      _relayImages.remove(address);
+    }
+    return success;
   }
 
   /// Get all relay states
@@ -139,11 +164,12 @@ class ModbusService {
     await _ensureConnection(true);
     
     final command = ModbusProtocol.readRelayStatus(slaveAddress);
-    final response = await _sendCommandWithResponse(_relayPort, command, expectedLength: 6); // 1 addr + 1 func + 1 byte count + 1 data + 2 CRC
+    final response = await _sendCommandWithResponse(ModbusLink.relay, command, expectedLength: 6); // 1 addr + 1 func + 1 byte count + 1 data + 2 CRC
     
     if (response != null && response.length >= 4) {
       // Byte 3 (index 3) is the data byte containing 8 coils
       final dataByte = response[3];
+      _relayImages[slaveAddress] = dataByte;
       final states = <bool>[];
       for (int i = 0; i < 8; i++) {
         states.add((dataByte & (1 << i)) != 0);
@@ -160,29 +186,91 @@ class ModbusService {
     await _ensureConnection(false); // Use hub port
     
     // Command: 01 03 00 00 00 08 CRC CRC
-    // Function 0x03 is Read Holding Registers
-    final command = ModbusProtocol.withCRC([
-      address,
-      0x03,
-      (startReg >> 8) & 0xFF, startReg & 0xFF,
-      (count >> 8) & 0xFF, count & 0xFF
-    ]);
+    final command = ModbusProtocol.readRegisters(
+        address, ModbusProtocol.MODBUS_READ_HOLDING_REGISTERS, startReg, count);
     
-    final response = await _sendCommandWithResponse(_hubPort, command, expectedLength: 5 + (count * 2));
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 5 + (count * 2));
     
-    if (response != null && response.length > 3) {
-      final byteCount = response[2];
-      final values = <int>[];
-      for (int i = 0; i < byteCount; i += 2) {
-        if (i + 4 < response.length) {
-          values.add((response[3 + i] << 8) | response[4 + i]);
-        }
-      }
-      return values;
+    if (response != null) {
+      return ModbusProtocol.parseRegisters(response);
     }
     return [];
   }
 
+  /// Read input registers (Function 0x04) - hub measurement block
+  Future<List<int>> readInputRegisters(int address, int startReg, int count) async {
+    await _ensureConnection(false);
+
+    final command = ModbusProtocol.readRegisters(
+        address, ModbusProtocol.MODBUS_READ_INPUT_REGISTERS, startReg, count);
+
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 5 + (count * 2));
+
+    if (response != null) {
+      return ModbusProtocol.parseRegisters(response);
+    }
+    return [];
+  }
+
+  /// Write multiple registers (Function 0x10) - e.g. both analog outputs at once
+  Future<bool> writeMultipleRegisters(int address, int startReg, List<int> values) async {
+    await _ensureConnection(false);
+
+    final command = ModbusProtocol.writeMultipleRegisters(address, startReg, values);
+
+    // Response: Addr, Func, Start Hi, Start Lo, Qty Hi, Qty Lo, CRC, CRC
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 8);
+    return response != null && response.length >= 8 && response[1] == command[1];
+  }
+
+  /// Write then read registers in a single exchange (Function 0x17)
+  /// Returns the registers read back after the write, or empty on failure.
+  Future<List<int>> readWriteMultipleRegisters(
+      int address, int readStart, int readCount, int writeStart, List<int> values) async {
+    await _ensureConnection(false);
+
+    final command = ModbusProtocol.readWriteMultipleRegisters(
+        address, readStart, readCount, writeStart, values);
+
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 5 + (readCount * 2));
+
+    if (response != null && response[1] == command[1]) {
+      return ModbusProtocol.parseRegisters(response);
+    }
+    return [];
+  }
+
+  /// Read basic device identification (Function 0x2B / MEI 0x0E)
+  /// Returns object ID -> string (0 = vendor, 1 = product code, 2 = revision)
+  Future<Map<int, String>> readDeviceIdentification(int address) async {
+    await _ensureConnection(false);
+
+    final command = ModbusProtocol.readDeviceIdentification(address);
+
+    // Variable length; the hub's basic objects fit well within 128 bytes
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 128);
+
+    if (response != null && response[1] == command[1]) {
+      return ModbusProtocol.parseDeviceIdentification(response);
+    }
+    return {};
+  }
+
+  /// Read hub sample history (Function 0x41), starting at [startSeq]
+  Future<HubHistoryPage?> readHistory(int address, int startSeq, {int maxCount = 5}) async {
+    await _ensureConnection(false);
+
+    final command = ModbusProtocol.readHistory(address, startSeq, maxCount: maxCount);
+
+    // Header (16) + up to 5 records of 46 bytes + CRC
+    final response = await _sendCommandWithResponse(ModbusLink.hub, command, expectedLength: 16 + maxCount * 46 + 2);
+
+    if (response != null) {
+      return ModbusProtocol.parseHistory(response);
+    }
+    return null;
+  }
+
   /// Scan for hubs on the bus
   Future<List<int>> scanForHubs() async {
     await _ensureConnection(false);
@@ -203,7 +291,7 @@ class ModbusService {
   Future<String> checkHubStatus(int address) async {
     await _ensureConnection(false);
     
-    if (_hubPort == null || !_hubPort!.isOpen) {
+    if (!_openPorts.containsKey(ModbusLink.hub)) {
       return 'Mock';
     }
 
@@ -220,14 +308,21 @@ class ModbusService {
     return 'Disconnected';
   }
 
+  /// Learned timing for a slave on the hub (or relay) port, if it has been polled
+  ModbusDeviceTiming? getTiming(int address, {bool relay = false}) {
+    final portName = relay ? _relayPortName : _hubPortName;
+    return _timings['$portName#$address'];
+  }
+
   /// Send raw command to a port
-  Future<bool> _sendCommand(SerialPort? port, Uint8List command) async {
-    final response = await _sendCommandWithResponse(port, command);
+  Future<bool> _sendCommand(ModbusLink link, Uint8List command) async {
+    final response = await _sendCommandWithResponse(link, command);
     return response != null;
   }
 
-  Future<Uint8List?> _sendCommandWithResponse(SerialPort? port, Uint8List command, {int expectedLength = 8}) async {
-    if (port == null || !port.isOpen) {
+  Future<Uint8List?> _sendCommandWithResponse(ModbusLink link, Uint8List command, {int expectedLength = 8}) async {
+    final portName = _openPorts[link];
+    if (portName == null) {
       _log('Warning: Port not open. Using Mock Mode.');
       _log('Mock Send: ${command.map((b) => b.toRadixString(16).padLeft(2, '0')).join(' ')}');
       
@@ -244,10 +339,9 @@ class ModbusService {
         // Echo command as response
         return command;
       } else if (functionCode == ModbusProtocol.MODBUS_WRITE_MULTIPLE_COILS) {
-        // Update all mock states
-        final isOn = command[7] == 0xFF; // Simplified for all on/off
+        // Update all mock states from the coil byte
         for (int i = 0; i < _mockRelayStates.length; i++) {
-          _mockRelayStates[i] = isOn;
+          _mockRelayStates[i] = (command[7] & (1 << i)) != 0;
         }
         // Response: Addr, Func, Start Hi, Start Lo, Qty Hi, Qty Lo, CRC, CRC
         return ModbusProtocol.withCRC(command.sublist(0, 6));
@@ -266,34 +360,49 @@ class ModbusService {
       return Uint8List.fromList([command[0], command[1], 0, 0, 0, 0, 0, 0]); // Generic mock
     }
 
+    final address = command[0];
+    final timing = _timings.putIfAbsent('$portName#$address', () => ModbusDeviceTiming());
+    final requestMs = _wireMs(link, command.length);
+    final replyMs = _wireMs(link, expectedLength);
+
     try {
-      port.flush(SerialPortBuffer.input);
-      
-      final written = port.write(command);
-      if (written != command.length) {
-        _log('Write failed: $written/${command.length}');
-        return null;
-      }
-      
       _log('TX: ${command.map((b) => b.toRadixString(16).padLeft(2, '0')).join(' ')}');
-      
-      // Match Python timing - just wait, then read
-      await Future.delayed(const Duration(milliseconds: 100));
-      
-      final response = port.read(expectedLength);
-      
-      if (response.isEmpty) {
-        _log('No response');
-        return null;
+
+      // Completes on the frame length from the reply header, the inter-frame
+      // gap (functions without a length field), or the learned timeout
+      final reply = await _transport.transact(
+        link,
+        command,
+        maxLength: expectedLength,
+        timeout: Duration(milliseconds: (requestMs + replyMs).ceil() + timing.timeoutMs),
+      );
+
+      switch (reply.status) {
+        case ModbusTransactionStatus.ok:
+          break;
+        case ModbusTransactionStatus.timeout:
+        case ModbusTransactionStatus.truncated:
+          timing.recordTimeout();
+          _log('No response (timeout ${timing.timeoutMs}ms)');
+          return null;
+        case ModbusTransactionStatus.portError:
+          _log('Error: ${reply.error}');
+          return null;
       }
-      
-      _log('RX: ${response.map((b) => b.toRadixString(16).padLeft(2, '0')).join(' ')}');
-      
-      if (!ModbusProtocol.verifyCRC(response)) {
-        _log('CRC error');
+
+      final response = reply.response!;
+      final turnaroundMs = (reply.firstByteMs - requestMs).clamp(0, double.infinity).toDouble();
+
+      _log('RX (${reply.elapsedMs.toStringAsFixed(1)}ms): '
+          '${response.map((b) => b.toRadixString(16).padLeft(2, '0')).join(' ')}');
+
+      if (!ModbusProtocol.verifyCRC(response) || response[0] != address) {
+        timing.recordError();
+        _log(response[0] != address ? 'Reply from wrong address ${response[0]}' : 'CRC error');
         return null;
       }
-      
+
+      timing.recordTurnaround(turnaroundMs);
       return response;
     } catch (e) {
       _log('Error: $e');
@@ -301,9 +410,80 @@ class ModbusService {
     }
   }
 
-  /// Close ports
+  /// Time [bytes] characters occupy the wire (8N1)
+  double _wireMs(ModbusLink link, int bytes) =>
+      bytes * 10 * 1000 / (link == ModbusLink.relay ? _relayBaud : _hubBaud);
+
+  /// Close ports and stop the transport isolates
   void dispose() {
-    _relayPort?.close();
-    _hubPort?.close();
+    _transport.dispose();
+    _openPorts.clear();
+  }
+}
+
+/// Response timing learned for one slave
+/// Turnaround is request end to first reply byte. The timeout adapts like
+/// a TCP retransmit timer (mean + 4 deviations) and doubles after each
+/// miss, so fast hubs are polled tightly and slow ones still get answered.
+class ModbusDeviceTiming {
+  static const int INITIAL_TIMEOUT_MS = 500;  // Until the first reply
+  static const int MIN_TIMEOUT_MS = 20;       // Floor: host scheduling, USB latency
+  static const int MAX_TIMEOUT_MS = 2000;
+
+  int transactions = 0;
+  int timeouts = 0;
+  int errors = 0;
+  double lastTurnaroundMs = 0;
+  double maxTurnaroundMs = 0;
+
+  double? _smoothedMs;
+  double _deviationMs = 0;
+  int _backoff = 0;
+
+  /// Mean turnaround (smoothed), 0 until the first reply
+  double get avgTurnaroundMs => _smoothedMs ?? 0;
+
+  /// Allowance for turnaround on top of the request and reply wire time
+  int get timeoutMs {
+    final base = _smoothedMs == null
+        ? INITIAL_TIMEOUT_MS
+        : (_smoothedMs! + 4 * _deviationMs).ceil().clamp(MIN_TIMEOUT_MS, MAX_TIMEOUT_MS);
+    return (base << _backoff).clamp(MIN_TIMEOUT_MS, MAX_TIMEOUT_MS);
+  }
+
+  void recordTurnaround(double ms) {
+    transactions++;
+    lastTurnaroundMs = ms;
+    if (ms > maxTurnaroundMs) maxTurnaroundMs = ms;
+
+    if (_smoothedMs == null) {
+      _smoothedMs = ms;
+      _deviationMs = ms / 2;
+    } else {
+      _deviationMs = 0.75 * _deviationMs + 0.25 * (ms - _smoothedMs!).abs();
+      _smoothedMs = 0.875 * _smoothedMs! + 0.125 * ms;
+    }
+    _backoff = 0;
   }
+
+  void recordTimeout() {
+    transactions++;
+    timeouts++;
+    if (_backoff < 4) _backoff++;
+  }
+
+  void recordError() {
+    transactions++;
+    errors++;
+  }
+
+  Map<String, dynamic> toMap() => {
+        'transactions': transactions,
+        'timeouts': timeouts,
+        'errors': errors,
+        'avg_turnaround_ms': avgTurnaroundMs,
+        'last_turnaround_ms': lastTurnaroundMs,
+        'max_turnaround_ms': maxTurnaroundMs,
+        'timeout_ms': timeoutMs,
+      };
 }
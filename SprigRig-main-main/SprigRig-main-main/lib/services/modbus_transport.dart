@@ -0,0 +1,417 @@
+import 'dart:async';
+import 'dart:isolate';
+import 'dart:typed_data';
+import 'package:flutter_libserialport/flutter_libserialport.dart';
+import 'modbus_protocol.dart';
+
+/// The two RS485 channels of the HAT
+enum ModbusLink { relay, hub }
+
+/// Outcome of one request/reply exchange
+enum ModbusTransactionStatus { ok, timeout, truncated, portError }
+
+/// One completed exchange, as reported by a link's transport isolate
+class ModbusTransaction {
+  final ModbusLink link;
+  final Uint8List request;
+  final Uint8List? response;
+  final ModbusTransactionStatus status;
+  final double firstByteMs;   // Write start to first reply byte
+  final double elapsedMs;     // Write start to frame complete
+  final String? error;
+
+  ModbusTransaction({
+    required this.link,
+    required this.request,
+    this.response,
+    required this.status,
+    this.firstByteMs = 0,
+    this.elapsedMs = 0,
+    this.error,
+  });
+}
+
+/// Modbus serial transport in long-lived background isolates
+/// Each link has its own isolate that owns its port and does blocking
+/// reads, so frame timing does not depend on the UI isolate's event loop
+/// and a slow frame build cannot delay a reply. The two links run
+/// independently: a relay write never waits behind a hub read. The UI side
+/// sends commands and gets each transaction back as a message;
+/// [transactions] streams all of them. Exchanges on one link run one at a
+/// time.
+///
+/// If a link's isolate dies, its outstanding requests fail and the next
+/// request starts a new one, reopening the port it had open.
+class ModbusTransport {
+  static ModbusTransport? _instance;
+  static ModbusTransport get instance => _instance ??= ModbusTransport._internal();
+
+  ModbusTransport._internal();
+
+  final StreamController<ModbusTransaction> _transactionController =
+      StreamController<ModbusTransaction>.broadcast();
+
+  late final Map<ModbusLink, _LinkWorker> _workers = {
+    for (final link in ModbusLink.values) link: _LinkWorker(link, _transactionController)
+  };
+
+  /// Every transaction on either port, as it completes
+  Stream<ModbusTransaction> get transactions => _transactionController.stream;
+
+  /// Start both link isolates (idempotent)
+  Future<void> start() => Future.wait([for (final worker in _workers.values) worker.start()]);
+
+  /// Open and configure a port (8N1, no flow control)
+  /// Returns false if it could not be opened.
+  Future<bool> open(ModbusLink link, String portName, int baudRate) async {
+    final result = await _workers[link]!.request(_TransportCommand.open(link, portName, baudRate));
+    return result == true;
+  }
+
+  /// Close a port (no-op if not open)
+  Future<void> close(ModbusLink link) => _workers[link]!.close();
+
+  /// Send [request] and collect one reply frame
+  /// The reply ends at the length given in its header, after an
+  /// inter-frame gap for functions without a length field, at [maxLength],
+  /// or at [timeout].
+  Future<ModbusTransaction> transact(ModbusLink link, Uint8List request,
+      {required int maxLength, required Duration timeout}) async {
+    final result = await _workers[link]!.request(
+        _TransportCommand.transact(link, request, maxLength, timeout.inMicroseconds));
+    return result as ModbusTransaction;
+  }
+
+  /// Stop the isolates and close both ports
+  void dispose() {
+    for (final worker in _workers.values) {
+      worker.stop(StateError('Modbus transport stopped'));
+    }
+  }
+
+  /// Isolate entry point
+  static void _isolateEntry(SendPort sendPort) {
+    // Set up communication
+    final receivePort = ReceivePort();
+    sendPort.send(receivePort.sendPort);
+
+    final transport = _IsolateTransport();
+
+    // Commands are handled to completion in arrival order
+    receivePort.listen((message) {
+      if (message is _TransportCommand) {
+        sendPort.send(_TransportEvent(message.id, transport.handleCommand(message)));
+      }
+    });
+  }
+}
+
+/// One link's isolate, started on first use and again after it dies
+class _LinkWorker {
+  final ModbusLink link;
+  final StreamController<ModbusTransaction> _transactions;
+
+  Isolate? _isolate;
+  ReceivePort? _receivePort;
+  SendPort? _sendPort;
+  Completer<void>? _ready;
+
+  int _nextId = 1;
+  final Map<int, Completer<dynamic>> _pending = {};
+
+  // Last successful open, replayed in a new isolate after a crash
+  _TransportCommand? _openCommand;
+  bool _reopen = false;
+
+  _LinkWorker(this.link, this._transactions);
+
+  Future<void> start() {
+    if (_ready != null) return _ready!.future;
+    final ready = _ready = Completer<void>();
+    final receivePort = _receivePort = ReceivePort();
+
+    receivePort.listen((message) {
+      if (message is SendPort) {
+        _sendPort = message;
+        ready.complete();
+      } else if (message is _TransportEvent) {
+        _handleEvent(message);
+      } else {
+        // onError sends [error, stack]; onExit sends null
+        _died(message is List ? message.first : 'exited');
+      }
+    });
+
+    Isolate.spawn(
+      ModbusTransport._isolateEntry,
+      receivePort.sendPort,
+      onError: receivePort.sendPort,
+      onExit: receivePort.sendPort,
+      debugName: 'modbus_${link.name}',
+    ).then((isolate) {
+      if (_receivePort == receivePort) {
+        _isolate = isolate;
+      } else {
+        isolate.kill(priority: Isolate.immediate); // Stopped while spawning
+      }
+    }, onError: (e) {
+      if (_receivePort == receivePort) stop(e);
+    });
+
+    return ready.future;
+  }
+
+  Future<dynamic> request(_TransportCommand command) async {
+    await start();
+
+    if (_reopen && command.type == _TransportCommandType.transact) {
+      // The port went with the old isolate
+      _reopen = false;
+      await _send(_openCommand!);
+    }
+
+    final result = await _send(command);
+    if (command.type == _TransportCommandType.open) {
+      _openCommand = result == true ? command : null;
+      _reopen = false;
+    }
+    return result;
+  }
+
+  Future<void> close() async {
+    _openCommand = null;
+    _reopen = false;
+    if (_sendPort == null) return;
+    await _send(_TransportCommand.close(link));
+  }
+
+  /// Kill the isolate and fail everything waiting on it
+  void stop(Object error) {
+    _isolate?.kill(priority: Isolate.immediate);
+    _isolate = null;
+    _receivePort?.close();
+    _receivePort = null;
+    _sendPort = null;
+
+    final ready = _ready;
+    _ready = null;
+    if (ready != null && !ready.isCompleted) ready.completeError(error);
+
+    final pending = _pending.values.toList();
+    _pending.clear();
+    for (final completer in pending) {
+      completer.completeError(error);
+    }
+  }
+
+  void _died(Object reason) {
+    stop(StateError('Modbus ${link.name} transport isolate died: $reason'));
+    _reopen = _openCommand != null;
+  }
+
+  Future<dynamic> _send(_TransportCommand command) {
+    final sendPort = _sendPort;
+    if (sendPort == null) {
+      return Future.error(StateError('Modbus ${link.name} transport not running'));
+    }
+
+    final id = _nextId++;
+    final completer = Completer<dynamic>();
+    _pending[id] = completer;
+    sendPort.send(command.withId(id));
+    return completer.future;
+  }
+
+  void _handleEvent(_TransportEvent event) {
+    final result = event.result;
+    if (result is ModbusTransaction) _transactions.add(result);
+    _pending.remove(event.id)?.complete(result);
+  }
+}
+
+enum _TransportCommandType { open, close, transact }
+
+class _TransportCommand {
+  final int id;
+  final _TransportCommandType type;
+  final ModbusLink link;
+  final Map<String, dynamic> data;
+
+  _TransportCommand({this.id = 0, required this.type, required this.link, this.data = const {}});
+
+  factory _TransportCommand.open(ModbusLink link, String portName, int baudRate) {
+    return _TransportCommand(
+      type: _TransportCommandType.open,
+      link: link,
+      data: {'port': portName, 'baud': baudRate},
+    );
+  }
+
+  factory _TransportCommand.close(ModbusLink link) {
+    return _TransportCommand(type: _TransportCommandType.close, link: link);
+  }
+
+  factory _TransportCommand.transact(
+      ModbusLink link, Uint8List request, int maxLength, int timeoutUs) {
+    return _TransportCommand(
+      type: _TransportCommandType.transact,
+      link: link,
+      data: {'request': request, 'max_length': maxLength, 'timeout_us': timeoutUs},
+    );
+  }
+
+  _TransportCommand withId(int id) =>
+      _TransportCommand(id: id, type: type, link: link, data: data);
+}
+
+class _TransportEvent {
+  final int id;
+  final dynamic result;  // bool for open/close, ModbusTransaction for transact
+
+  _TransportEvent(this.id, this.result);
+}
+
+/// Port owner inside a link's transport isolate
+class _IsolateTransport {
+  static const int GAP_SLACK_MS = 5;  // SC16IS752 / USB adapters deliver in chunks
+
+  final Map<ModbusLink, SerialPort> _ports = {};
+  final Map<ModbusLink, int> _bauds = {};
+  final Stopwatch _clock = Stopwatch();
+
+  dynamic handleCommand(_TransportCommand command) {
+    switch (command.type) {
+      case _TransportCommandType.open:
+        return _open(command.link, command.data['port'] as String, command.data['baud'] as int);
+      case _TransportCommandType.close:
+        _close(command.link);
+        return true;
+      case _TransportCommandType.transact:
+        return _transact(
+          command.link,
+          command.data['request'] as Uint8List,
+          command.data['max_length'] as int,
+          command.data['timeout_us'] as int,
+        );
+    }
+  }
+
+  bool _open(ModbusLink link, String portName, int baudRate) {
+    _close(link);
+
+    try {
+      final port = SerialPort(portName);
+      if (!port.openReadWrite()) {
+        port.dispose();
+        return false;
+      }
+
+      final config = SerialPortConfig();
+      config.baudRate = baudRate;
+      config.bits = 8;
+      config.stopBits = 1;
+      config.parity = SerialPortParity.none;
+      config.setFlowControl(SerialPortFlowControl.none);
+      port.config = config;
+      config.dispose(); // Release native resources
+
+      _ports[link] = port;
+      _bauds[link] = baudRate;
+      return true;
+    } catch (_) {
+      return false;
+    }
+  }
+
+  void _close(ModbusLink link) {
+    final port = _ports.remove(link);
+    if (port == null) return;
+    port.close();
+    port.dispose();
+  }
+
+  ModbusTransaction _transact(ModbusLink link, Uint8List request, int maxLength, int timeoutUs) {
+    final port = _ports[link];
+    if (port == null || !port.isOpen) {
+      return ModbusTransaction(
+          link: link, request: request, status: ModbusTransactionStatus.portError, error: 'Port not open');
+    }
+
+    // Inter-frame gap (t3.5 at 8N1) that ends a reply without a length field
+    final gapMs = (35000 / _bauds[link]!).ceil() + GAP_SLACK_MS;
+    final deadlineMs = timeoutUs / 1000.0;
+    final rx = BytesBuilder(copy: false);
+    double firstByteMs = 0;
+
+    // Blocking read of up to [count] bytes until [limitMs] from write start
+    Uint8List readUntil(int count, double limitMs) {
+      final remaining = (limitMs - _clock.elapsedMicroseconds / 1000.0).ceil();
+      if (remaining <= 0 || count <= 0) return Uint8List(0);
+      return port.read(count, timeout: remaining);
+    }
+
+    try {
+      port.flush(SerialPortBuffer.input);
+
+      _clock
+        ..reset()
+        ..start();
+      final written = port.write(request, timeout: deadlineMs.ceil());
+      if (written != request.length) {
+        return ModbusTransaction(
+            link: link, request: request, status: ModbusTransactionStatus.portError,
+            error: 'Write failed: $written/${request.length}');
+      }
+
+      // First byte, then the header that carries the length
+      final first = readUntil(1, deadlineMs);
+      if (first.isNotEmpty) {
+        firstByteMs = _clock.elapsedMicroseconds / 1000.0;
+        rx.add(first);
+      }
+      while (rx.length > 0 && rx.length < 3) {
+        final chunk = readUntil(3 - rx.length, deadlineMs);
+        if (chunk.isEmpty) break;
+        rx.add(chunk);
+      }
+
+      final expected = rx.length >= 3 ? ModbusProtocol.responseFrameLength(rx.toBytes()) : null;
+      if (expected != null) {
+        while (rx.length < expected) {
+          final chunk = readUntil(expected - rx.length, deadlineMs);
+          if (chunk.isEmpty) break;
+          rx.add(chunk);
+        }
+      } else if (rx.length >= 3) {
+        // No length field: read until the line goes quiet
+        while (rx.length < maxLength) {
+          final nowMs = _clock.elapsedMicroseconds / 1000.0;
+          final limit = nowMs + gapMs < deadlineMs ? nowMs + gapMs : deadlineMs;
+          final chunk = readUntil(maxLength - rx.length, limit);
+          if (chunk.isEmpty) break;
+          rx.add(chunk);
+        }
+      }
+
+      _clock.stop();
+      final elapsedMs = _clock.elapsedMicroseconds / 1000.0;
+      final bytes = rx.toBytes();
+
+      if (bytes.isEmpty) {
+        return ModbusTransaction(
+            link: link, request: request, status: ModbusTransactionStatus.timeout, elapsedMs: elapsedMs);
+      }
+      if (expected != null && bytes.length < expected) {
+        return ModbusTransaction(
+            link: link, request: request, response: bytes, status: ModbusTransactionStatus.truncated,
+            firstByteMs: firstByteMs, elapsedMs: elapsedMs);
+      }
+      return ModbusTransaction(
+          link: link, request: request, response: bytes, status: ModbusTransactionStatus.ok,
+          firstByteMs: firstByteMs, elapsedMs: elapsedMs);
+    } catch (e) {
+      return ModbusTransaction(
+          link: link, request: request, status: ModbusTransactionStatus.portError, error: e.toString());
+    }
+  }
+}
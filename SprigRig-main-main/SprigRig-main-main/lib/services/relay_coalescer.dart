@@ -0,0 +1,128 @@
+import 'dart:async';
+import 'package:flutter/foundation.dart';
+import 'modbus_service.dart';
+
+/// Merges relay changes into one write per board
+/// Changes requested within [window] of the first are combined with the
+/// board's known coil image and sent as a single Write Multiple Coils
+/// (0x0F), or a Write Single Coil (0x05) when only one relay differs. A
+/// change that matches the known state is answered without touching the
+/// bus. A scene change (lights + fans + pumps) therefore costs one round
+/// trip per board instead of one per relay, as long as the caller issues
+/// the changes together rather than awaiting each one.
+class RelayCommandCoalescer {
+  static RelayCommandCoalescer? _instance;
+  static RelayCommandCoalescer get instance =>
+      _instance ??= RelayCommandCoalescer._internal();
+
+  RelayCommandCoalescer._internal();
+
+  static const Duration window = Duration(milliseconds: 20);
+
+  final ModbusService _modbus = ModbusService();
+  final Map<int, _PendingBoard> _pending = {}; // Board address -> queued changes
+
+  // Counters for the relay test screen / logs
+  int requested = 0;
+  int deduplicated = 0;
+  int writes = 0;
+
+  /// Request relay [relayIndex] (0-7) on board [address] to [state]
+  /// Completes once the merged write for its window has been answered.
+  Future<bool> setRelay(int relayIndex, bool state, {int address = 1}) {
+    requested++;
+    final bit = 1 << relayIndex;
+
+    final board = _pending[address];
+    final image = _modbus.relayImage(address);
+
+    // Already in that state and nothing queued that would change it
+    if (image != null && (board == null || board.mask & bit == 0) &&
+        ((image & bit) != 0) == state) {
+      deduplicated++;
+      return Future.value(true);
+    }
+
+    final pending = board ?? (_pending[address] = _PendingBoard());
+    pending.mask |= bit;
+    pending.values = state ? pending.values | bit : pending.values & ~bit;
+    pending.timer ??= Timer(window, () => _flush(address));
+
+    final completer = Completer<bool>();
+    pending.waiters.add(completer);
+    return completer.future;
+  }
+
+  /// Send everything queued now instead of waiting out the window
+  Future<void> flushAll() async {
+    await Future.wait(_pending.keys.toList().map(_flush));
+  }
+
+  Future<void> _flush(int address) async {
+    final board = _pending.remove(address);
+    if (board == null) return;
+    board.timer?.cancel();
+
+    bool success;
+    try {
+      success = await _write(address, board.mask, board.values);
+    } catch (e) {
+      debugPrint('Error writing relay board $address: $e');
+      success = false;
+    }
+
+    for (final waiter in board.waiters) {
+      waiter.complete(success);
+    }
+  }
+
+  /// Apply [mask]/[values] to the board's coil image in one transaction
+  Future<bool> _write(int address, int mask, int values) async {
+    // The image is needed to leave the other relays alone; read it once
+    var image = _modbus.relayImage(address);
+    if (image == null && _bitCount(mask) > 1) {
+      await _modbus.getAllRelayStates(address);
+      image = _modbus.relayImage(address);
+    }
+
+    if (image == null) {
+      // Board state unknown: fall back to one write per relay
+      bool success = true;
+      for (int i = 0; i < 8; i++) {
+        if (mask & (1 << i) == 0) continue;
+        writes++;
+        success = await _modbus.setRelay(i, values & (1 << i) != 0, address: address) && success;
+      }
+      return success;
+    }
+
+    final target = (image & ~mask) | (values & mask);
+    final changed = image ^ target;
+    if (changed == 0) {
+      deduplicated++;
+      return true;
+    }
+
+    writes++;
+    if (_bitCount(changed) == 1) {
+      final relayIndex = changed.bitLength - 1;
+      return _modbus.setRelay(relayIndex, target & changed != 0, address: address);
+    }
+    return _modbus.writeRelayStates(address, target);
+  }
+
+  static int _bitCount(int value) {
+    int count = 0;
+    for (int v = value; v != 0; v &= v - 1) {
+      count++;
+    }
+    return count;
+  }
+}
+
+class _PendingBoard {
+  int mask = 0;    // Relays with a requested state
+  int values = 0;  // Requested states for the bits in mask
+  Timer? timer;
+  final List<Completer<bool>> waiters = [];
+}
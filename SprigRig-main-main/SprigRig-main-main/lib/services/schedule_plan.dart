@@ -0,0 +1,218 @@
+import 'package:flutter/material.dart';
+
+class ScheduledEvent {
+  final DateTime time;
+  final int relayIndex;
+  final bool turnOn;
+  final String scheduleName;
+
+  ScheduledEvent({
+    required this.time,
+    required this.relayIndex,
+    required this.turnOn,
+    required this.scheduleName,
+  });
+}
+
+/// One recurring on-window for a relay, as configured
+/// [days] is [Mon..Sun]; a window may run past midnight into the next day.
+class ScheduleWindow {
+  final int relayIndex;
+  final TimeOfDay start;
+  final Duration duration;
+  final List<bool> days;
+  final String name;
+
+  const ScheduleWindow({
+    required this.relayIndex,
+    required this.start,
+    required this.duration,
+    required this.days,
+    required this.name,
+  });
+
+  /// Window from a start/end time of day; equal times mean all day
+  factory ScheduleWindow.between({
+    required int relayIndex,
+    required TimeOfDay start,
+    required TimeOfDay end,
+    required List<bool> days,
+    required String name,
+  }) {
+    var minutes = (end.hour * 60 + end.minute) - (start.hour * 60 + start.minute);
+    if (minutes <= 0) minutes += 24 * 60;
+    return ScheduleWindow(
+      relayIndex: relayIndex,
+      start: start,
+      duration: Duration(minutes: minutes),
+      days: days,
+      name: name,
+    );
+  }
+}
+
+/// Relay on/off edges for a fixed span, expanded from [ScheduleWindow]s
+/// Overlapping windows on a relay are merged (a relay is on while any of
+/// its windows is), so every edge is a real state change. Immutable once
+/// built: "what should relay N be at t" and "next event after t" are
+/// binary searches, with no database access.
+class SchedulePlan {
+  static const Duration DEFAULT_HORIZON = Duration(hours: 48);
+
+  // Windows are expanded from this far back so ones already running at
+  // [start] count (covers durations up to this long)
+  static const Duration LOOKBACK = Duration(days: 2);
+
+  final DateTime start;
+  final DateTime end;
+  final Map<int, _RelayTimeline> _timelines;
+  final List<ScheduledEvent> _events; // Every relay's edges in (start, end], by time
+
+  SchedulePlan._(this.start, this.end, this._timelines, this._events);
+
+  /// Expand [windows] over [from, from + horizon]
+  /// [relays] lists relays to manage even if no window turns them on.
+  factory SchedulePlan.compile(
+    Iterable<ScheduleWindow> windows, {
+    Iterable<int> relays = const [],
+    required DateTime from,
+    Duration horizon = DEFAULT_HORIZON,
+  }) {
+    final to = from.add(horizon);
+    final fromDay = DateTime(from.year, from.month, from.day).subtract(LOOKBACK);
+
+    // Concrete [on, off) intervals per relay
+    final intervals = <int, List<_Interval>>{for (final relay in relays) relay: []};
+    for (final window in windows) {
+      if (window.duration <= Duration.zero) continue;
+      final list = intervals.putIfAbsent(window.relayIndex, () => []);
+
+      for (var day = fromDay; !day.isAfter(to); day = DateTime(day.year, day.month, day.day + 1)) {
+        if (!window.days[day.weekday - 1]) continue;
+        final on = DateTime(day.year, day.month, day.day, window.start.hour, window.start.minute);
+        final off = on.add(window.duration);
+        if (off.isAfter(from) && !on.isAfter(to)) list.add(_Interval(on, off, window.name));
+      }
+    }
+
+    final timelines = <int, _RelayTimeline>{};
+    final events = <ScheduledEvent>[];
+    intervals.forEach((relay, list) {
+      list.sort((a, b) => a.on.compareTo(b.on));
+
+      // Merge overlapping/touching intervals
+      final merged = <_Interval>[];
+      for (final interval in list) {
+        if (merged.isNotEmpty && !interval.on.isAfter(merged.last.off)) {
+          final last = merged.last;
+          if (interval.off.isAfter(last.off)) {
+            merged[merged.length - 1] = _Interval(last.on, interval.off, last.name);
+          }
+        } else {
+          merged.add(interval);
+        }
+      }
+
+      final times = <int>[];
+      final states = <bool>[];
+      bool initial = false;
+      void edge(DateTime time, bool on, String name) {
+        if (!time.isAfter(from)) {
+          initial = on;
+          return;
+        }
+        if (time.isAfter(to)) return;
+        times.add(time.millisecondsSinceEpoch);
+        states.add(on);
+        events.add(ScheduledEvent(time: time, relayIndex: relay, turnOn: on, scheduleName: name));
+      }
+
+      for (final interval in merged) {
+        edge(interval.on, true, interval.name);
+        edge(interval.off, false, interval.name);
+      }
+      timelines[relay] = _RelayTimeline(initial, times, states);
+    });
+
+    events.sort((a, b) => a.time.compareTo(b.time));
+    return SchedulePlan._(from, to, timelines, events);
+  }
+
+  /// Relays this plan manages
+  Iterable<int> get relays => _timelines.keys;
+
+  /// Whether [relay] should be on at [time]; null if the relay isn't
+  /// managed or [time] is outside the plan
+  bool? stateAt(int relay, DateTime time) {
+    final timeline = _timelines[relay];
+    if (timeline == null || time.isBefore(start) || time.isAfter(end)) return null;
+    return timeline.stateAt(time.millisecondsSinceEpoch);
+  }
+
+  /// Target state of every managed relay at [time]
+  Map<int, bool> statesAt(DateTime time) {
+    final t = time.millisecondsSinceEpoch;
+    return {for (final entry in _timelines.entries) entry.key: entry.value.stateAt(t)};
+  }
+
+  /// First edge strictly after [time], or null if none before [end]
+  ScheduledEvent? nextEvent(DateTime time) {
+    final index = _firstAfter(time);
+    return index < _events.length ? _events[index] : null;
+  }
+
+  /// All edges at exactly [time] (relays switched together)
+  List<ScheduledEvent> eventsAt(DateTime time) {
+    final result = <ScheduledEvent>[];
+    for (int i = _firstAfter(time.subtract(const Duration(microseconds: 1)));
+        i < _events.length && _events[i].time.isAtSameMomentAs(time); i++) {
+      result.add(_events[i]);
+    }
+    return result;
+  }
+
+  int _firstAfter(DateTime time) {
+    int low = 0;
+    int high = _events.length;
+    while (low < high) {
+      final mid = (low + high) >> 1;
+      if (_events[mid].time.isAfter(time)) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return low;
+  }
+}
+
+class _Interval {
+  final DateTime on;
+  final DateTime off;
+  final String name;
+
+  _Interval(this.on, this.off, this.name);
+}
+
+class _RelayTimeline {
+  final bool initial; // State at plan start
+  final List<int> times; // Edge times (ms since epoch), ascending
+  final List<bool> states; // State from each edge on
+
+  _RelayTimeline(this.initial, this.times, this.states);
+
+  bool stateAt(int t) {
+    // Last edge at or before t
+    int low = 0;
+    int high = times.length;
+    while (low < high) {
+      final mid = (low + high) >> 1;
+      if (times[mid] <= t) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low == 0 ? initial : states[low - 1];
+  }
+}
@@ -1,13 +1,18 @@
-import 'dart:async';
+import 'dart:convert';
 import 'package:flutter/foundation.dart';
 import '../models/sensor_hub.dart';
 import '../models/hub_diagnostic.dart';
 import 'database_helper.dart';
+import 'hub_bus_scheduler.dart';
+import 'job_scheduler.dart';
 import 'modbus_service.dart';
+import 'sensor_ingest_pipeline.dart';
 
 class SensorHubService {
   final DatabaseHelper _db = DatabaseHelper();
   final ModbusService _modbus = ModbusService();
+  final HubBusScheduler _bus = HubBusScheduler();
+  final SensorIngestPipeline _ingest = SensorIngestPipeline.instance;
 
   // Register Map Constants
   static const int REG_ADC_1 = 0; // 4-20mA #1
@@ -23,6 +28,8 @@ class SensorHubService {
   static const int REG_FW_VER = 10;
   static const int REG_DAC_1 = 11; // 0-10V Out #1
   static const int REG_DAC_2 = 12; // 0-10V Out #2
+  static const int CH_AOUT_1 = 21; // io_channels numbers of the outputs (generateHubChannels)
+  static const int CH_AOUT_2 = 22;
   // Extended Sensors
   static const int REG_BH1750_LUX_HI = 13;
   static const int REG_BH1750_LUX_LO = 14;
@@ -32,8 +39,60 @@ class SensorHubService {
   static const int REG_ATLAS_PH = 18;
   static const int REG_ATLAS_EC_HI = 19;
   static const int REG_ATLAS_EC_LO = 20;
+  static const int REG_SAMPLE_SEQ = 21; // Bumped by the hub on every consistent update
+  static const int REG_HIST_SEQ_HI = 22; // Newest history record sequence
+  static const int REG_HIST_SEQ_LO = 23;
+  static const int REG_CHANGE_MAP = 24; // Channels past their deadband, cleared when read
+  static const int REG_DEADBAND_BASE = 25; // 25-39: per-channel deadband (writable)
 
-  static const int TOTAL_REGISTERS = 21;
+  static const int TOTAL_REGISTERS = 25;
+
+  // Firmware 1.2 added the change map; older hubs get a full read every poll
+  static const int FW_CHANGE_MAP = 0x0102;
+
+  // Register span [first, last] of each change map bit
+  static const List<List<int>> CHANGE_CHANNELS = [
+    [REG_ADC_1, REG_ADC_1],
+    [REG_ADC_2, REG_ADC_2],
+    [REG_ADC_3, REG_ADC_3],
+    [REG_ADC_4, REG_ADC_4],
+    [REG_BME1_TEMP, REG_BME1_TEMP],
+    [REG_BME1_HUM, REG_BME1_HUM],
+    [REG_BME2_TEMP, REG_BME2_TEMP],
+    [REG_BME2_HUM, REG_BME2_HUM],
+    [REG_DIGITAL_IN, REG_DIGITAL_IN],
+    [REG_BH1750_LUX_HI, REG_BH1750_LUX_LO],
+    [REG_SCD40_CO2, REG_SCD40_CO2],
+    [REG_SCD40_TEMP, REG_SCD40_TEMP],
+    [REG_SCD40_HUM, REG_SCD40_HUM],
+    [REG_ATLAS_PH, REG_ATLAS_PH],
+    [REG_ATLAS_EC_HI, REG_ATLAS_EC_LO],
+  ];
+
+  // Diagnostics block (firmware 1.3+), read every DIAG_INTERVAL
+  static const int REG_DIAG_BASE = 48;
+  static const int DIAG_REGISTERS = 48; // 48-95
+  static const int REG_DIAG_TASK_BASE = 60; // 4 per task: min us, avg us, max us, overruns
+  static const int FW_DIAGNOSTICS = 0x0103;
+  static const Duration DIAG_INTERVAL = Duration(minutes: 1);
+  // Per-task blocks, in firmware SensorTask_Id_t order
+  static const List<String> DIAG_TASK_NAMES = [
+    'analog', 'digital', 'bme280_1', 'bme280_2', 'bh1750', 'scd40', 'atlas', 'history', 'diag',
+  ];
+
+  // Addresses probed by discoverHubs
+  static const int MAX_DISCOVERY_ADDRESS = 10;
+
+  // History drain limit per poll (5 records per request)
+  static const int MAX_HISTORY_REQUESTS = 60;
+
+  // Poll rate: setting 'hub_poll_interval_ms', overridable per hub with
+  // 'hub_<id>_poll_interval_ms'. 16 hubs at 1 Hz fit one 9600 baud segment
+  // when polled by exception (~45 ms per hub); full reads need 19200.
+  static const int DEFAULT_POLL_INTERVAL_MS = 1000;
+
+  // Status and diagnostics are accumulated and written in one batch
+  static const Duration PERSIST_INTERVAL = Duration(seconds: 30);
 
   // Conversion Constants
   static const double ADC_MAX = 4095.0;
@@ -42,7 +101,16 @@ class SensorHubService {
   // Cache
   List<SensorHub> _hubs = [];
   bool _isPolling = false;
-  Timer? _pollingTimer;
+  ScheduledJob? _persistJob;
+  final Map<int, Duration> _pollIntervals = {}; // Hub ID -> poll period
+  final Map<int, int> _lastSampleSeq = {}; // Hub ID -> last processed sequence
+  final Map<int, int> _lastHistorySeq = {}; // Hub ID -> newest history record accounted for
+  final Map<int, List<int>> _registerCache = {}; // Hub ID -> last known register block
+  final Map<int, DateTime> _lastDiagRead = {}; // Hub ID -> last diagnostics block read
+
+  // Pending persistence, flushed every PERSIST_INTERVAL
+  final Set<int> _dirtyHubs = {};
+  final Map<int, _PollTally> _tallies = {};
 
   // Singleton pattern
   static final SensorHubService _instance = SensorHubService._internal();
@@ -51,129 +119,297 @@ class SensorHubService {
 
   Future<void> init() async {
     await _loadHubs();
-    startPolling();
+    await startPolling();
   }
 
   Future<void> _loadHubs() async {
     _hubs = await _db.getSensorHubs();
   }
 
-  void startPolling() {
+  Future<void> startPolling() async {
     if (_isPolling) return;
     _isPolling = true;
-    // Poll every 5 seconds
-    _pollingTimer = Timer.periodic(const Duration(seconds: 5), (timer) {
-      _pollHubs();
-    });
+
+    final defaultMs = await _db.getIntSetting('hub_poll_interval_ms',
+        defaultValue: DEFAULT_POLL_INTERVAL_MS);
+    for (final hub in _hubs) {
+      final ms = await _db.getIntSetting('hub_${hub.id}_poll_interval_ms', defaultValue: defaultMs);
+      _pollIntervals[hub.id] = Duration(milliseconds: ms);
+      _schedule(hub);
+    }
+
+    _persistJob = JobScheduler.instance.every('hub_persist', PERSIST_INTERVAL, _flushPending,
+        priority: JobPriority.background, tolerance: const Duration(seconds: 10));
   }
 
   void stopPolling() {
-    _pollingTimer?.cancel();
+    _bus.cancelAllPolls();
+    _persistJob?.cancel();
+    _persistJob = null;
     _isPolling = false;
+    _flushPending();
   }
 
-  Future<void> _pollHubs() async {
-    for (final hub in _hubs) {
-      if (hub.status == 'maintenance') continue;
+  /// Change how often one hub is polled
+  Future<void> setPollInterval(int hubId, Duration interval) async {
+    _pollIntervals[hubId] = interval;
+    await _db.saveIntSetting('hub_${hubId}_poll_interval_ms', interval.inMilliseconds);
+    final index = _hubs.indexWhere((h) => h.id == hubId);
+    if (_isPolling && index != -1) _schedule(_hubs[index]);
+  }
 
-      try {
-        // Read registers 0-20 (21 registers)
-        final readings = await _modbus.readHoldingRegisters(hub.modbusAddress, 0, TOTAL_REGISTERS);
-        
-        if (readings.isEmpty || readings.length < TOTAL_REGISTERS) {
-          throw Exception('Incomplete read from hub ${hub.modbusAddress}');
-        }
+  Duration pollInterval(int hubId) =>
+      _pollIntervals[hubId] ?? const Duration(milliseconds: DEFAULT_POLL_INTERVAL_MS);
 
-        // Update hub status
-        await _updateHubStatus(hub, 'online');
-        
-        // Process readings
+  void _schedule(SensorHub hub) {
+    _bus.schedulePoll(hub.id, pollInterval(hub.id), () => _pollHub(hub.id));
+  }
+
+  /// One poll of one hub
+  /// Runs concurrently with the other hubs' polls; each register read is
+  /// queued on the bus, so the line stays busy while this hub's results
+  /// are processed. Only the ingestion plan rebuild (once a minute)
+  /// touches the database.
+  Future<void> _pollHub(int hubId) async {
+    final index = _hubs.indexWhere((h) => h.id == hubId);
+    if (index == -1) {
+      _bus.cancelPoll(hubId);
+      return;
+    }
+    final hub = _hubs[index];
+    if (hub.status == 'maintenance') return;
+
+    final tally = _tallies.putIfAbsent(hub.id, () => _PollTally());
+
+    try {
+      final stopwatch = Stopwatch()..start();
+      final readings = await _readHub(hub);
+      final responseTimeMs = stopwatch.elapsedMicroseconds / 1000.0;
+
+      // Update hub status
+      _updateHubStatus(hub, 'online');
+
+      // Recover samples recorded while the hub was unreachable
+      await _drainHistory(hub, (readings[REG_HIST_SEQ_HI] << 16) | readings[REG_HIST_SEQ_LO]);
+
+      // Process readings only if the hub published a new sample
+      // (sequence 0 = older firmware or nothing published yet)
+      final seq = readings[REG_SAMPLE_SEQ];
+      if (seq == 0 || seq != _lastSampleSeq[hub.id]) {
+        _lastSampleSeq[hub.id] = seq;
         await _processReadings(hub, readings);
+      }
+
+      // Hub timing telemetry, at a lower rate than the data
+      final lastDiag = _lastDiagRead[hub.id];
+      if (readings[REG_FW_VER] >= FW_DIAGNOSTICS &&
+          (lastDiag == null || DateTime.now().difference(lastDiag) >= DIAG_INTERVAL)) {
+        _lastDiagRead[hub.id] = DateTime.now();
+        final block = await _bus.submit(BusPriority.background,
+            () => _modbus.readHoldingRegisters(hub.modbusAddress, REG_DIAG_BASE, DIAG_REGISTERS));
+        if (block.length == DIAG_REGISTERS) tally.telemetry = block;
+      }
+
+      tally.addSuccess(responseTimeMs);
+
+    } catch (e) {
+      // A lost reply may have cleared the change map - start over with a full read
+      _registerCache.remove(hub.id);
+      debugPrint('Error polling hub ${hub.name}: $e');
+      _updateHubStatus(hub, 'error');
+      tally.addError(e.toString());
+    }
+  }
+
+  Future<List<int>> _read(SensorHub hub, int startReg, int count) {
+    return _bus.submit(BusPriority.poll,
+        () => _modbus.readHoldingRegisters(hub.modbusAddress, startReg, count));
+  }
+
+  /// Read the hub's register block
+  /// Hubs with a change map are polled by exception: one short read of
+  /// registers 21-24 (sample sequence, history sequence, change map), then
+  /// one read spanning just the flagged channels, patched into the cached
+  /// block. First contact, old firmware and recovery after an error use a
+  /// full read of registers 0-24, which also clears the change map.
+  Future<List<int>> _readHub(SensorHub hub) async {
+    final cached = _registerCache[hub.id];
+
+    if (cached == null || cached[REG_FW_VER] < FW_CHANGE_MAP) {
+      final readings = await _read(hub, 0, TOTAL_REGISTERS);
+      if (readings.length < TOTAL_REGISTERS) {
+        throw Exception('Incomplete read from hub ${hub.modbusAddress}');
+      }
+      _registerCache[hub.id] = readings;
+      return readings;
+    }
+
+    const statusCount = REG_CHANGE_MAP - REG_SAMPLE_SEQ + 1;
+    final status = await _read(hub, REG_SAMPLE_SEQ, statusCount);
+    if (status.length < statusCount) {
+      throw Exception('Incomplete status read from hub ${hub.modbusAddress}');
+    }
+    cached.setRange(REG_SAMPLE_SEQ, REG_CHANGE_MAP + 1, status);
+
+    // One request covering every flagged channel beats one per channel:
+    // the turnaround costs more bus time than the extra registers
+    final changed = status[REG_CHANGE_MAP - REG_SAMPLE_SEQ];
+    int first = -1;
+    int last = -1;
+    for (int bit = 0; bit < CHANGE_CHANNELS.length; bit++) {
+      if (changed & (1 << bit) == 0) continue;
+      if (first < 0) first = CHANGE_CHANNELS[bit][0];
+      last = CHANGE_CHANNELS[bit][1];
+    }
+
+    if (first >= 0) {
+      final count = last - first + 1;
+      final span = await _read(hub, first, count);
+      if (span.length < count) {
+        throw Exception('Incomplete channel read from hub ${hub.modbusAddress}');
+      }
+      cached.setRange(first, last + 1, span);
+    }
+
+    return cached;
+  }
+
+  /// Fetch history records missed since the last successful poll
+  /// With polls faster than the 10 s hub record interval at most one record
+  /// is new per poll; anything more means polls were lost and is backfilled.
+  /// The newest record is skipped since the live read already covers it.
+  Future<void> _drainHistory(SensorHub hub, int newestSeq) async {
+    final lastSeq = _lastHistorySeq[hub.id];
+
+    // First contact or hub rebooted (sequence restarted): nothing to backfill
+    if (lastSeq == null || newestSeq < lastSeq) {
+      _lastHistorySeq[hub.id] = newestSeq;
+      return;
+    }
+
+    if (newestSeq - lastSeq <= 1) {
+      _lastHistorySeq[hub.id] = newestSeq;
+      return;
+    }
 
-        // Log success
-        await _logDiagnostic(hub.id, success: true);
+    int nextSeq = lastSeq + 1;
+    for (int i = 0; i < MAX_HISTORY_REQUESTS && nextSeq < newestSeq; i++) {
+      final page = await _bus.submit(BusPriority.background,
+          () => _modbus.readHistory(hub.modbusAddress, nextSeq));
+      if (page == null || page.records.isEmpty) break;
 
-      } catch (e) {
-        debugPrint('Error polling hub ${hub.name}: $e');
-        await _updateHubStatus(hub, 'error');
-        await _logDiagnostic(hub.id, success: false, error: e.toString());
+      final receivedAt = DateTime.now();
+      for (final record in page.records) {
+        if (record.sequence >= newestSeq) break;
+        await _processReadings(hub, record.registers,
+            timestamp: receivedAt.subtract(Duration(milliseconds: record.ageMs)));
       }
+      nextSeq = page.records.last.sequence + 1;
     }
+
+    debugPrint('Hub ${hub.name}: backfilled history ${lastSeq + 1}..${nextSeq - 1}');
+    _lastHistorySeq[hub.id] = newestSeq;
   }
 
-  Future<void> _updateHubStatus(SensorHub hub, String status) async {
+  /// Update the cached hub; the row is written on the next flush
+  void _updateHubStatus(SensorHub hub, String status) {
     if (hub.status != status) {
       final updatedHub = hub.copyWith(
         status: status,
         lastSeen: DateTime.now().toIso8601String(),
       );
-      await _db.updateSensorHub(updatedHub);
       // Update local cache
       final index = _hubs.indexWhere((h) => h.id == hub.id);
       if (index != -1) _hubs[index] = updatedHub;
+      _dirtyHubs.add(hub.id);
+    }
+  }
+
+  /// Write changed hub rows and one diagnostics row per polled hub
+  /// At 1 Hz a row per poll would be 16 inserts a second for a full bus;
+  /// each row instead covers every poll since the last flush.
+  Future<void> _flushPending() async {
+    if (_dirtyHubs.isEmpty && _tallies.isEmpty) return;
+
+    final hubs = _hubs.where((h) => _dirtyHubs.contains(h.id)).toList();
+    final diagnostics = [
+      for (final entry in _tallies.entries)
+        if (entry.value.polls > 0) _toDiagnostic(entry.key, entry.value)
+    ];
+    _dirtyHubs.clear();
+    _tallies.clear();
+
+    try {
+      await _db.saveHubPollResults(hubs, diagnostics);
+    } catch (e) {
+      debugPrint('Error saving hub poll results: $e');
     }
   }
 
-  Future<void> _processReadings(SensorHub hub, List<int> readings) async {
-    // 32-bit value reconstruction
-    int luxRaw = (readings[REG_BH1750_LUX_HI] << 16) | readings[REG_BH1750_LUX_LO];
-    int ecRaw = (readings[REG_ATLAS_EC_HI] << 16) | readings[REG_ATLAS_EC_LO];
-
-    // Convert raw readings to meaningful values
-    final data = {
-      'adc1_raw': readings[REG_ADC_1],
-      'adc2_raw': readings[REG_ADC_2],
-      'adc3_raw': readings[REG_ADC_3],
-      'adc4_raw': readings[REG_ADC_4],
-      'bme1_temp': readings[REG_BME1_TEMP] / 100.0,
-      'bme1_hum': readings[REG_BME1_HUM] / 100.0,
-      'bme2_temp': readings[REG_BME2_TEMP] / 100.0,
-      'bme2_hum': readings[REG_BME2_HUM] / 100.0,
-      'digital_inputs': readings[REG_DIGITAL_IN],
-      'hub_id': readings[REG_HUB_ID],
-      'fw_version': readings[REG_FW_VER],
-      'dac1_val': readings[REG_DAC_1],
-      'dac2_val': readings[REG_DAC_2],
-      // Extended
-      'lux': luxRaw / 100.0,
-      'co2_ppm': readings[REG_SCD40_CO2],
-      'scd_temp': readings[REG_SCD40_TEMP] / 100.0,
-      'scd_hum': readings[REG_SCD40_HUM] / 100.0,
-      'ph': readings[REG_ATLAS_PH] / 100.0, // Atlas pH is usually x100 or x1000. Header said x1000 but reg map comment said x100. Firmware used x100.
-      'ec_us': ecRaw,
-      // Calculated values
-      'current_1_ma': _adcToCurrent(readings[REG_ADC_1]),
-      'current_2_ma': _adcToCurrent(readings[REG_ADC_2]),
-      'voltage_1_v': _adcToVoltage(readings[REG_ADC_3]),
-      'voltage_2_v': _adcToVoltage(readings[REG_ADC_4]),
-    };
-
-    // TODO: Map these values to specific sensors in DB
-    // For now, we just log them
-    // debugPrint('Hub ${hub.name} Data: $data');
+  /// Hand a register block (live or backfilled) to the ingestion pipeline
+  Future<void> _processReadings(SensorHub hub, List<int> readings, {DateTime? timestamp}) async {
+    try {
+      await _ingest.ingestHubSample(hub, readings, timestamp: timestamp);
+    } catch (e) {
+      debugPrint('Error logging readings from hub ${hub.name}: $e');
+    }
   }
 
+  /// Convert Voltage (0-10V) to a DAC value for REG_DAC_1/2
+  static int voltageToDac(double volts) => (volts.clamp(0.0, 10.0) / 10.0 * DAC_MAX).round();
+
   /// Convert ADC value to Current (4-20mA)
-  double _adcToCurrent(int adc) {
+  static double adcToCurrent(int adc) {
     if (adc < 745) return 4.0; 
     return (adc - 745) * 16 / 2978 + 4;
   }
 
   /// Convert ADC value to Voltage (0-10V)
-  double _adcToVoltage(int adc) {
+  static double adcToVoltage(int adc) {
     return adc * 10.0 / 3878.0;
   }
 
-  Future<void> _logDiagnostic(int hubId, {required bool success, String? error}) async {
-    final diag = HubDiagnostic(
+  /// Diagnostics row for the polls since the last flush
+  /// [tally.telemetry] is the hub's diagnostics block (registers 48-95) when
+  /// it was read during the window.
+  HubDiagnostic _toDiagnostic(int hubId, _PollTally tally) {
+    final telemetry = tally.telemetry;
+    int? reg(int r) => telemetry?[r - REG_DIAG_BASE];
+
+    String? taskTiming;
+    if (telemetry != null) {
+      final tasks = <String, Map<String, int>>{};
+      for (int i = 0; i < DIAG_TASK_NAMES.length; i++) {
+        final base = REG_DIAG_TASK_BASE - REG_DIAG_BASE + i * 4;
+        tasks[DIAG_TASK_NAMES[i]] = {
+          'min_us': telemetry[base],
+          'avg_us': telemetry[base + 1],
+          'max_us': telemetry[base + 2],
+          'overruns': telemetry[base + 3],
+        };
+      }
+      taskTiming = jsonEncode(tasks);
+    }
+
+    return HubDiagnostic(
       id: 0, 
       hubId: hubId,
       timestamp: DateTime.now().toIso8601String(),
-      successfulReads: success ? 1 : 0,
-      communicationErrors: success ? 0 : 1,
-      lastErrorMessage: error,
+      successfulReads: tally.successes,
+      communicationErrors: tally.errors,
+      averageResponseTimeMs: tally.averageResponseMs,
+      lastErrorMessage: tally.lastError,
+      loopAvgUs: reg(48),
+      loopMaxUs: reg(49),
+      jitterMaxMs: reg(50),
+      turnaroundUs: reg(51),
+      turnaroundMaxUs: reg(52),
+      crcErrors: reg(53),
+      frameOverruns: reg(54),
+      i2cErrors: telemetry == null ? null : reg(55)! + reg(56)!,
+      i2cMaxUs: telemetry == null ? null : (reg(57)! > reg(58)! ? reg(57) : reg(58)),
+      taskTiming: taskTiming,
     );
-    await _db.insertHubDiagnostic(diag);
   }
 
   Future<void> calibrateSensor(int sensorId, double referenceValue, double currentValue) async {
@@ -183,10 +419,64 @@ class SensorHubService {
     await Future.delayed(const Duration(milliseconds: 500));
   }
 
+  // --- Writes ---
+  // Queued at control priority: they go out ahead of polls and background
+  // reads, at the next free slot on the bus.
+
+  /// Write [values] to a hub's registers from [startReg] (0x10)
+  Future<bool> writeRegisters(int hubId, int startReg, List<int> values) async {
+    final index = _hubs.indexWhere((h) => h.id == hubId);
+    if (index == -1) return false;
+    final address = _hubs[index].modbusAddress;
+    return _bus.submit(BusPriority.control,
+        () => _modbus.writeMultipleRegisters(address, startReg, values));
+  }
+
+  /// Write [values] from [writeStart], then read [readCount] registers from
+  /// [readStart] in the same exchange (0x17); empty on failure
+  Future<List<int>> writeAndReadRegisters(
+      int hubId, int writeStart, List<int> values, int readStart, int readCount) async {
+    final index = _hubs.indexWhere((h) => h.id == hubId);
+    if (index == -1) return [];
+    final address = _hubs[index].modbusAddress;
+    return _bus.submit(BusPriority.control,
+        () => _modbus.readWriteMultipleRegisters(address, readStart, readCount, writeStart, values));
+  }
+
+  /// Set both 0-10V outputs in one write
+  Future<bool> setAnalogOutputs(int hubId, double volts1, double volts2) =>
+      writeRegisters(hubId, REG_DAC_1, [voltageToDac(volts1), voltageToDac(volts2)]);
+
+  /// Switch the output on io_channels [channel] of the hub at [modbusAddress]
+  /// fully on (10V) or off; throws for a hub or channel that can't be switched
+  Future<bool> switchOutput(int modbusAddress, int channel, bool on) {
+    final index = _hubs.indexWhere((h) => h.modbusAddress == modbusAddress);
+    if (index == -1) throw Exception('No sensor hub at address $modbusAddress');
+    if (channel != CH_AOUT_1 && channel != CH_AOUT_2) {
+      throw Exception('Hub #$modbusAddress channel $channel is not an output');
+    }
+    final register = channel == CH_AOUT_1 ? REG_DAC_1 : REG_DAC_2;
+    return writeRegisters(_hubs[index].id, register, [voltageToDac(on ? 10.0 : 0.0)]);
+  }
+
+  /// Set the per-channel deadbands (change map bit order, raw register units)
+  Future<bool> setDeadbands(int hubId, List<int> deadbands) =>
+      writeRegisters(hubId, REG_DEADBAND_BASE, deadbands);
+
   // --- Discovery ---
 
+  /// Probe the discovery range for hubs and add any new ones
+  /// Each address is its own background job, so polls keep running
+  /// between probes instead of waiting out the whole scan.
   Future<List<SensorHub>> discoverHubs() async {
-    final addresses = await _modbus.scanForHubs();
+    final probes = await Future.wait([
+      for (int addr = 1; addr <= MAX_DISCOVERY_ADDRESS; addr++)
+        _bus.submit(BusPriority.background, () => _modbus.readHoldingRegisters(addr, 0, 1))
+    ]);
+    final addresses = [
+      for (int i = 0; i < probes.length; i++)
+        if (probes[i].isNotEmpty) i + 1
+    ];
     final newHubs = <SensorHub>[];
 
     for (final addr in addresses) {
@@ -207,8 +497,31 @@ class SensorHubService {
         final savedHub = newHub.copyWith(id: id);
         _hubs.add(savedHub);
         newHubs.add(savedHub);
+        if (_isPolling) _schedule(savedHub);
       }
     }
     return newHubs;
   }
 }
+
+/// Poll outcomes for one hub since the last flush
+class _PollTally {
+  int successes = 0;
+  int errors = 0;
+  double _totalResponseMs = 0;
+  String? lastError;
+  List<int>? telemetry;
+
+  int get polls => successes + errors;
+  double? get averageResponseMs => successes == 0 ? null : _totalResponseMs / successes;
+
+  void addSuccess(double responseMs) {
+    successes++;
+    _totalResponseMs += responseMs;
+  }
+
+  void addError(String message) {
+    errors++;
+    lastError = message;
+  }
+}
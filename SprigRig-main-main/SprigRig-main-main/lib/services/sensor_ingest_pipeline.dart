@@ -0,0 +1,308 @@
+import 'dart:async';
+import 'package:flutter/foundation.dart';
+import '../models/io_channel.dart';
+import '../models/sensor.dart';
+import '../models/sensor_calibration.dart';
+import '../models/sensor_hub.dart';
+import 'database_helper.dart';
+import 'sensor_hub_service.dart';
+import 'sensor_reading_buffer.dart';
+
+/// Turns raw sensor values into logged readings
+/// Stages: channel-to-sensor mapping (sensors.hub_id/input_channel against
+/// the hub's io_channels), calibration (the sensor's scale/offset and its
+/// newest sensor_calibrations row), deadband filtering, then a batched
+/// write through [SensorReadingBuffer].
+///
+/// For hubs the first two stages are compiled once into a flat list of
+/// bindings - register decoder plus one folded linear calibration - so a
+/// sample is a single pass over that list with no database or map lookups.
+/// Plans are rebuilt every [PLAN_TTL], or on the next sample after
+/// [invalidate], to pick up new sensors and calibrations.
+///
+/// Every calibrated value is also published on [samples] before the
+/// deadband, for consumers that react to readings rather than store them.
+class SensorIngestPipeline {
+  static SensorIngestPipeline? _instance;
+  static SensorIngestPipeline get instance => _instance ??= SensorIngestPipeline._internal();
+
+  SensorIngestPipeline._internal();
+
+  static const Duration PLAN_TTL = Duration(minutes: 1);
+
+  // A value inside its deadband is still logged after this long, so a
+  // steady sensor keeps showing up in charts and rollups
+  static const Duration HEARTBEAT = Duration(minutes: 5);
+
+  // Smallest change worth a row, in calibrated units. Types not listed
+  // only drop exact repeats.
+  static const Map<String, double> DEADBANDS = {
+    'temperature': 0.1,
+    'humidity': 0.5,
+    'moisture': 0.5,
+    'ph': 0.02,
+    'ec': 10.0,
+    'co2': 10.0,
+    'light_intensity': 5.0,
+    'water_level': 0.5,
+    'pressure': 0.1,
+  };
+
+  final DatabaseHelper _db = DatabaseHelper();
+  final SensorReadingBuffer _buffer = SensorReadingBuffer.instance;
+
+  final Map<int, _HubPlan> _hubPlans = {}; // Hub ID -> compiled plan
+  final Map<int, Future<_HubPlan>> _compiling = {};
+  final Map<String, _Binding> _directBindings = {}; // 'sensorId:type' -> binding
+  final Map<String, _LastLogged> _lastLogged = {}; // Survives plan rebuilds
+  final StreamController<SensorSample> _samplesController = StreamController<SensorSample>.broadcast();
+
+  // Totals since start
+  int accepted = 0;
+  int filtered = 0;
+
+  /// Calibrated values as they arrive, including ones the deadband drops
+  Stream<SensorSample> get samples => _samplesController.stream;
+
+  /// Drop compiled plans; call after sensors or calibrations change
+  void invalidate() {
+    _hubPlans.clear();
+    _directBindings.clear();
+  }
+
+  /// Map one hub register block to sensor readings and queue them
+  /// [timestamp] is when the hub took the sample (now if omitted).
+  Future<void> ingestHubSample(SensorHub hub, List<int> registers, {DateTime? timestamp}) async {
+    var plan = _hubPlans[hub.id];
+    if (plan == null || plan.isStale(hub)) {
+      plan = await (_compiling[hub.id] ??= _compileHub(hub));
+    }
+
+    final ts = (timestamp ?? DateTime.now()).millisecondsSinceEpoch ~/ 1000;
+    for (final binding in plan.bindings) {
+      _offer(binding, binding.decode!(registers) * binding.scale + binding.offset, ts);
+    }
+  }
+
+  /// Calibrate, filter and queue one value read directly (not via a hub)
+  /// Returns the calibrated value.
+  Future<double> ingestValue(Sensor sensor, String readingType, double raw, {DateTime? timestamp}) async {
+    final key = '${sensor.id}:$readingType';
+    var binding = _directBindings[key];
+    if (binding == null || DateTime.now().difference(binding.builtAt) > PLAN_TTL) {
+      final calibrations = await _db.getSensorCalibrations(sensor.id);
+      binding = _directBindings[key] = _bind(sensor, readingType, null, calibrations);
+    }
+
+    final value = raw * binding.scale + binding.offset;
+    _offer(binding, value, (timestamp ?? DateTime.now()).millisecondsSinceEpoch ~/ 1000);
+    return value;
+  }
+
+  void _offer(_Binding binding, double value, int timestamp) {
+    if (!value.isFinite) return;
+
+    if (_samplesController.hasListener) {
+      _samplesController.add(SensorSample(binding.sensorId, binding.readingType, value, timestamp));
+    }
+
+    final last = binding.last;
+    final previous = last.value;
+    if (timestamp >= last.timestamp) {
+      if (previous != null &&
+          (value - previous).abs() <= binding.deadband &&
+          timestamp - last.timestamp < HEARTBEAT.inSeconds) {
+        filtered++;
+        return;
+      }
+      last.value = value;
+      last.timestamp = timestamp;
+    }
+    // Older than the last logged value (history backfill): always kept
+
+    accepted++;
+    _buffer.add(binding.sensorId, binding.readingType, value, timestamp: timestamp);
+  }
+
+  Future<_HubPlan> _compileHub(SensorHub hub) async {
+    final bindings = <_Binding>[];
+    try {
+      final channels = {
+        for (final channel in await _db.getIoChannelsByModule(hub.modbusAddress + 100))
+          channel.channelNumber: channel
+      };
+
+      for (final sensor in await _db.getSensorsByHub(hub.id)) {
+        if (!sensor.enabled || !sensor.isActive) continue;
+
+        final sources = _hubSources(sensor, channels[sensor.inputChannel]);
+        if (sources.isEmpty) {
+          debugPrint('Hub ${hub.name}: no hub channel for sensor ${sensor.name} '
+              '(${sensor.sensorType} on channel ${sensor.inputChannel})');
+          continue;
+        }
+
+        final calibrations = await _db.getSensorCalibrations(sensor.id);
+        sources.forEach((readingType, decode) {
+          bindings.add(_bind(sensor, readingType, decode, calibrations));
+        });
+      }
+    } catch (e) {
+      // Keep logging with the previous plan; retried after PLAN_TTL
+      debugPrint('Error compiling sensor map for hub ${hub.name}: $e');
+      final previous = _hubPlans[hub.id];
+      if (previous != null) bindings.addAll(previous.bindings);
+    } finally {
+      _compiling.remove(hub.id);
+    }
+
+    final plan = _HubPlan(hub.modbusAddress, bindings);
+    _hubPlans[hub.id] = plan;
+    return plan;
+  }
+
+  _Binding _bind(Sensor sensor, String readingType, _RegisterDecoder? decode,
+      List<SensorCalibration> calibrations) {
+    // Sensor-level scale/offset first, then the newest calibration record
+    double scale = sensor.scaleFactor;
+    double offset = sensor.calibrationOffset;
+
+    SensorCalibration? latest;
+    for (final calibration in calibrations) {
+      if (calibration.parameterName != readingType) continue;
+      if (latest == null || calibration.id > latest.id) latest = calibration;
+    }
+
+    if (latest != null) {
+      double s = latest.scaleFactor;
+      double o = latest.offsetValue;
+
+      // Two-point calibration wins over a plain offset when complete
+      final measuredLow = latest.measuredLow;
+      final measuredHigh = latest.measuredHigh;
+      final referenceLow = latest.referenceLow;
+      final referenceHigh = latest.referenceHigh;
+      if (measuredLow != null && measuredHigh != null && referenceLow != null &&
+          referenceHigh != null && measuredHigh != measuredLow) {
+        s = (referenceHigh - referenceLow) / (measuredHigh - measuredLow);
+        o = referenceLow - measuredLow * s;
+      }
+
+      scale *= s;
+      offset = offset * s + o;
+    }
+
+    return _Binding(
+      sensorId: sensor.id,
+      readingType: readingType,
+      decode: decode,
+      scale: scale,
+      offset: offset,
+      deadband: DEADBANDS[readingType] ?? 0.0,
+      last: _lastLogged.putIfAbsent('${sensor.id}:$readingType', () => _LastLogged()),
+    );
+  }
+
+  /// Register decoders for a hub sensor, by reading type
+  /// Channels 1-4 are the analog inputs and 9-12 the digital inputs, typed
+  /// by io_channels. Channels 5-8 carry the two BME280 buses (5-6 on I2C1,
+  /// 7-8 on I2C2). The BH1750, SCD40 and Atlas probes have fixed registers
+  /// and are matched by sensor type. Types the hub firmware doesn't read
+  /// (DHT22, TSL2561) get no sources and are skipped.
+  static Map<String, _RegisterDecoder> _hubSources(Sensor sensor, IoChannel? channel) {
+    final readingType = sensor.getSupportedReadingTypes().first;
+
+    if (channel != null && channel.isInput) {
+      final number = channel.channelNumber;
+      switch (channel.type) {
+        case 'ai_4_20':
+          final reg = SensorHubService.REG_ADC_1 + number - 1;
+          return {readingType: (r) => SensorHubService.adcToCurrent(r[reg])};
+        case 'ai_0_10':
+          final reg = SensorHubService.REG_ADC_1 + number - 1;
+          return {readingType: (r) => SensorHubService.adcToVoltage(r[reg])};
+        case 'di':
+          final bit = number - 9;
+          return {readingType: (r) => ((r[SensorHubService.REG_DIGITAL_IN] >> bit) & 1).toDouble()};
+      }
+    }
+
+    switch (sensor.sensorType) {
+      case 'bme280':
+        final second = (sensor.inputChannel ?? 5) >= 7;
+        final temp = second ? SensorHubService.REG_BME2_TEMP : SensorHubService.REG_BME1_TEMP;
+        final hum = second ? SensorHubService.REG_BME2_HUM : SensorHubService.REG_BME1_HUM;
+        return {
+          'temperature': (r) => _signed(r[temp]) / 100.0,
+          'humidity': (r) => r[hum] / 100.0,
+        };
+      case 'light_sensor':
+        return {
+          'light_intensity': (r) => ((r[SensorHubService.REG_BH1750_LUX_HI] << 16) |
+              r[SensorHubService.REG_BH1750_LUX_LO]) / 100.0,
+        };
+      case 'co2_sensor':
+        return {'co2': (r) => r[SensorHubService.REG_SCD40_CO2].toDouble()};
+      case 'ph_sensor':
+        return {'ph': (r) => r[SensorHubService.REG_ATLAS_PH] / 100.0};
+      case 'ec_sensor':
+        return {
+          'ec': (r) => ((r[SensorHubService.REG_ATLAS_EC_HI] << 16) |
+              r[SensorHubService.REG_ATLAS_EC_LO]).toDouble(),
+        };
+    }
+    return {};
+  }
+
+  static int _signed(int value) => value >= 0x8000 ? value - 0x10000 : value;
+}
+
+/// One calibrated value from [SensorIngestPipeline.samples]
+class SensorSample {
+  final int sensorId;
+  final String readingType;
+  final double value;
+  final int timestamp; // Unix seconds, when the value was measured
+
+  const SensorSample(this.sensorId, this.readingType, this.value, this.timestamp);
+}
+
+typedef _RegisterDecoder = double Function(List<int> registers);
+
+class _HubPlan {
+  final int hubAddress;
+  final List<_Binding> bindings;
+  final DateTime builtAt = DateTime.now();
+
+  _HubPlan(this.hubAddress, this.bindings);
+
+  bool isStale(SensorHub hub) =>
+      hub.modbusAddress != hubAddress ||
+      DateTime.now().difference(builtAt) > SensorIngestPipeline.PLAN_TTL;
+}
+
+class _Binding {
+  final int sensorId;
+  final String readingType;
+  final _RegisterDecoder? decode; // Null for directly read sensors
+  final double scale;
+  final double offset;
+  final double deadband;
+  final _LastLogged last;
+  final DateTime builtAt = DateTime.now();
+
+  _Binding({
+    required this.sensorId,
+    required this.readingType,
+    required this.decode,
+    required this.scale,
+    required this.offset,
+    required this.deadband,
+    required this.last,
+  });
+}
+
+class _LastLogged {
+  double? value;
+  int timestamp = 0; // Unix seconds
+}
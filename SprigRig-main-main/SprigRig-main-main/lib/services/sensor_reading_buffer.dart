@@ -0,0 +1,113 @@
+import 'package:flutter/foundation.dart';
+import '../models/sensor.dart';
+import 'database_helper.dart';
+import 'job_scheduler.dart';
+
+/// Write-behind buffer for sensor_readings
+/// Readings are collected in memory and written in one transaction every
+/// flush interval (setting 'reading_flush_interval_ms') or as soon as
+/// 'reading_flush_size' are waiting, whichever comes first. One commit per
+/// flush instead of one per value keeps the SD card's write rate flat as
+/// hubs are added. Readings not yet flushed are not visible to queries;
+/// call [flush] first where that matters.
+class SensorReadingBuffer {
+  static SensorReadingBuffer? _instance;
+  static SensorReadingBuffer get instance => _instance ??= SensorReadingBuffer._internal();
+
+  SensorReadingBuffer._internal();
+
+  static const int DEFAULT_FLUSH_INTERVAL_MS = 5000;
+  static const int DEFAULT_FLUSH_SIZE = 500;
+  static const int MAX_BUFFERED = 20000; // Oldest dropped beyond this if the DB keeps failing
+
+  final DatabaseHelper _db = DatabaseHelper();
+
+  List<SensorReading> _buffer = [];
+  Duration _flushInterval = const Duration(milliseconds: DEFAULT_FLUSH_INTERVAL_MS);
+  int _flushSize = DEFAULT_FLUSH_SIZE;
+  ScheduledJob? _flushJob;
+  Future<void> _flushing = Future.value();
+  bool _retrying = false; // Last write failed; only the scheduled retry flushes
+  bool _configured = false;
+
+  // Totals since start
+  int written = 0;
+  int dropped = 0;
+  int flushes = 0;
+
+  int get pending => _buffer.length;
+
+  /// Load the flush settings (called on first use)
+  Future<void> configure() async {
+    final intervalMs = await _db.getIntSetting('reading_flush_interval_ms',
+        defaultValue: DEFAULT_FLUSH_INTERVAL_MS);
+    _flushInterval = Duration(milliseconds: intervalMs);
+    _flushSize = await _db.getIntSetting('reading_flush_size', defaultValue: DEFAULT_FLUSH_SIZE);
+    _configured = true;
+  }
+
+  /// Queue one reading; [timestamp] is Unix seconds (now if omitted)
+  void add(int sensorId, String readingType, double value, {int? timestamp}) {
+    if (!_configured) {
+      _configured = true;
+      configure();
+    }
+
+    _buffer.add(SensorReading(
+      id: 0,
+      sensorId: sensorId,
+      readingType: readingType,
+      value: value,
+      timestamp: timestamp ?? (DateTime.now().millisecondsSinceEpoch ~/ 1000),
+    ));
+
+    // After a failure the put-back rows alone can exceed the flush size, so
+    // wait for the retry rather than hitting the database on every reading
+    if (_buffer.length >= _flushSize && !_retrying) {
+      flush();
+    } else {
+      _scheduleFlush();
+    }
+  }
+
+  /// Write everything queued so far; completes when it is committed
+  Future<void> flush() {
+    _flushJob?.cancel();
+    _flushJob = null;
+    if (_buffer.isEmpty) return _flushing;
+
+    final readings = _buffer;
+    _buffer = [];
+
+    // One flush at a time, in order
+    _flushing = _flushing.then((_) => _write(readings));
+    return _flushing;
+  }
+
+  void _scheduleFlush() {
+    // Batches can wait a little longer to share a wakeup
+    _flushJob ??= JobScheduler.instance.after('reading_flush', _flushInterval, flush,
+        priority: JobPriority.background, tolerance: _flushInterval ~/ 2);
+  }
+
+  Future<void> _write(List<SensorReading> readings) async {
+    try {
+      await _db.insertSensorReadings(readings);
+      written += readings.length;
+      flushes++;
+      _retrying = false;
+    } catch (e) {
+      debugPrint('Error flushing ${readings.length} sensor readings: $e');
+
+      // Put them back ahead of newer readings and retry after the interval
+      _retrying = true;
+      _buffer = [...readings, ..._buffer];
+      if (_buffer.length > MAX_BUFFERED) {
+        final excess = _buffer.length - MAX_BUFFERED;
+        _buffer = _buffer.sublist(excess);
+        dropped += excess;
+      }
+      _scheduleFlush();
+    }
+  }
+}
@@ -0,0 +1,194 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+
+/// Client for python/hardware/sensor_worker.py
+/// One helper process is started on first use and kept running; requests
+/// and replies are length-prefixed binary frames over its stdin/stdout
+/// (layout documented in the script). The process keeps its buses and
+/// driver objects open between readings.
+///
+/// The script serves one request at a time, so requests queue here and
+/// each is sent once the previous one has answered; its timeout starts
+/// when it is sent. A request that times out kills the process (a driver
+/// is wedged), and the next request starts a fresh one, as does any exit.
+class SensorWorker {
+  static const int _magic0 = 0x53; // 'S'
+  static const int _magic1 = 0x52; // 'R'
+  static const int _responseHeaderSize = 7;
+  static const Duration defaultTimeout = Duration(seconds: 10); // DHT22 retries take ~6 s
+
+  final String scriptPath;
+
+  Process? _process;
+  Future<Process>? _starting;
+  final Queue<_WorkerRequest> _queue = Queue();
+  _WorkerRequest? _inFlight;
+  int _nextId = 0;
+
+  SensorWorker(this.scriptPath);
+
+  /// Read one value; throws if the sensor or the worker fails
+  Future<double> read(String sensorType, String address, String readingType,
+      {Duration timeout = defaultTimeout}) {
+    final id = _nextId;
+    _nextId = (_nextId + 1) & 0xFFFF;
+
+    final payload = utf8.encode('$sensorType\u0000$address\u0000$readingType');
+    final header = ByteData(6)
+      ..setUint8(0, _magic0)
+      ..setUint8(1, _magic1)
+      ..setUint16(2, id, Endian.little)
+      ..setUint16(4, payload.length, Endian.little);
+
+    final request = _WorkerRequest(id, [...header.buffer.asUint8List(), ...payload], timeout,
+        '$sensorType $address');
+    _queue.add(request);
+    _sendNext();
+    return request.completer.future;
+  }
+
+  /// Stop the helper process
+  void dispose() {
+    _process?.kill();
+    _process = null;
+    final inFlight = _inFlight;
+    _inFlight = null;
+    inFlight?.fail('Sensor worker stopped');
+    while (_queue.isNotEmpty) {
+      _queue.removeFirst().fail('Sensor worker stopped');
+    }
+  }
+
+  Future<void> _sendNext() async {
+    if (_inFlight != null || _queue.isEmpty) return;
+    final request = _queue.removeFirst();
+    _inFlight = request;
+
+    final Process process;
+    try {
+      process = await _ensureStarted();
+    } catch (e) {
+      _finish(request);
+      request.completer.completeError(e);
+      return;
+    }
+    if (!identical(_inFlight, request)) return; // Stopped while starting
+
+    process.stdin.add(request.frame);
+    request.timer = Timer(request.timeout, () {
+      if (!identical(_inFlight, request)) return;
+      // The script is stuck in a driver call; only a new process recovers
+      debugPrint('sensor_worker: no reply for ${request.label}, restarting');
+      if (identical(_process, process)) _process = null;
+      process.kill();
+      _finish(request);
+      request.fail('Sensor worker timed out reading ${request.label}');
+    });
+  }
+
+  /// Clear [request] from the in-flight slot and send the next one
+  void _finish(_WorkerRequest request) {
+    request.timer?.cancel();
+    if (identical(_inFlight, request)) _inFlight = null;
+    _sendNext();
+  }
+
+  Future<Process> _ensureStarted() {
+    final running = _process;
+    if (running != null) return Future.value(running);
+    return _starting ??= _start();
+  }
+
+  Future<Process> _start() async {
+    try {
+      if (!await File(scriptPath).exists()) {
+        throw Exception('Script not found: $scriptPath');
+      }
+
+      final process = await Process.start('python3', [scriptPath]);
+      final rx = BytesBuilder(copy: false);
+      process.stdout.listen((data) {
+        // Replies from a process already given up on are dropped
+        if (identical(_process, process)) _onData(rx, data);
+      });
+      process.stderr
+          .transform(utf8.decoder)
+          .transform(const LineSplitter())
+          .listen((line) => debugPrint('sensor_worker: $line'));
+      // Writes to a process that has just died fail here, not in read()
+      process.stdin.done.then((_) {}, onError: (Object e) {
+        debugPrint('sensor_worker: stdin closed: $e');
+      });
+      process.exitCode.then((code) {
+        if (identical(_process, process)) {
+          debugPrint('sensor_worker exited with code $code');
+          _process = null;
+          final inFlight = _inFlight;
+          if (inFlight != null) {
+            _finish(inFlight);
+            inFlight.fail('Sensor worker exited ($code)');
+          }
+        }
+      });
+
+      _process = process;
+      return process;
+    } finally {
+      _starting = null;
+    }
+  }
+
+  void _onData(BytesBuilder rx, List<int> data) {
+    rx.add(data);
+    var bytes = rx.takeBytes();
+    var offset = 0;
+
+    while (bytes.length - offset >= _responseHeaderSize) {
+      final view = ByteData.sublistView(bytes, offset);
+      if (view.getUint8(0) != _magic0 || view.getUint8(1) != _magic1) {
+        // Out of sync; nothing to recover from but a restart
+        debugPrint('sensor_worker: bad frame, restarting');
+        _process?.kill();
+        return;
+      }
+      final id = view.getUint16(2, Endian.little);
+      final status = view.getUint8(4);
+      final length = view.getUint16(5, Endian.little);
+      if (bytes.length - offset < _responseHeaderSize + length) break;
+
+      final payload = ByteData.sublistView(
+          bytes, offset + _responseHeaderSize, offset + _responseHeaderSize + length);
+      offset += _responseHeaderSize + length;
+
+      final request = _inFlight;
+      if (request == null || request.id != id) continue;
+      _finish(request);
+      if (status == 0 && length == 8) {
+        request.completer.complete(payload.getFloat64(0, Endian.little));
+      } else {
+        request.fail(utf8.decode(
+            payload.buffer.asUint8List(payload.offsetInBytes, payload.lengthInBytes),
+            allowMalformed: true));
+      }
+    }
+
+    if (offset < bytes.length) rx.add(Uint8List.sublistView(bytes, offset));
+  }
+}
+
+class _WorkerRequest {
+  final int id;
+  final List<int> frame;
+  final Duration timeout;
+  final String label;
+  final Completer<double> completer = Completer();
+  Timer? timer;
+
+  _WorkerRequest(this.id, this.frame, this.timeout, this.label);
+
+  void fail(String message) => completer.completeError(Exception(message));
+}
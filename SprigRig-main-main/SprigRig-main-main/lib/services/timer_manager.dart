@@ -4,6 +4,7 @@ import '../models/timer.dart';
 import '../services/database_helper.dart';
 import '../services/hardware_service.dart';
 import '../services/astral_service.dart';
+import '../services/job_scheduler.dart';
 
 /// TimerManager handles all timer-related operations in a separate isolate.
 /// This ensures timers continue to function properly even when the UI is busy.
@@ -182,19 +183,24 @@ class TimerManager {
 }
 
 /// Timer manager implementation that runs in the isolate
+/// Each timer's next run is registered with the isolate's [JobScheduler]
+/// at its exact time, and re-registered after it runs or the timers are
+/// refreshed.
 class _IsolateTimerManager {
   final SendPort _sendPort;
 
+  // A run that couldn't start or failed is retried after this long
+  static const Duration _retryDelay = Duration(seconds: 10);
+
   // Services
   final DatabaseHelper _db = DatabaseHelper();
   final HardwareService _hardware = HardwareService.instance;
   final AstralService _astral = AstralService.instance;
+  final JobScheduler _jobs = JobScheduler.instance;
 
-  // State
   // State
   final List<_ActiveTimer> _activeTimers = [];
   final List<int> _activeZones = [];
-  Timer? _checkTimer;
 
   // Create a new isolate timer manager
   _IsolateTimerManager(this._sendPort);
@@ -229,13 +235,7 @@ class _IsolateTimerManager {
 
   /// Initialize the timer manager
   Future<void> _initialize() async {
-    // Set up the periodic timer to check for due timers
-    _checkTimer = Timer.periodic(
-      const Duration(seconds: 10),
-      (timer) => _checkTimers(),
-    );
-
-    // Load active timers
+    // Load active timers and schedule their runs
     await _refreshTimers();
 
     // Send an initialization event
@@ -243,8 +243,10 @@ class _IsolateTimerManager {
   }
 
   void dispose() {
-    _checkTimer?.cancel();
-    _checkTimer = null;
+    for (final activeTimer in _activeTimers) {
+      activeTimer.job?.cancel();
+    }
+    _activeTimers.clear();
   }
 
   /// Refresh timers from the database
@@ -254,18 +256,24 @@ class _IsolateTimerManager {
       final timers = await _db.getAllActiveTimers();
 
       // Calculate next execution for each timer
-      for (var timer in timers) {
+      for (int i = 0; i < timers.length; i++) {
+        final timer = timers[i];
         final nextRun = _calculateNextExecution(timer);
         if (nextRun != timer.nextRun) {
           await _db.updateTimerNextRun(timer.id, nextRun);
-          timer = timer.copyWith(nextRun: nextRun);
+          timers[i] = timer.copyWith(nextRun: nextRun);
         }
       }
 
-      // Update the active timers list
+      // Replace the active timers and their scheduled runs
+      for (final activeTimer in _activeTimers) {
+        activeTimer.job?.cancel();
+      }
       _activeTimers.clear();
       for (var timer in timers) {
-        _activeTimers.add(_ActiveTimer(timer: timer));
+        final activeTimer = _ActiveTimer(timer: timer);
+        _activeTimers.add(activeTimer);
+        _arm(activeTimer);
       }
 
       // Send a refresh event
@@ -390,24 +398,31 @@ class _IsolateTimerManager {
     return nextRun.millisecondsSinceEpoch ~/ 1000;
   }
 
-  /// Check for due timers and execute them
-  Future<void> _checkTimers() async {
-    final now = DateTime.now().millisecondsSinceEpoch ~/ 1000;
+  /// Schedule [activeTimer]'s next run (or a retry after [retryIn]),
+  /// replacing any earlier one. Timers dropped by a refresh aren't
+  /// rescheduled.
+  void _arm(_ActiveTimer activeTimer, {Duration? retryIn}) {
+    activeTimer.job?.cancel();
+    activeTimer.job = null;
+    if (!_activeTimers.contains(activeTimer)) return;
 
-    // Find timers that are due
-    final dueTimers = _activeTimers
-        .where(
-          (activeTimer) =>
-              !activeTimer.isRunning &&
-              activeTimer.timer.nextRun != null &&
-              activeTimer.timer.nextRun! <= now,
-        )
-        .toList();
+    final name = 'watering_timer_${activeTimer.timer.id}';
+    Future<void> run() => _executeTimer(activeTimer);
 
-    // Execute each due timer
-    for (var activeTimer in dueTimers) {
-      await _executeTimer(activeTimer);
+    if (retryIn != null) {
+      activeTimer.job = _jobs.after(name, retryIn, run, priority: JobPriority.control);
+      return;
     }
+
+    final nextRun = activeTimer.timer.nextRun;
+    if (nextRun == null) return;
+    // Already due (e.g. missed while stopped): runs straight away
+    activeTimer.job = _jobs.at(
+      name,
+      DateTime.fromMillisecondsSinceEpoch(nextRun * 1000),
+      run,
+      priority: JobPriority.control,
+    );
   }
 
   /// Execute a timer
@@ -415,12 +430,16 @@ class _IsolateTimerManager {
     final timer = activeTimer.timer;
     final startTime = DateTime.now().millisecondsSinceEpoch ~/ 1000;
 
+    if (activeTimer.isRunning) return;
+
     // Check if the zone is already active
     if (_activeZones.contains(timer.zoneId)) {
       _sendEvent(TimerEvent.error('Zone ${timer.zoneId} is already active'));
+      _arm(activeTimer, retryIn: _retryDelay);
       return;
     }
 
+    bool completed = false;
     try {
       // Mark the timer as running
       activeTimer.isRunning = true;
@@ -451,6 +470,7 @@ class _IsolateTimerManager {
 
       // Update the timer in the active timers list
       activeTimer.timer = timer.copyWith(lastRun: startTime, nextRun: nextRun);
+      completed = true;
 
       // Send completion event
       _sendEvent(
@@ -488,6 +508,9 @@ class _IsolateTimerManager {
       // Mark the timer as not running
       activeTimer.isRunning = false;
       _activeZones.remove(timer.zoneId);
+
+      // Next run, or try this one again
+      _arm(activeTimer, retryIn: completed ? null : _retryDelay);
     }
   }
 
@@ -578,6 +601,7 @@ class _IsolateTimerManager {
 class _ActiveTimer {
   WateringTimer timer;
   bool isRunning;
+  ScheduledJob? job; // Next run
 
   _ActiveTimer({required this.timer})
     : isRunning = false; // Move the default value to initializer list
@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""
+Long-lived sensor reader for HardwareService.
+
+Started once by the app and fed requests over stdin; answers on stdout.
+Buses, GPIO handles and calibration data are opened on first use and kept,
+so a reading costs only the sensor's own conversion time instead of an
+interpreter start per value. Driver libraries are imported on first use
+(smbus2 + RPi.bme280, adafruit-circuitpython-dht/-tsl2561/-ads1x15/-bme680/
+-scd4x, RPi.GPIO), so a missing one only fails the sensors that need it.
+
+Frames (little-endian):
+  request:  'S' 'R' | u16 id | u16 length | sensor_type \\0 address \\0 reading_type
+  response: 'S' 'R' | u16 id | u8 status | u16 length | payload
+            status 0: payload is the value as float64
+            status 1: payload is a UTF-8 error message
+"""
+import os
+import struct
+import sys
+import threading
+import time
+
+MAGIC = b'SR'
+REQUEST_HEADER = struct.Struct('<2sHH')
+RESPONSE_HEADER = struct.Struct('<2sHBH')
+STATUS_OK = 0
+STATUS_ERROR = 1
+
+
+class SensorError(Exception):
+    pass
+
+
+def parse_i2c(address, default):
+    """'0x76', '0x48:2' -> (addr, channel); empty -> default"""
+    if not address:
+        return default, 0
+    addr, _, channel = address.partition(':')
+    return int(addr, 0), int(channel or 0)
+
+
+class PulseCounter:
+    """Counts falling edges on a GPIO from RPi.GPIO's event thread"""
+
+    MIN_WINDOW = 1.0  # s; a shorter window is mostly quantisation
+
+    def __init__(self, pin):
+        import RPi.GPIO as GPIO
+        GPIO.setmode(GPIO.BCM)
+        GPIO.setup(pin, GPIO.IN, pull_up_down=GPIO.PUD_UP)
+        self._lock = threading.Lock()
+        self._count = 0
+        self._since = time.monotonic()
+        GPIO.add_event_detect(pin, GPIO.FALLING, callback=self._pulse)
+
+    def _pulse(self, _channel):
+        with self._lock:
+            self._count += 1
+
+    def rate(self):
+        """Pulses per second since the previous call"""
+        wait = self.MIN_WINDOW - (time.monotonic() - self._since)
+        if wait > 0:
+            time.sleep(wait)
+        with self._lock:
+            now = time.monotonic()
+            count, self._count = self._count, 0
+            elapsed, self._since = now - self._since, now
+        return count / elapsed
+
+
+class Drivers:
+    """Sensor drivers with their open handles, reused across requests"""
+
+    def __init__(self):
+        self._handles = {}
+
+    def _handle(self, key, factory):
+        handle = self._handles.get(key)
+        if handle is None:
+            handle = self._handles[key] = factory()
+        return handle
+
+    def _i2c_bus(self):
+        def factory():
+            from smbus2 import SMBus
+            return SMBus(1)
+        return self._handle(('smbus', 1), factory)
+
+    def _board_i2c(self):
+        def factory():
+            import board
+            import busio
+            return busio.I2C(board.SCL, board.SDA)
+        return self._handle(('busio', 1), factory)
+
+    def read(self, sensor_type, address, reading_type):
+        handler = getattr(self, 'read_' + sensor_type, None)
+        if handler is None:
+            raise SensorError(f'Unsupported sensor type: {sensor_type}')
+        return float(handler(address, reading_type))
+
+    # --- Drivers ---
+
+    def read_dht22(self, address, reading_type):
+        # address: GPIO number (BCM), e.g. '4'
+        def factory():
+            import adafruit_dht
+            import board
+            return adafruit_dht.DHT22(getattr(board, f'D{int(address or 4)}'), use_pulseio=False)
+        sensor = self._handle(('dht22', address), factory)
+
+        # The DHT22 misses frames routinely; a couple of retries is normal
+        for attempt in range(3):
+            try:
+                value = sensor.temperature if reading_type == 'temperature' else sensor.humidity
+                if value is not None:
+                    return value
+            except RuntimeError:
+                pass
+            time.sleep(2.0)
+        raise SensorError('DHT22 read failed')
+
+    def read_bme280(self, address, reading_type):
+        import bme280
+        bus = self._i2c_bus()
+        addr, _ = parse_i2c(address, 0x76)
+        calibration = self._handle(('bme280', addr), lambda: bme280.load_calibration_params(bus, addr))
+        sample = bme280.sample(bus, addr, calibration)
+        if reading_type == 'humidity':
+            return sample.humidity
+        if reading_type == 'pressure':
+            return sample.pressure
+        return sample.temperature
+
+    def read_tsl2561(self, address, reading_type):
+        def factory():
+            import adafruit_tsl2561
+            addr, _ = parse_i2c(address, 0x39)
+            return adafruit_tsl2561.TSL2561(self._board_i2c(), address=addr)
+        lux = self._handle(('tsl2561', address), factory).lux
+        if lux is None:
+            raise SensorError('TSL2561 saturated')
+        return lux
+
+    read_light_sensor = read_tsl2561
+
+    def read_bme680(self, address, reading_type):
+        def factory():
+            import adafruit_bme680
+            addr, _ = parse_i2c(address, 0x77)
+            return adafruit_bme680.Adafruit_BME680_I2C(self._board_i2c(), address=addr)
+        sensor = self._handle(('bme680', address), factory)
+        if reading_type == 'humidity':
+            return sensor.relative_humidity
+        if reading_type == 'pressure':
+            return sensor.pressure
+        if reading_type == 'gas':
+            return sensor.gas
+        return sensor.temperature
+
+    def read_co2_sensor(self, address, reading_type):
+        # SCD4x on I2C; it measures every 5 s on its own, so the newest
+        # sample is kept and returned until the next one is ready
+        def factory():
+            import adafruit_scd4x
+            addr, _ = parse_i2c(address, 0x62)
+            sensor = adafruit_scd4x.SCD4X(self._board_i2c(), address=addr)
+            sensor.start_periodic_measurement()
+            return {'sensor': sensor, 'sample': None}
+        state = self._handle(('scd4x', address), factory)
+        sensor = state['sensor']
+
+        # First sample takes one measurement period
+        deadline = time.monotonic() + 6.0
+        while True:
+            if sensor.data_ready:
+                state['sample'] = (sensor.CO2, sensor.temperature, sensor.relative_humidity)
+                break
+            if state['sample'] is not None:
+                break
+            if time.monotonic() > deadline:
+                raise SensorError('SCD4x: no measurement')
+            time.sleep(0.2)
+
+        co2, temperature, humidity = state['sample']
+        if reading_type == 'temperature':
+            return temperature
+        if reading_type == 'humidity':
+            return humidity
+        return co2
+
+    def read_flow_rate(self, address, reading_type):
+        # address: GPIO number (BCM) of the flow meter's pulse output;
+        # returns pulses per second (the meter's K factor is the sensor's
+        # scale factor in the app)
+        if not address:
+            raise SensorError('Flow meter needs a GPIO number')
+        counter = self._handle(('flow', address), lambda: PulseCounter(int(address)))
+        return counter.rate()
+
+    def read_ads1115(self, address, reading_type):
+        # address: '0x48:<channel 0-3>'; returns volts
+        addr, channel = parse_i2c(address, 0x48)
+
+        def factory():
+            import adafruit_ads1x15.ads1115 as ADS
+            return ADS.ADS1115(self._board_i2c(), address=addr)
+        ads = self._handle(('ads1115', addr), factory)
+
+        def channel_factory():
+            from adafruit_ads1x15.analog_in import AnalogIn
+            return AnalogIn(ads, channel)
+        return self._handle(('ads1115', addr, channel), channel_factory).voltage
+
+    # Analog probes wired through an ADS1115; scaling is the sensor's
+    # calibration (scale factor / offset) applied by the app
+    read_ph_sensor = read_ads1115
+    read_ec_sensor = read_ads1115
+    read_pressure_sensor = read_ads1115
+    read_water_level = read_ads1115
+    read_soil_moisture = read_ads1115
+
+    def read_ds18b20(self, address, reading_type):
+        # address: 1-Wire ID, e.g. '28-0316a2791aff'
+        path = f'/sys/bus/w1/devices/{address}/w1_slave'
+        try:
+            with open(path) as f:
+                lines = f.read().splitlines()
+        except OSError as e:
+            raise SensorError(f'DS18B20 {address}: {e}')
+        if len(lines) < 2 or not lines[0].endswith('YES'):
+            raise SensorError(f'DS18B20 {address}: CRC error')
+        return int(lines[1].rsplit('t=', 1)[1]) / 1000.0
+
+
+def read_exact(stream, count):
+    data = b''
+    while len(data) < count:
+        chunk = stream.read(count - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def send(stream, request_id, status, payload):
+    stream.write(RESPONSE_HEADER.pack(MAGIC, request_id, status, len(payload)) + payload)
+    stream.flush()
+
+
+def main(stdout):
+    stdin = sys.stdin.buffer
+    drivers = Drivers()
+
+    while True:
+        header = read_exact(stdin, REQUEST_HEADER.size)
+        if header is None:
+            return 0  # App closed the pipe
+        magic, request_id, length = REQUEST_HEADER.unpack(header)
+        if magic != MAGIC:
+            sys.stderr.write('sensor_worker: lost frame sync\n')
+            return 1
+
+        payload = read_exact(stdin, length)
+        if payload is None:
+            return 0
+
+        try:
+            sensor_type, address, reading_type = payload.decode('utf-8').split('\0')
+            value = drivers.read(sensor_type, address, reading_type)
+            send(stdout, request_id, STATUS_OK, struct.pack('<d', value))
+        except Exception as e:
+            send(stdout, request_id, STATUS_ERROR, str(e).encode('utf-8'))
+
+
+if __name__ == '__main__':
+    # Keep the protocol on a private copy of stdout and point fd 1 at
+    # stderr, so driver libraries that print can't corrupt a frame
+    protocol_out = os.fdopen(os.dup(1), 'wb')
+    os.dup2(2, 1)
+    sys.exit(main(protocol_out))
@@ -4,6 +4,19 @@ import 'package:sprigrig/services/database_helper.dart';
 import 'package:sprigrig/models/recipe_template.dart';
 import 'package:sprigrig/models/recipe_phase.dart';
 import 'package:sprigrig/models/zone_crop.dart';
+import 'package:sprigrig/models/sensor.dart';
+
+// Tuesday 9 June 2026, 00:00 UTC (day and hour aligned)
+const int _day0 = 1780963200;
+const int _hour = 3600;
+const int _day = 86400;
+
+List<SensorReading> _readings(int sensorId, List<(int, double)> samples) {
+  return [
+    for (final (timestamp, value) in samples)
+      SensorReading(id: 0, sensorId: sensorId, readingType: 'temperature', value: value, timestamp: timestamp),
+  ];
+}
 
 void main() {
   // Initialize ffi loader
@@ -95,4 +108,178 @@ void main() {
       expect(retrievedCrop!['crop_name'], 'Test Crop');
     });
   });
+
+  group('Sensor Reading Rollup Tests', () {
+    late DatabaseHelper dbHelper;
+
+    setUp(() async {
+      databaseFactory = databaseFactoryFfi;
+      await databaseFactory.deleteDatabase(await DatabaseHelper().databasePath);
+      dbHelper = DatabaseHelper();
+    });
+
+    tearDown(() async {
+      await dbHelper.close();
+    });
+
+    Future<int> createSensor() async {
+      final db = await dbHelper.database;
+      final now = DateTime.now().millisecondsSinceEpoch ~/ 1000;
+      final zoneId = await db.insert('zones', {'name': 'Test Zone', 'created_at': now, 'updated_at': now});
+      return db.insert('sensors', {
+        'zone_id': zoneId,
+        'sensor_type': 'bme280',
+        'name': 'Test Sensor',
+        'created_at': now,
+        'updated_at': now,
+      });
+    }
+
+    Future<List<Map<String, dynamic>>> rollups(String table, String column, int sensorId,
+        {String type = 'temperature'}) async {
+      final db = await dbHelper.database;
+      return db.query(table,
+          where: 'sensor_id = ? AND reading_type = ?', whereArgs: [sensorId, type], orderBy: column);
+    }
+
+    /// (bucket, min, max, count) of each row; averages are checked with closeTo
+    List<(Object?, Object?, Object?, Object?)> summary(List<Map<String, dynamic>> rows, String column) {
+      return [for (final r in rows) (r[column], r['min_value'], r['max_value'], r['sample_count'])];
+    }
+
+    test('Batch insert spans several chunks', () async {
+      final sensorId = await createSensor();
+
+      // 450 rows = chunks of 200, 200 and 50; one every 10 s, across two hours
+      await dbHelper.insertSensorReadings(
+          _readings(sensorId, [for (int i = 0; i < 450; i++) (_day0 + i * 10, i.toDouble())]));
+
+      final db = await dbHelper.database;
+      final raw = await db.rawQuery(
+          'SELECT COUNT(*) AS n, SUM(value) AS total FROM sensor_readings WHERE sensor_id = ?', [sensorId]);
+      expect(raw.first['n'], 450);
+      expect(raw.first['total'], 449 * 450 / 2);
+
+      final hourly = await rollups('sensor_readings_hourly', 'hour_timestamp', sensorId);
+      expect(summary(hourly, 'hour_timestamp'), [
+        (_day0, 0.0, 359.0, 360),
+        (_day0 + _hour, 360.0, 449.0, 90),
+      ]);
+      expect(hourly[0]['avg_value'], closeTo(179.5, 1e-9));
+      expect(hourly[1]['avg_value'], closeTo(404.5, 1e-9));
+
+      final daily = await rollups('sensor_readings_daily', 'day_timestamp', sensorId);
+      expect(summary(daily, 'day_timestamp'), [(_day0, 0.0, 449.0, 450)]);
+      expect(daily[0]['avg_value'], closeTo(224.5, 1e-9));
+    });
+
+    test('Flushes in the same hour merge into one rollup row', () async {
+      final sensorId = await createSensor();
+
+      await dbHelper.insertSensorReadings(
+          _readings(sensorId, [(_day0 + 100, 10.0), (_day0 + 200, 20.0), (_day0 + 300, 30.0)]));
+      await dbHelper.insertSensorReadings(_readings(sensorId, [(_day0 + 400, 60.0)]));
+
+      // Weighted by sample count: (10 + 20 + 30 + 60) / 4, not (20 + 60) / 2
+      for (final (table, column) in [
+        ('sensor_readings_hourly', 'hour_timestamp'),
+        ('sensor_readings_daily', 'day_timestamp'),
+      ]) {
+        final rows = await rollups(table, column, sensorId);
+        expect(summary(rows, column), [(_day0, 10.0, 60.0, 4)], reason: table);
+        expect(rows.single['avg_value'], closeTo(30.0, 1e-9), reason: table);
+      }
+    });
+
+    test('Version 44 upgrade rebuilds rollups from raw readings', () async {
+      // A version 43 database with readings but no rollup tables
+      final old = await databaseFactory.openDatabase(await dbHelper.databasePath,
+          options: OpenDatabaseOptions(
+            version: 43,
+            onCreate: (db, version) async {
+              await db.execute('CREATE TABLE sensors (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT)');
+              await db.execute('''
+                CREATE TABLE sensor_readings (
+                  id INTEGER PRIMARY KEY AUTOINCREMENT,
+                  sensor_id INTEGER NOT NULL,
+                  reading_type TEXT NOT NULL,
+                  value REAL NOT NULL,
+                  timestamp INTEGER NOT NULL,
+                  FOREIGN KEY (sensor_id) REFERENCES sensors (id)
+                )
+              ''');
+            },
+          ));
+      final sensorId = await old.insert('sensors', {'name': 'Old Sensor'});
+      for (final (timestamp, type, value) in [
+        (_day0 + 10, 'temperature', 1.0),
+        (_day0 + 20, 'temperature', 3.0),
+        (_day0 + 30, 'humidity', 50.0),
+        (_day0 + _hour + 100, 'temperature', 5.0),
+        (_day0 + _day + 5, 'temperature', 7.0),
+      ]) {
+        await old.insert('sensor_readings',
+            {'sensor_id': sensorId, 'reading_type': type, 'value': value, 'timestamp': timestamp});
+      }
+      await old.close();
+
+      final hourly = await rollups('sensor_readings_hourly', 'hour_timestamp', sensorId);
+      expect(summary(hourly, 'hour_timestamp'), [
+        (_day0, 1.0, 3.0, 2),
+        (_day0 + _hour, 5.0, 5.0, 1),
+        (_day0 + _day, 7.0, 7.0, 1),
+      ]);
+      expect(hourly.map((r) => r['avg_value']).toList(), [2.0, 5.0, 7.0]);
+
+      final daily = await rollups('sensor_readings_daily', 'day_timestamp', sensorId);
+      expect(summary(daily, 'day_timestamp'), [
+        (_day0, 1.0, 5.0, 3),
+        (_day0 + _day, 7.0, 7.0, 1),
+      ]);
+      expect(daily.map((r) => r['avg_value']).toList(), [3.0, 7.0]);
+
+      final humidity = await rollups('sensor_readings_hourly', 'hour_timestamp', sensorId, type: 'humidity');
+      expect(summary(humidity, 'hour_timestamp'), [(_day0, 50.0, 50.0, 1)]);
+    });
+
+    test('Series reads raw, hourly or daily data by span and point count', () async {
+      final sensorId = await createSensor();
+
+      // One reading every 10 minutes for two days
+      await dbHelper.insertSensorReadings(
+          _readings(sensorId, [for (int i = 0; i < 288; i++) (_day0 + i * 600, 1.0)]));
+
+      // Mark each rollup level so the series shows which table it came from
+      final db = await dbHelper.database;
+      await db.update('sensor_readings_hourly', {'avg_value': 100.0});
+      await db.update('sensor_readings_daily', {'avg_value': 200.0});
+
+      // 5-minute buckets are finer than an hour: raw readings
+      final raw = await dbHelper.getSensorSeries(sensorId, 'temperature',
+          startTime: _day0, endTime: _day0 + _day, points: 288);
+      expect(raw, hasLength(145));
+      expect(raw.every((p) => p.avgValue == 1.0 && p.sampleCount == 1), isTrue);
+
+      // Hour buckets: hourly rollups
+      final day = await dbHelper.getSensorSeries(sensorId, 'temperature',
+          startTime: _day0, endTime: _day0 + _day, points: 24);
+      expect(day, hasLength(25));
+      expect(day.every((p) => p.avgValue == 100.0 && p.sampleCount == 6), isTrue);
+
+      // 2.4-hour buckets: hourly rollups regrouped to 2 hours
+      final week = await dbHelper.getSensorSeries(sensorId, 'temperature',
+          startTime: _day0 - 5 * _day, endTime: _day0 + 2 * _day, points: 70);
+      expect(week, hasLength(24));
+      expect(week.every((p) => p.avgValue == 100.0 && p.sampleCount == 12 && p.timestamp % (2 * _hour) == 0),
+          isTrue);
+
+      // Day buckets: daily rollups, with the start floored to the day
+      final month = await dbHelper.getSensorSeries(sensorId, 'temperature',
+          startTime: _day0 - 28 * _day + 500, endTime: _day0 + 2 * _day + 500, points: 30);
+      expect([for (final p in month) (p.timestamp, p.avgValue, p.sampleCount)], [
+        (_day0, 200.0, 144),
+        (_day0 + _day, 200.0, 144),
+      ]);
+    });
+  });
 }
@@ -0,0 +1,209 @@
+import 'dart:math';
+import 'package:fake_async/fake_async.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:sprigrig/services/job_scheduler.dart';
+
+/// Scheduler on the fake clock; [sleep] moves the clock without firing
+/// timers, like a suspended process
+class _Harness {
+  final FakeAsync async;
+  int _sleptUs = 0;
+  late final JobScheduler scheduler = JobScheduler.withClock(() => nowUs);
+
+  _Harness(this.async);
+
+  int get nowUs => async.elapsed.inMicroseconds + _sleptUs;
+
+  void sleep(Duration duration) => _sleptUs += duration.inMicroseconds;
+}
+
+void main() {
+  group('JobScheduler Tests', () {
+    test('One-shot jobs run at their deadline across level boundaries', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        final fired = <int, int>{};
+
+        // 10 ms ticks: level 1 starts at tick 64, level 2 at 4096, level 3 at 262144
+        const deadlinesMs = [10, 630, 640, 650, 40950, 40960, 41000, 2621430, 2621440, 2700000];
+        for (final ms in deadlinesMs) {
+          h.scheduler.after('t$ms', Duration(milliseconds: ms), () {
+            fired[ms] = h.nowUs;
+          });
+        }
+
+        async.elapse(const Duration(hours: 1));
+
+        for (final ms in deadlinesMs) {
+          expect(fired[ms], ms * 1000, reason: 'deadline $ms ms');
+        }
+        expect(h.scheduler.jobCount, 0);
+      });
+    });
+
+    test('Deadlines hold when the cursor is not slot aligned', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+
+        // Move the cursor to tick 123 so slot edges don't line up with zero
+        h.scheduler.after('offset', const Duration(milliseconds: 1237), () {});
+        async.elapse(const Duration(milliseconds: 1237));
+
+        final random = Random(7);
+        final deadlines = <int>[];
+        final fired = <int>[];
+        for (int i = 0; i < 300; i++) {
+          final delayMs = 1 + random.nextInt(const Duration(hours: 3).inMilliseconds);
+          final index = i;
+          deadlines.add(h.nowUs + delayMs * 1000);
+          fired.add(-1);
+          h.scheduler.after('job$i', Duration(milliseconds: delayMs), () {
+            fired[index] = h.nowUs;
+          });
+        }
+
+        async.elapse(const Duration(hours: 3, seconds: 1));
+
+        expect(fired, deadlines);
+      });
+    });
+
+    test('Periodic job keeps its cadence', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        var runs = 0;
+
+        final job = h.scheduler.every('poll', const Duration(milliseconds: 100), () {
+          runs++;
+        });
+        async.elapse(const Duration(milliseconds: 1050));
+
+        expect(runs, 10);
+        expect(job.stats.runs, 10);
+        expect(job.stats.maxLateUs, 0);
+      });
+    });
+
+    test('Long sleep runs overdue jobs once and realigns periodic ones', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        var runs = 0;
+        final fired = <Duration, int>{};
+        const tenMinutes = Duration(minutes: 10);
+        const twoHours = Duration(hours: 2);
+        const fiveHours = Duration(hours: 5);
+
+        final poll = h.scheduler.every('poll', const Duration(seconds: 1), () {
+          runs++;
+        });
+        for (final delay in const [tenMinutes, twoHours, fiveHours]) {
+          h.scheduler.after('once $delay', delay, () {
+            fired[delay] = h.nowUs;
+          });
+        }
+
+        async.elapse(const Duration(milliseconds: 500));
+        h.sleep(const Duration(hours: 3));
+        async.elapse(const Duration(milliseconds: 500)); // Armed timer fires 3 h late
+
+        final woke = h.nowUs;
+        expect(runs, 1);
+        expect(poll.stats.maxLateUs, const Duration(hours: 3).inMicroseconds);
+        expect(fired[tenMinutes], woke);
+        expect(fired[twoHours], woke);
+        expect(fired.containsKey(fiveHours), isFalse);
+
+        // Next run one interval after the wakeup, not a burst of missed ones
+        async.elapse(const Duration(milliseconds: 999));
+        expect(runs, 1);
+        async.elapse(const Duration(milliseconds: 1));
+        expect(runs, 2);
+
+        // A job filed high in the wheel before the sleep still runs on time
+        async.elapse(const Duration(hours: 2));
+        expect(fired[fiveHours], fiveHours.inMicroseconds);
+      });
+    });
+
+    test('Cancelling the armed job re-arms for the next one', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        final ran = <String>[];
+
+        final first = h.scheduler.after('first', const Duration(milliseconds: 100), () {
+          ran.add('first');
+        });
+        h.scheduler.after('second', const Duration(milliseconds: 300), () {
+          ran.add('second');
+        });
+        first.cancel();
+        expect(first.isActive, isFalse);
+        expect(h.scheduler.jobCount, 1);
+
+        async.elapse(const Duration(milliseconds: 200));
+        expect(ran, isEmpty);
+        expect(h.scheduler.wakeups, 0);
+
+        async.elapse(const Duration(milliseconds: 100));
+        expect(ran, ['second']);
+        expect(h.scheduler.wakeups, 1);
+      });
+    });
+
+    test('Cancelling the only job leaves no timer armed', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+
+        final job = h.scheduler.after('only', const Duration(minutes: 1), () {});
+        expect(async.pendingTimers, hasLength(1));
+
+        job.cancel();
+        expect(async.pendingTimers, isEmpty);
+        expect(h.scheduler.jobCount, 0);
+      });
+    });
+
+    test('Job cancelled by one due at the same time does not run', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        final ran = <String>[];
+
+        final background = h.scheduler.after('background', const Duration(milliseconds: 100), () {
+          ran.add('background');
+        }, priority: JobPriority.background);
+        h.scheduler.after('control', const Duration(milliseconds: 100), () {
+          ran.add('control');
+          background.cancel();
+        }, priority: JobPriority.control);
+
+        async.elapse(const Duration(milliseconds: 200));
+
+        expect(ran, ['control']);
+        expect(h.scheduler.jobCount, 0);
+      });
+    });
+
+    test('Jobs with tolerance share a wakeup', () {
+      fakeAsync((async) {
+        final h = _Harness(async);
+        final fired = <String, int>{};
+
+        for (final entry in {'a': 1200, 'b': 1700}.entries) {
+          h.scheduler.after(entry.key, Duration(milliseconds: entry.value), () {
+            fired[entry.key] = h.nowUs;
+          }, tolerance: const Duration(seconds: 1));
+        }
+        h.scheduler.after('exact', const Duration(milliseconds: 1500), () {
+          fired['exact'] = h.nowUs;
+        });
+
+        async.elapse(const Duration(seconds: 3));
+
+        expect(fired['exact'], 1500000);
+        expect(fired['a'], 2000000);
+        expect(fired['b'], 2000000);
+        expect(h.scheduler.wakeups, 2);
+      });
+    });
+  });
+}
@@ -0,0 +1,152 @@
+import 'package:flutter/material.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:sprigrig/services/schedule_plan.dart';
+
+// Week of Monday 15 June 2026 (no DST change nearby)
+DateTime _at(int day, int hour, [int minute = 0]) => DateTime(2026, 6, day, hour, minute);
+
+final List<bool> _everyDay = List.filled(7, true);
+
+ScheduleWindow _window(int relay, int startHour, int endHour, String name, {List<bool>? days}) {
+  return ScheduleWindow.between(
+    relayIndex: relay,
+    start: TimeOfDay(hour: startHour, minute: 0),
+    end: TimeOfDay(hour: endHour, minute: 0),
+    days: days ?? _everyDay,
+    name: name,
+  );
+}
+
+/// Every edge in the plan as (relay, on, time), walked with nextEvent/eventsAt
+List<(int, bool, DateTime)> _edges(SchedulePlan plan) {
+  final edges = <(int, bool, DateTime)>[];
+  var time = plan.start;
+  for (var next = plan.nextEvent(time); next != null; next = plan.nextEvent(time)) {
+    time = next.time;
+    for (final event in plan.eventsAt(time)) {
+      edges.add((event.relayIndex, event.turnOn, event.time));
+    }
+  }
+  return edges;
+}
+
+void main() {
+  group('SchedulePlan Tests', () {
+    test('Overnight window runs past midnight', () {
+      final plan = SchedulePlan.compile([_window(1, 22, 6, 'Night')], from: _at(15, 12));
+
+      expect(_edges(plan), [
+        (1, true, _at(15, 22)),
+        (1, false, _at(16, 6)),
+        (1, true, _at(16, 22)),
+        (1, false, _at(17, 6)),
+      ]);
+      expect(plan.stateAt(1, _at(15, 12)), isFalse);
+      expect(plan.stateAt(1, _at(15, 21, 59)), isFalse);
+      expect(plan.stateAt(1, _at(15, 22)), isTrue);
+      expect(plan.stateAt(1, _at(16, 0)), isTrue);
+      expect(plan.stateAt(1, _at(16, 5, 59)), isTrue);
+      expect(plan.stateAt(1, _at(16, 6)), isFalse);
+    });
+
+    test('Plan starting inside an overnight window starts on', () {
+      final plan = SchedulePlan.compile([_window(1, 22, 6, 'Night')], from: _at(16, 2));
+
+      expect(plan.stateAt(1, _at(16, 2)), isTrue);
+      final next = plan.nextEvent(_at(16, 2))!;
+      expect((next.relayIndex, next.turnOn, next.time), (1, false, _at(16, 6)));
+    });
+
+    test('Overnight window ends on a day it is not scheduled for', () {
+      final fridayOnly = [false, false, false, false, true, false, false];
+      final plan = SchedulePlan.compile([_window(1, 22, 6, 'Friday night', days: fridayOnly)],
+          from: _at(19, 12));
+
+      expect(_edges(plan), [
+        (1, true, _at(19, 22)),
+        (1, false, _at(20, 6)),
+      ]);
+      expect(plan.stateAt(1, _at(20, 3)), isTrue);
+    });
+
+    test('Overlapping and touching windows merge per relay', () {
+      final plan = SchedulePlan.compile([
+        _window(2, 8, 12, 'A'),
+        _window(2, 10, 14, 'B'),
+        _window(2, 14, 16, 'C'),
+        _window(3, 10, 11, 'D'),
+      ], from: _at(15, 0), horizon: const Duration(hours: 20));
+
+      expect(_edges(plan), [
+        (2, true, _at(15, 8)),
+        (3, true, _at(15, 10)),
+        (3, false, _at(15, 11)),
+        (2, false, _at(15, 16)),
+      ]);
+      expect(plan.stateAt(2, _at(15, 12)), isTrue);
+      expect(plan.stateAt(2, _at(15, 14)), isTrue);
+      expect(plan.stateAt(2, _at(15, 16)), isFalse);
+
+      // Relay 2 is already on at 10:00, so only relay 3 switches
+      final atTen = plan.eventsAt(_at(15, 10));
+      expect(atTen.map((e) => (e.relayIndex, e.turnOn)).toList(), [(3, true)]);
+    });
+
+    test('Overnight window merges with one starting after midnight', () {
+      final plan = SchedulePlan.compile([
+        _window(4, 20, 2, 'Evening'),
+        _window(4, 1, 3, 'Early'),
+      ], from: _at(15, 12), horizon: const Duration(hours: 24));
+
+      expect(_edges(plan), [
+        (4, true, _at(15, 20)),
+        (4, false, _at(16, 3)),
+      ]);
+      expect(plan.stateAt(4, _at(16, 2)), isTrue);
+    });
+
+    test('Edges at the exact plan start and end', () {
+      final lights = _window(5, 8, 9, 'Light');
+      final plan = SchedulePlan.compile([lights], from: _at(15, 8), horizon: const Duration(hours: 24));
+      const ms = Duration(milliseconds: 1);
+
+      // An edge at the start is the initial state, not an event
+      expect(plan.stateAt(5, _at(15, 8)), isTrue);
+      expect(plan.eventsAt(_at(15, 8)), isEmpty);
+      expect(plan.stateAt(5, _at(15, 8).subtract(ms)), isNull);
+
+      // States change at the edge; nextEvent is strictly after its argument
+      expect(plan.stateAt(5, _at(15, 9).subtract(ms)), isTrue);
+      expect(plan.stateAt(5, _at(15, 9)), isFalse);
+      expect(plan.nextEvent(_at(15, 9).subtract(ms))!.time, _at(15, 9));
+      expect(plan.nextEvent(_at(15, 8))!.time, _at(15, 9));
+
+      // An edge at the end is kept
+      final last = plan.nextEvent(_at(15, 9))!;
+      expect((last.relayIndex, last.turnOn, last.time), (5, true, _at(16, 8)));
+      expect(plan.eventsAt(_at(16, 8)), hasLength(1));
+      expect(plan.nextEvent(_at(16, 8)), isNull);
+      expect(plan.stateAt(5, _at(16, 8)), isTrue);
+      expect(plan.stateAt(5, _at(16, 8).add(ms)), isNull);
+
+      // A window ending exactly at the start is over
+      final afterOff = SchedulePlan.compile([lights], from: _at(15, 9));
+      expect(afterOff.stateAt(5, _at(15, 9)), isFalse);
+      expect(afterOff.nextEvent(_at(15, 9))!.time, _at(16, 8));
+    });
+
+    test('Managed relay without windows stays off', () {
+      final plan = SchedulePlan.compile([], relays: [6], from: _at(15, 12));
+
+      expect(plan.relays, [6]);
+      expect(plan.statesAt(_at(15, 12)), {6: false});
+      expect(plan.stateAt(6, _at(15, 12)), isFalse);
+      expect(plan.stateAt(7, _at(15, 12)), isNull);
+      expect(plan.nextEvent(_at(15, 12)), isNull);
+    });
+
+    test('Equal start and end times mean all day', () {
+      expect(_window(1, 6, 6, 'All day').duration, const Duration(hours: 24));
+    });
+  });
+}